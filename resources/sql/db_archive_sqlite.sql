@@ -0,0 +1,28 @@
+PRAGMA %1.auto_vacuum = INCREMENTAL;
+-- !
+CREATE TABLE IF NOT EXISTS %1.Messages (
+  id              INTEGER     PRIMARY KEY,
+  is_read         INTEGER(1)  NOT NULL DEFAULT 1,
+  is_deleted      INTEGER(1)  NOT NULL DEFAULT 0,
+  is_important    INTEGER(1)  NOT NULL DEFAULT 0,
+  feed            TEXT        NOT NULL,
+  feed_id         INTEGER,
+  title           TEXT        NOT NULL,
+  url             TEXT,
+  author          TEXT,
+  date_created    INTEGER     NOT NULL,
+  is_pdeleted     INTEGER(1)  NOT NULL DEFAULT 0,
+  account_id      INTEGER     NOT NULL,
+  custom_id       TEXT,
+  custom_hash     TEXT,
+  identity_hash   INTEGER,
+  contents_hash   INTEGER,
+  contents        TEXT,
+  enclosures      TEXT
+);
+-- !
+CREATE INDEX IF NOT EXISTS %1.MessagesFeed ON Messages (account_id, feed);
+-- !
+CREATE INDEX IF NOT EXISTS %1.MessagesFeedId ON Messages (feed_id);
+-- !
+CREATE VIRTUAL TABLE IF NOT EXISTS %1.MessagesFts USING fts4(title, author, contents);
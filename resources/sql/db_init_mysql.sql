@@ -12,7 +12,7 @@ CREATE TABLE IF NOT EXISTS Information (
   inf_value       TEXT        NOT NULL
 );
 -- !
-INSERT INTO Information VALUES (1, 'schema_version', '8');
+INSERT INTO Information VALUES (1, 'schema_version', '17');
 -- !
 CREATE TABLE IF NOT EXISTS Accounts (
   id              INTEGER     PRIMARY KEY,
@@ -79,6 +79,13 @@ CREATE TABLE IF NOT EXISTS Feeds (
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
 -- !
+DROP TABLE IF EXISTS Icons;
+-- !
+CREATE TABLE IF NOT EXISTS Icons (
+  hash            VARCHAR(40)   PRIMARY KEY,
+  icon            BLOB          NOT NULL
+);
+-- !
 DROP TABLE IF EXISTS Messages;
 -- !
 CREATE TABLE IF NOT EXISTS Messages (
@@ -87,20 +94,101 @@ CREATE TABLE IF NOT EXISTS Messages (
   is_deleted      INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_deleted >= 0 AND is_deleted <= 1),
   is_important    INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_important >= 0 AND is_important <= 1),
   feed            TEXT        NOT NULL,
+  feed_id         INTEGER,
   title           TEXT        NOT NULL CHECK (title != ''),
   url             TEXT,
   author          TEXT,
   date_created    BIGINT      NOT NULL CHECK (date_created != 0),
-  contents        TEXT,
   is_pdeleted     INTEGER(1)  NOT NULL DEFAULT 0 CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1),
-  enclosures      TEXT,
   account_id      INTEGER     NOT NULL,
   custom_id       TEXT,
   custom_hash     TEXT,
+  identity_hash   BIGINT,
+  contents_hash   BIGINT,
+  
+  FOREIGN KEY (account_id) REFERENCES Accounts (id)
+);
+-- !
+CREATE INDEX MessagesIdentity ON Messages (account_id, identity_hash);
+-- !
+CREATE INDEX MessagesFeedId ON Messages (feed_id, is_deleted, is_pdeleted);
+-- !
+CREATE UNIQUE INDEX MessagesCustomId ON Messages (account_id, custom_id(191));
+-- !
+DROP TABLE IF EXISTS MessageBodies;
+-- !
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  contents        TEXT,
+  enclosures      TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
+DROP TABLE IF EXISTS MessageCounters;
+-- !
+CREATE TABLE IF NOT EXISTS MessageCounters (
+  account_id        INTEGER     NOT NULL,
+  feed              VARCHAR(100) NOT NULL,
+  unread_count      INTEGER     NOT NULL DEFAULT 0,
+  total_count       INTEGER     NOT NULL DEFAULT 0,
+  bin_unread_count  INTEGER     NOT NULL DEFAULT 0,
+  bin_total_count   INTEGER     NOT NULL DEFAULT 0,
   
+  PRIMARY KEY (account_id, feed),
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
 -- !
+CREATE TRIGGER MessageCountersInsert AFTER INSERT ON Messages FOR EACH ROW
+BEGIN
+  INSERT IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER MessageCountersDelete AFTER DELETE ON Messages FOR EACH ROW
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER MessageCountersUpdate AFTER UPDATE ON Messages FOR EACH ROW
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+  INSERT IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+DROP TABLE IF EXISTS MessagesFts;
+-- !
+CREATE TABLE IF NOT EXISTS MessagesFts (
+  docid           INTEGER     PRIMARY KEY,
+  title           TEXT,
+  author          TEXT,
+  contents        TEXT,
+  
+  FULLTEXT (title, author, contents),
+  FOREIGN KEY (docid) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
 DROP TABLE IF EXISTS Labels;
 -- !
 CREATE TABLE IF NOT EXISTS Labels (
@@ -6,7 +6,7 @@ CREATE TABLE IF NOT EXISTS Information (
   inf_value       TEXT        NOT NULL
 );
 -- !
-INSERT INTO Information VALUES (1, 'schema_version', '8');
+INSERT INTO Information VALUES (1, 'schema_version', '17');
 -- !
 CREATE TABLE IF NOT EXISTS Accounts (
   id              INTEGER     PRIMARY KEY,
@@ -74,10 +74,17 @@ CREATE TABLE IF NOT EXISTS Feeds (
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
 -- !
+DROP TABLE IF EXISTS Icons;
+-- !
+CREATE TABLE IF NOT EXISTS Icons (
+  hash            TEXT        PRIMARY KEY,
+  icon            BLOB        NOT NULL
+);
+-- !
 DROP TABLE IF EXISTS Messages;
 -- !
 CREATE TABLE IF NOT EXISTS Messages (
-  id              INTEGER     PRIMARY KEY,
+  id              INTEGER     PRIMARY KEY AUTOINCREMENT,
   is_read         INTEGER(1)  NOT NULL CHECK (is_read >= 0 AND is_read <= 1) DEFAULT 0,
   is_deleted      INTEGER(1)  NOT NULL CHECK (is_deleted >= 0 AND is_deleted <= 1) DEFAULT 0,
   is_important    INTEGER(1)  NOT NULL CHECK (is_important >= 0 AND is_important <= 1) DEFAULT 0,
@@ -86,16 +93,92 @@ CREATE TABLE IF NOT EXISTS Messages (
   url             TEXT,
   author          TEXT,
   date_created    INTEGER     NOT NULL CHECK (date_created != 0),
-  contents        TEXT,
   is_pdeleted     INTEGER(1)  NOT NULL CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1) DEFAULT 0,
-  enclosures      TEXT,
   account_id      INTEGER     NOT NULL,
   custom_id       TEXT,
   custom_hash     TEXT,
+  identity_hash   INTEGER,
+  contents_hash   INTEGER,
+  feed_id         INTEGER,
   
   FOREIGN KEY (account_id) REFERENCES Accounts (id)
 );
 -- !
+CREATE INDEX MessagesIdentity ON Messages (account_id, identity_hash);
+-- !
+CREATE INDEX MessagesFeedId ON Messages (feed_id, is_deleted, is_pdeleted);
+-- !
+DROP TABLE IF EXISTS MessageBodies;
+-- !
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  contents        TEXT,
+  enclosures      TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
+-- !
+DROP TABLE IF EXISTS MessageCounters;
+-- !
+CREATE TABLE IF NOT EXISTS MessageCounters (
+  account_id        INTEGER     NOT NULL,
+  feed              TEXT        NOT NULL,
+  unread_count      INTEGER     NOT NULL DEFAULT 0,
+  total_count       INTEGER     NOT NULL DEFAULT 0,
+  bin_unread_count  INTEGER     NOT NULL DEFAULT 0,
+  bin_total_count   INTEGER     NOT NULL DEFAULT 0,
+  
+  PRIMARY KEY (account_id, feed),
+  FOREIGN KEY (account_id) REFERENCES Accounts (id)
+);
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT OR IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersDelete AFTER DELETE ON Messages
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersUpdate AFTER UPDATE OF is_read, is_deleted, is_pdeleted, feed, account_id ON Messages
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+  INSERT OR IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+DROP TABLE IF EXISTS MessagesFts;
+-- !
+CREATE VIRTUAL TABLE MessagesFts USING fts4(title, author, contents);
+-- !
 DROP TABLE IF EXISTS Labels;
 -- !
 CREATE TABLE IF NOT EXISTS Labels (
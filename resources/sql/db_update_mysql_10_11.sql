@@ -0,0 +1,15 @@
+CREATE TABLE IF NOT EXISTS MessagesFts (
+  docid           INTEGER     PRIMARY KEY,
+  title           TEXT,
+  author          TEXT,
+  contents        TEXT,
+  
+  FULLTEXT (title, author, contents),
+  FOREIGN KEY (docid) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
+INSERT INTO MessagesFts (docid, title, author, contents)
+SELECT Messages.id, Messages.title, Messages.author, CASE WHEN MessageBodies.contents LIKE '#rssguard-z1#%' THEN '' ELSE MessageBodies.contents END
+FROM Messages LEFT JOIN MessageBodies ON Messages.id = MessageBodies.message_id;
+-- !
+UPDATE Information SET inf_value = '11' WHERE inf_key = 'schema_version';
@@ -0,0 +1,7 @@
+ALTER TABLE Messages ADD COLUMN identity_hash BIGINT;
+-- !
+ALTER TABLE Messages ADD COLUMN contents_hash BIGINT;
+-- !
+CREATE INDEX MessagesIdentity ON Messages (account_id, identity_hash);
+-- !
+UPDATE Information SET inf_value = '12' WHERE inf_key = 'schema_version';
@@ -0,0 +1,16 @@
+UPDATE Messages SET custom_id = id WHERE custom_id IS NULL OR custom_id = '';
+-- !
+UPDATE Messages m1 INNER JOIN (
+  SELECT MIN(id) AS id, MAX(is_read) AS is_read, MAX(is_important) AS is_important, MIN(is_deleted) AS is_deleted, MIN(is_pdeleted) AS is_pdeleted
+  FROM Messages GROUP BY account_id, LEFT(custom_id, 191) HAVING COUNT(*) > 1
+) m2 ON m1.id = m2.id
+SET m1.is_read = m2.is_read, m1.is_important = m2.is_important, m1.is_deleted = m2.is_deleted, m1.is_pdeleted = m2.is_pdeleted;
+-- !
+DELETE m1 FROM Messages m1 INNER JOIN (
+  SELECT account_id, LEFT(custom_id, 191) AS custom_key, MIN(id) AS id
+  FROM Messages GROUP BY account_id, LEFT(custom_id, 191) HAVING COUNT(*) > 1
+) m2 ON m1.account_id = m2.account_id AND LEFT(m1.custom_id, 191) = m2.custom_key AND m1.id > m2.id;
+-- !
+CREATE UNIQUE INDEX MessagesCustomId ON Messages (account_id, custom_id(191));
+-- !
+UPDATE Information SET inf_value = '13' WHERE inf_key = 'schema_version';
@@ -0,0 +1,14 @@
+CREATE TABLE IF NOT EXISTS Icons (
+  hash            VARCHAR(40)   PRIMARY KEY,
+  icon            BLOB          NOT NULL
+);
+-- !
+INSERT IGNORE INTO Icons (hash, icon) SELECT SHA1(icon), icon FROM Feeds WHERE icon IS NOT NULL;
+-- !
+INSERT IGNORE INTO Icons (hash, icon) SELECT SHA1(icon), icon FROM Categories WHERE icon IS NOT NULL;
+-- !
+UPDATE Feeds SET icon = SHA1(icon) WHERE icon IS NOT NULL;
+-- !
+UPDATE Categories SET icon = SHA1(icon) WHERE icon IS NOT NULL;
+-- !
+UPDATE Information SET inf_value = '14' WHERE inf_key = 'schema_version';
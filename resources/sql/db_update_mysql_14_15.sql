@@ -0,0 +1,7 @@
+ALTER TABLE Messages ADD COLUMN feed_id INTEGER AFTER feed;
+-- !
+UPDATE Messages INNER JOIN Feeds ON Feeds.custom_id = Messages.feed AND Feeds.account_id = Messages.account_id SET Messages.feed_id = Feeds.id;
+-- !
+CREATE INDEX MessagesFeedId ON Messages (feed_id, is_deleted, is_pdeleted);
+-- !
+UPDATE Information SET inf_value = '15' WHERE inf_key = 'schema_version';
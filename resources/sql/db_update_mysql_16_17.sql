@@ -0,0 +1 @@
+UPDATE Information SET inf_value = '17' WHERE inf_key = 'schema_version';
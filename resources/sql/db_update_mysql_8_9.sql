@@ -0,0 +1,18 @@
+CREATE TABLE IF NOT EXISTS MessageBodies (
+  message_id      INTEGER     PRIMARY KEY,
+  contents        TEXT,
+  enclosures      TEXT,
+  
+  FOREIGN KEY (message_id) REFERENCES Messages (id) ON DELETE CASCADE
+);
+-- !
+INSERT INTO MessageBodies (message_id, contents, enclosures)
+SELECT id, contents, enclosures FROM Messages;
+-- !
+ALTER TABLE Messages
+DROP COLUMN contents;
+-- !
+ALTER TABLE Messages
+DROP COLUMN enclosures;
+-- !
+UPDATE Information SET inf_value = '9' WHERE inf_key = 'schema_version';
@@ -0,0 +1,7 @@
+CREATE VIRTUAL TABLE MessagesFts USING fts4(title, author, contents);
+-- !
+INSERT INTO MessagesFts (docid, title, author, contents)
+SELECT Messages.id, Messages.title, Messages.author, CASE WHEN MessageBodies.contents LIKE '#rssguard-z1#%' THEN '' ELSE MessageBodies.contents END
+FROM Messages LEFT JOIN MessageBodies ON Messages.id = MessageBodies.message_id;
+-- !
+UPDATE Information SET inf_value = '11' WHERE inf_key = 'schema_version';
@@ -0,0 +1 @@
+UPDATE Information SET inf_value = '13' WHERE inf_key = 'schema_version';
@@ -0,0 +1,6 @@
+CREATE TABLE IF NOT EXISTS Icons (
+  hash            TEXT        PRIMARY KEY,
+  icon            BLOB        NOT NULL
+);
+-- !
+UPDATE Information SET inf_value = '14' WHERE inf_key = 'schema_version';
@@ -0,0 +1,7 @@
+ALTER TABLE Messages ADD COLUMN feed_id INTEGER;
+-- !
+UPDATE Messages SET feed_id = (SELECT id FROM Feeds WHERE Feeds.custom_id = Messages.feed AND Feeds.account_id = Messages.account_id);
+-- !
+CREATE INDEX MessagesFeedId ON Messages (feed_id, is_deleted, is_pdeleted);
+-- !
+UPDATE Information SET inf_value = '15' WHERE inf_key = 'schema_version';
@@ -0,0 +1,8 @@
+CREATE TRIGGER IF NOT EXISTS MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
+-- !
+DELETE FROM MessageBodies WHERE message_id NOT IN (SELECT id FROM Messages);
+-- !
+UPDATE Information SET inf_value = '16' WHERE inf_key = 'schema_version';
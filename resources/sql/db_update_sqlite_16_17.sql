@@ -0,0 +1,76 @@
+CREATE TABLE MessagesNew (
+  id              INTEGER     PRIMARY KEY AUTOINCREMENT,
+  is_read         INTEGER(1)  NOT NULL CHECK (is_read >= 0 AND is_read <= 1) DEFAULT 0,
+  is_deleted      INTEGER(1)  NOT NULL CHECK (is_deleted >= 0 AND is_deleted <= 1) DEFAULT 0,
+  is_important    INTEGER(1)  NOT NULL CHECK (is_important >= 0 AND is_important <= 1) DEFAULT 0,
+  feed            TEXT        NOT NULL,
+  title           TEXT        NOT NULL CHECK (title != ''),
+  url             TEXT,
+  author          TEXT,
+  date_created    INTEGER     NOT NULL CHECK (date_created != 0),
+  is_pdeleted     INTEGER(1)  NOT NULL CHECK (is_pdeleted >= 0 AND is_pdeleted <= 1) DEFAULT 0,
+  account_id      INTEGER     NOT NULL,
+  custom_id       TEXT,
+  custom_hash     TEXT,
+  identity_hash   INTEGER,
+  contents_hash   INTEGER,
+  feed_id         INTEGER,
+  
+  FOREIGN KEY (account_id) REFERENCES Accounts (id)
+);
+-- !
+INSERT INTO MessagesNew (id, is_read, is_deleted, is_important, feed, title, url, author, date_created, is_pdeleted, account_id, custom_id, custom_hash, identity_hash, contents_hash, feed_id)
+SELECT id, is_read, is_deleted, is_important, feed, title, url, author, date_created, is_pdeleted, account_id, custom_id, custom_hash, identity_hash, contents_hash, feed_id FROM Messages;
+-- !
+DROP TABLE Messages;
+-- !
+ALTER TABLE MessagesNew RENAME TO Messages;
+-- !
+CREATE INDEX MessagesIdentity ON Messages (account_id, identity_hash);
+-- !
+CREATE INDEX MessagesFeedId ON Messages (feed_id, is_deleted, is_pdeleted);
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageBodiesDelete AFTER DELETE ON Messages
+BEGIN
+  DELETE FROM MessageBodies WHERE message_id = OLD.id;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT OR IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersDelete AFTER DELETE ON Messages
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersUpdate AFTER UPDATE OF is_read, is_deleted, is_pdeleted, feed, account_id ON Messages
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+  INSERT OR IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+UPDATE Information SET inf_value = '17' WHERE inf_key = 'schema_version';
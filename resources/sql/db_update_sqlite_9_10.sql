@@ -0,0 +1,57 @@
+CREATE TABLE IF NOT EXISTS MessageCounters (
+  account_id        INTEGER     NOT NULL,
+  feed              TEXT        NOT NULL,
+  unread_count      INTEGER     NOT NULL DEFAULT 0,
+  total_count       INTEGER     NOT NULL DEFAULT 0,
+  bin_unread_count  INTEGER     NOT NULL DEFAULT 0,
+  bin_total_count   INTEGER     NOT NULL DEFAULT 0,
+  
+  PRIMARY KEY (account_id, feed),
+  FOREIGN KEY (account_id) REFERENCES Accounts (id)
+);
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersInsert AFTER INSERT ON Messages
+BEGIN
+  INSERT OR IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersDelete AFTER DELETE ON Messages
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+END;
+-- !
+CREATE TRIGGER IF NOT EXISTS MessageCountersUpdate AFTER UPDATE OF is_read, is_deleted, is_pdeleted, feed, account_id ON Messages
+BEGIN
+  UPDATE MessageCounters SET
+    unread_count = unread_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    total_count = total_count - (OLD.is_deleted = 0 AND OLD.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0 AND OLD.is_read = 0),
+    bin_total_count = bin_total_count - (OLD.is_deleted = 1 AND OLD.is_pdeleted = 0)
+  WHERE account_id = OLD.account_id AND feed = OLD.feed;
+  INSERT OR IGNORE INTO MessageCounters (account_id, feed) VALUES (NEW.account_id, NEW.feed);
+  UPDATE MessageCounters SET
+    unread_count = unread_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    total_count = total_count + (NEW.is_deleted = 0 AND NEW.is_pdeleted = 0),
+    bin_unread_count = bin_unread_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0 AND NEW.is_read = 0),
+    bin_total_count = bin_total_count + (NEW.is_deleted = 1 AND NEW.is_pdeleted = 0)
+  WHERE account_id = NEW.account_id AND feed = NEW.feed;
+END;
+-- !
+INSERT INTO MessageCounters (account_id, feed, unread_count, total_count, bin_unread_count, bin_total_count)
+SELECT account_id, feed,
+       sum(is_deleted = 0 AND is_pdeleted = 0 AND is_read = 0), sum(is_deleted = 0 AND is_pdeleted = 0),
+       sum(is_deleted = 1 AND is_pdeleted = 0 AND is_read = 0), sum(is_deleted = 1 AND is_pdeleted = 0)
+FROM Messages GROUP BY account_id, feed;
+-- !
+UPDATE Information SET inf_value = '10' WHERE inf_key = 'schema_version';
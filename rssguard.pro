@@ -212,6 +212,7 @@ HEADERS +=  src/core/feeddownloader.h \
             src/core/feedsproxymodel.h \
             src/core/message.h \
             src/core/messagesmodel.h \
+            src/core/messagesbulkupdater.h \
             src/core/messagesproxymodel.h \
             src/definitions/definitions.h \
             src/dynamic-shortcuts/dynamicshortcuts.h \
@@ -258,6 +259,9 @@ HEADERS +=  src/core/feeddownloader.h \
             src/miscellaneous/databasecleaner.h \
             src/miscellaneous/databasefactory.h \
             src/miscellaneous/databasequeries.h \
+            src/miscellaneous/databasequerycache.h \
+            src/miscellaneous/messagehtmlcache.h \
+            src/miscellaneous/databasequeryprofiler.h \
             src/miscellaneous/debugging.h \
             src/miscellaneous/iconfactory.h \
             src/miscellaneous/iofactory.h \
@@ -341,6 +345,7 @@ SOURCES +=  src/core/feeddownloader.cpp \
             src/core/feedsproxymodel.cpp \
             src/core/message.cpp \
             src/core/messagesmodel.cpp \
+            src/core/messagesbulkupdater.cpp \
             src/core/messagesproxymodel.cpp \
             src/dynamic-shortcuts/dynamicshortcuts.cpp \
             src/dynamic-shortcuts/dynamicshortcutswidget.cpp \
@@ -387,6 +392,9 @@ SOURCES +=  src/core/feeddownloader.cpp \
             src/miscellaneous/databasecleaner.cpp \
             src/miscellaneous/databasefactory.cpp \
             src/miscellaneous/databasequeries.cpp \
+            src/miscellaneous/databasequerycache.cpp \
+            src/miscellaneous/messagehtmlcache.cpp \
+            src/miscellaneous/databasequeryprofiler.cpp \
             src/miscellaneous/debugging.cpp \
             src/miscellaneous/iconfactory.cpp \
             src/miscellaneous/iofactory.cpp \
@@ -19,9 +19,11 @@
 
 #include "services/abstract/feed.h"
 #include "definitions/definitions.h"
+#include "miscellaneous/databasequerycache.h"
 
 #include <QThread>
 #include <QDebug>
+#include <QCoreApplication>
 #include <QThreadPool>
 #include <QMutexLocker>
 #include <QString>
@@ -77,6 +79,8 @@ void FeedDownloader::updateFeeds(const QList<Feed*> &feeds) {
     m_results.clear();
     m_feedsUpdated = m_feedsUpdating = 0;
 
+    DatabaseQueryCache::resetStatistics();
+
     // Job starts now.
     emit updateStarted();
     updateAvailableFeeds();
@@ -88,6 +92,17 @@ void FeedDownloader::stopRunningUpdate() {
   m_feeds.clear();
 }
 
+void FeedDownloader::finishRunningUpdate() {
+  stopRunningUpdate();
+
+  if (m_feedsUpdating > 0) {
+    // Results of updated feeds are queued for this thread,
+    // they are stored right away because the thread is about to quit.
+    m_threadPool->waitForDone();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+  }
+}
+
 void FeedDownloader::oneFeedUpdateFinished(const QList<Message> &messages, bool error_during_obtaining) {
   QMutexLocker locker(m_mutex);
 
@@ -106,7 +121,9 @@ void FeedDownloader::oneFeedUpdateFinished(const QList<Message> &messages, bool
                      << feed->id() << " in thread: \'"
                      << QThread::currentThreadId() << "\'.";
 
-  int updated_messages = feed->updateMessages(messages, error_during_obtaining);
+  QList<int> inserted_ids;
+  QList<int> updated_ids;
+  int updated_messages = feed->updateMessages(messages, error_during_obtaining, &inserted_ids, &updated_ids);
 
   /*
   QMetaObject::invokeMethod(feed, "updateMessages", Qt::BlockingQueuedConnection,
@@ -118,6 +135,9 @@ void FeedDownloader::oneFeedUpdateFinished(const QList<Message> &messages, bool
     m_results.appendUpdatedFeed(QPair<QString,int>(feed->title(), updated_messages));
   }
 
+  m_results.appendInsertedMessages(inserted_ids);
+  m_results.appendUpdatedMessages(updated_ids);
+
   qDebug("Made progress in feed updates, total feeds count %d/%d (id of feed is %d).", m_feedsUpdated, m_feedsOriginalCount, feed->id());
   emit updateProgress(feed, m_feedsUpdated, m_feedsOriginalCount);
 
@@ -131,6 +151,9 @@ void FeedDownloader::finalizeUpdate() {
 
   m_results.sort();
 
+  // Report how many query preparations were saved during this update cycle.
+  DatabaseQueryCache::logStatistics();
+
   // Update of feeds has finished.
   // NOTE: This means that now "update lock" can be unlocked
   // and feeds can be added/edited/deleted and application
@@ -138,7 +161,8 @@ void FeedDownloader::finalizeUpdate() {
   emit updateFinished(m_results);
 }
 
-FeedDownloadResults::FeedDownloadResults() : m_updatedFeeds(QList<QPair<QString,int> >()) {
+FeedDownloadResults::FeedDownloadResults()
+  : m_updatedFeeds(QList<QPair<QString,int> >()), m_insertedMessages(QList<int>()), m_updatedMessages(QList<int>()) {
 }
 
 QString FeedDownloadResults::overview(int how_many_feeds) const {
@@ -171,6 +195,24 @@ bool FeedDownloadResults::lessThan(const QPair<QString, int> &lhs, const QPair<Q
 
 void FeedDownloadResults::clear() {
   m_updatedFeeds.clear();
+  m_insertedMessages.clear();
+  m_updatedMessages.clear();
+}
+
+QList<int> FeedDownloadResults::insertedMessages() const {
+  return m_insertedMessages;
+}
+
+QList<int> FeedDownloadResults::updatedMessages() const {
+  return m_updatedMessages;
+}
+
+void FeedDownloadResults::appendInsertedMessages(const QList<int> &ids) {
+  m_insertedMessages.append(ids);
+}
+
+void FeedDownloadResults::appendUpdatedMessages(const QList<int> &ids) {
+  m_updatedMessages.append(ids);
 }
 
 QList<QPair<QString,int> > FeedDownloadResults::updatedFeeds() const {
@@ -41,11 +41,20 @@ class FeedDownloadResults {
     void sort();
     void clear();
 
+    // IDs of messages which were inserted or updated during update.
+    QList<int> insertedMessages() const;
+    QList<int> updatedMessages() const;
+
+    void appendInsertedMessages(const QList<int> &ids);
+    void appendUpdatedMessages(const QList<int> &ids);
+
     static bool lessThan(const QPair<QString,int> &lhs, const QPair<QString,int> &rhs);
 
   private:
     // QString represents title if the feed, int represents count of newly downloaded messages.
     QList<QPair<QString,int> > m_updatedFeeds;
+    QList<int> m_insertedMessages;
+    QList<int> m_updatedMessages;
 };
 
 // This class offers means to "update" feeds and "special" categories.
@@ -70,6 +79,11 @@ class FeedDownloader : public QObject {
     // Stops running update.
     void stopRunningUpdate();
 
+    // Stops running update and stores messages of feeds which are
+    // already being updated. Invoked with blocking connection when
+    // application quits, so that caller waits until update finishes.
+    void finishRunningUpdate();
+
   private slots:
     void oneFeedUpdateFinished(const QList<Message> &messages, bool error_during_obtaining);
 
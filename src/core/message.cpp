@@ -89,7 +89,7 @@ Message Message::fromSqlRecord(const QSqlRecord &record, bool *result) {
   message.m_url = record.value(MSG_DB_URL_INDEX).toString();
   message.m_author = record.value(MSG_DB_AUTHOR_INDEX).toString();
   message.m_created = TextFactory::parseDateTime(record.value(MSG_DB_DCREATED_INDEX).value<qint64>());
-  message.m_contents = record.value(MSG_DB_CONTENTS_INDEX).toString();
+  message.m_contents = TextFactory::decompressText(record.value(MSG_DB_CONTENTS_INDEX).toString());
   message.m_enclosures = Enclosures::decodeEnclosuresFromString(record.value(MSG_DB_ENCLOSURES_INDEX).toString());
   message.m_accountId = record.value(MSG_DB_ACCOUNT_ID_INDEX).toInt();
   message.m_customId = record.value(MSG_DB_CUSTOM_ID_INDEX).toString();
@@ -102,6 +102,14 @@ Message Message::fromSqlRecord(const QSqlRecord &record, bool *result) {
   return message;
 }
 
+qint64 Message::identityHash() const {
+  return TextFactory::hashText(m_title + QL1C('\x1f') + m_url + QL1C('\x1f') + m_author);
+}
+
+qint64 Message::contentsHash() const {
+  return TextFactory::hashText(m_contents);
+}
+
 uint qHash(Message key, uint seed) {
   Q_UNUSED(seed)
   return (key.m_accountId * 10000) + key.m_id;
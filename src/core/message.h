@@ -50,6 +50,13 @@ class Message {
     // row from query SELECT * FROM Messages WHERE ....;
     static Message fromSqlRecord(const QSqlRecord &record, bool *result = nullptr);
 
+    // Hash of title, URL and author, which identifies
+    // the message within its feed.
+    qint64 identityHash() const;
+
+    // Hash of message contents, used to detect changes.
+    qint64 contentsHash() const;
+
     QString m_title;
     QString m_url;
     QString m_author;
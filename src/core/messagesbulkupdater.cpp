@@ -0,0 +1,95 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#include "core/messagesbulkupdater.h"
+
+#include "definitions/definitions.h"
+#include "miscellaneous/application.h"
+#include "miscellaneous/databasefactory.h"
+#include "miscellaneous/databasequeries.h"
+
+#include <QThread>
+#include <QDebug>
+#include <QSqlError>
+
+
+MessagesBulkUpdater::MessagesBulkUpdater(QObject *parent) : QObject(parent) {
+}
+
+MessagesBulkUpdater::~MessagesBulkUpdater() {
+  qDebug("Destroying MessagesBulkUpdater instance.");
+}
+
+void MessagesBulkUpdater::performOperation(MessagesBulkUpdater::Operation operation, const QStringList &ids) {
+  qDebug().nospace() << "Performing bulk operation " << operation << " on " << ids.size()
+                     << " messages in thread: \'" << QThread::currentThreadId() << "\'.";
+
+  QSqlDatabase database = qApp->database()->threadConnection();
+  bool result = true;
+
+  emit operationStarted();
+
+  // All chunks are stored in single transaction, so that
+  // failed operation does not leave messages partially changed.
+  if (!database.transaction()) {
+    qWarning("Transaction for bulk operation was not started: '%s'.", qPrintable(database.lastError().text()));
+  }
+
+  for (int i = 0; i < ids.size() && result; i += MESSAGES_BULK_CHUNK_SIZE) {
+    result = executeOperation(database, operation, ids.mid(i, MESSAGES_BULK_CHUNK_SIZE));
+    emit operationProgress(qMin(i + MESSAGES_BULK_CHUNK_SIZE, ids.size()), ids.size());
+  }
+
+  if (result && !database.commit()) {
+    qCritical("Transaction commit for bulk operation failed: '%s'.", qPrintable(database.lastError().text()));
+    result = false;
+  }
+
+  if (!result) {
+    database.rollback();
+  }
+
+  emit operationFinished(result);
+}
+
+void MessagesBulkUpdater::finishOperations() {
+}
+
+bool MessagesBulkUpdater::executeOperation(QSqlDatabase db, MessagesBulkUpdater::Operation operation, const QStringList &ids) {
+  switch (operation) {
+    case MarkRead:
+      return DatabaseQueries::markMessagesReadUnread(db, ids, RootItem::Read);
+
+    case MarkUnread:
+      return DatabaseQueries::markMessagesReadUnread(db, ids, RootItem::Unread);
+
+    case SwitchImportance:
+      return DatabaseQueries::switchMessagesImportance(db, ids);
+
+    case MoveToBin:
+      return DatabaseQueries::deleteOrRestoreMessagesToFromBin(db, ids, true);
+
+    case RestoreFromBin:
+      return DatabaseQueries::deleteOrRestoreMessagesToFromBin(db, ids, false);
+
+    case PermanentlyDelete:
+      return DatabaseQueries::permanentlyDeleteMessages(db, ids);
+
+    default:
+      return false;
+  }
+}
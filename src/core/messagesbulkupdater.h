@@ -0,0 +1,66 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MESSAGESBULKUPDATER_H
+#define MESSAGESBULKUPDATER_H
+
+#include <QObject>
+
+#include <QStringList>
+#include <QSqlDatabase>
+
+
+// Performs operations on large selections of messages
+// in its own thread with its own DB connection.
+class MessagesBulkUpdater : public QObject {
+    Q_OBJECT
+
+  public:
+    enum Operation {
+      MarkRead,
+      MarkUnread,
+      SwitchImportance,
+      MoveToBin,
+      RestoreFromBin,
+      PermanentlyDelete
+    };
+
+    explicit MessagesBulkUpdater(QObject *parent = 0);
+    virtual ~MessagesBulkUpdater();
+
+    // Performs operation on messages with given IDs in calling thread.
+    static bool executeOperation(QSqlDatabase db, Operation operation, const QStringList &ids);
+
+  public slots:
+    // Performs operation on messages with given IDs, IDs
+    // are processed in chunks and progress is reported after each one.
+    void performOperation(MessagesBulkUpdater::Operation operation, const QStringList &ids);
+
+    // Does nothing. Operations are performed in order they were requested,
+    // so caller which invokes this with blocking connection waits until
+    // all previously requested operations are performed.
+    void finishOperations();
+
+  signals:
+    void operationStarted();
+    void operationProgress(int processed, int total);
+    void operationFinished(bool result);
+};
+
+Q_DECLARE_METATYPE(MessagesBulkUpdater::Operation)
+
+#endif // MESSAGESBULKUPDATER_H
@@ -23,16 +23,44 @@
 #include "miscellaneous/databasefactory.h"
 #include "miscellaneous/iconfactory.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/databasequeryprofiler.h"
 #include "services/abstract/serviceroot.h"
 #include "core/messagesmodelcache.h"
 #include "services/abstract/recyclebin.h"
+#include "miscellaneous/feedreader.h"
 
 #include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentRun>
 
 
 MessagesModel::MessagesModel(QObject *parent)
-  : QSqlQueryModel(parent), MessagesModelSqlLayer(),
-    m_cache(new MessagesModelCache(this)), m_messageHighlighter(NoHighlighting), m_customDateFormat(QString()) {
+  : QAbstractTableModel(parent), MessagesModelSqlLayer(),
+    m_cache(new MessagesModelCache(this)), m_messageHighlighter(NoHighlighting), m_rowCount(0),
+    m_pages(QHash<int,QVector<QSqlRecord> >()), m_pageUsage(QList<int>()),
+    m_pageBoundaries(QHash<int,QSqlRecord>()), m_pageDisplays(QHash<int,QVector<RowDisplay> >()),
+    m_messageRows(QHash<int,int>()),
+    m_unreadRows(QVector<quint64>()), m_unreadRowsLoaded(false), m_orderChanged(false),
+    m_customDateFormat(QString()),
+    m_selectedItem(nullptr), m_searchPattern(QString()), m_archiveIncluded(false),
+    m_workerPool(new QThreadPool(this)), m_searchTimer(new QTimer(this)), m_searchWatcher(new QFutureWatcher<QList<int> >(this)),
+    m_searchGeneration(0), m_runningSearchGeneration(0), m_searchPending(false),
+    m_prefetchedMessages(QHash<int,Message>()), m_prefetchWatcher(new QFutureWatcher<QList<Message> >(this)),
+    m_pendingPrefetch(QList<Message>()), m_bulkUpdater(nullptr),
+    m_bulkOperationCallbacks(QQueue<std::function<bool()> >()) {
+  m_workerPool->setMaxThreadCount(MESSAGES_MODEL_MAX_THREADS);
+  m_searchTimer->setSingleShot(true);
+  m_searchTimer->setInterval(MESSAGES_SEARCH_DELAY);
+
+  connect(m_searchTimer, &QTimer::timeout, this, &MessagesModel::startSearch);
+  connect(m_searchWatcher, &QFutureWatcher<QList<int> >::finished, this, &MessagesModel::onSearchFinished);
+  connect(m_prefetchWatcher, &QFutureWatcher<QList<Message> >::finished, this, &MessagesModel::onPrefetchFinished);
+
   setupFonts();
   setupIcons();
   setupHeaderData();
@@ -43,6 +71,11 @@ MessagesModel::MessagesModel(QObject *parent)
 
 MessagesModel::~MessagesModel() {
   qDebug("Destroying MessagesModel instance.");
+
+  // Worker thread must not use DB connection after it gets closed.
+  m_searchWatcher->waitForFinished();
+  m_prefetchWatcher->waitForFinished();
+  qApp->database()->sqliteDetachArchive(m_db, archiveSchema());
 }
 
 void MessagesModel::setupIcons() {
@@ -52,21 +85,405 @@ void MessagesModel::setupIcons() {
 }
 
 void MessagesModel::repopulate() {
-  m_cache->clear();
-  setQuery(selectStatement(), m_db);
+  QSqlQuery q(m_db);
+
+  beginResetModel();
+  clearPages();
+  m_orderChanged = false;
+  q.setForwardOnly(true);
+
+  // Only number of messages is obtained now, messages
+  // themselves are loaded once they are displayed.
+  if (DB_EXEC_SQL(q, countStatement()) && q.next()) {
+    m_rowCount = q.value(0).toInt();
+  }
+  else {
+    qWarning("Counting of messages failed: '%s'.", qPrintable(q.lastError().text()));
+    m_rowCount = 0;
+  }
+
+  m_cache->clear(m_rowCount);
+  endResetModel();
+}
+
+int MessagesModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : m_rowCount;
+}
+
+int MessagesModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : m_headerData.size();
+}
+
+QSqlRecord MessagesModel::record(int row_index) const {
+  if (row_index < 0 || row_index >= m_rowCount) {
+    return QSqlRecord();
+  }
+
+  const int page_index = row_index / MESSAGES_MODEL_PAGE_SIZE;
+  const int page_row = row_index % MESSAGES_MODEL_PAGE_SIZE;
+  const QVector<QSqlRecord> &records = page(page_index);
+  const QSqlRecord message_record = page_row < records.size() ? records.at(page_row) : QSqlRecord();
+
+  // Neighbouring page is loaded in advance when view gets close to it.
+  if (page_row >= MESSAGES_MODEL_PAGE_SIZE - MESSAGES_MODEL_PREFETCH_MARGIN &&
+      (page_index + 1) * MESSAGES_MODEL_PAGE_SIZE < m_rowCount) {
+    page(page_index + 1);
+  }
+  else if (page_row < MESSAGES_MODEL_PREFETCH_MARGIN && page_index > 0) {
+    page(page_index - 1);
+  }
+
+  return message_record;
+}
+
+const QVector<QSqlRecord> &MessagesModel::page(int page_index) const {
+  if (m_pages.contains(page_index)) {
+    m_pageUsage.removeOne(page_index);
+    m_pageUsage.append(page_index);
+  }
+  else {
+    loadPage(page_index);
+  }
+
+  return m_pages[page_index];
+}
+
+void MessagesModel::loadPage(int page_index) const {
+  QElapsedTimer timer;
+  QSqlQuery q(m_db);
+  QVector<QSqlRecord> records;
+  QVariantList values;
+  QString keyset_condition;
+  int offset = page_index * MESSAGES_MODEL_PAGE_SIZE;
+
+  // When preceding page was already loaded, messages following its last message
+  // are selected directly, so that database does not have to skip all of them.
+  if (m_pageBoundaries.contains(page_index - 1)) {
+    keyset_condition = keysetCondition(m_pageBoundaries.value(page_index - 1), values);
+
+    if (!keyset_condition.isEmpty()) {
+      offset = 0;
+    }
+  }
+
+  q.setForwardOnly(true);
+  q.prepare(pageStatement(keyset_condition, MESSAGES_MODEL_PAGE_SIZE, offset));
+
+  foreach (const QVariant &value, values) {
+    q.addBindValue(value);
+  }
+
+  records.reserve(MESSAGES_MODEL_PAGE_SIZE);
+  timer.start();
+
+  if (q.exec()) {
+    while (q.next()) {
+      records.append(q.record());
+    }
+  }
+  else {
+    qWarning("Loading of page %d of messages failed: '%s'.", page_index, qPrintable(q.lastError().text()));
+  }
+
+  DatabaseQueryProfiler::record(q, timer.nsecsElapsed() / 1000, records.size(), Q_FUNC_INFO);
+
+  if (!records.isEmpty()) {
+    m_pageBoundaries.insert(page_index, records.last());
+  }
+
+  // Least recently used pages are dropped, so that memory
+  // stays flat no matter how many messages are listed.
+  while (m_pageUsage.size() >= MESSAGES_MODEL_MAX_PAGES) {
+    const int dropped_page_index = m_pageUsage.takeFirst();
+    const QVector<QSqlRecord> dropped_records = m_pages.take(dropped_page_index);
+
+    m_pageDisplays.remove(dropped_page_index);
+
+    for (int i = 0; i < dropped_records.size(); i++) {
+      const int id = dropped_records.at(i).value(MSG_DB_ID_INDEX).toInt();
+
+      if (m_messageRows.value(id) == dropped_page_index * MESSAGES_MODEL_PAGE_SIZE + i) {
+        m_messageRows.remove(id);
+      }
+    }
+  }
+
+  for (int i = 0; i < records.size(); i++) {
+    m_messageRows.insert(records.at(i).value(MSG_DB_ID_INDEX).toInt(), page_index * MESSAGES_MODEL_PAGE_SIZE + i);
+  }
+
+  m_pages.insert(page_index, records);
+  m_pageUsage.append(page_index);
+}
+
+bool MessagesModel::workerThreadsUsable() const {
+  return qApp->database()->activeDatabaseDriver() != DatabaseFactory::SQLITE_MEMORY;
+}
+
+void MessagesModel::clearPages() {
+  m_pages.clear();
+  m_pageUsage.clear();
+  m_pageBoundaries.clear();
+  m_pageDisplays.clear();
+  m_messageRows.clear();
+  m_unreadRows.clear();
+  m_unreadRowsLoaded = false;
+}
+
+void MessagesModel::reloadChangedOrder() {
+  if (!m_orderChanged || isBulkOperationRunning()) {
+    // Order is not changed or changes are not stored yet.
+    return;
+  }
+
+  emit layoutAboutToBeChanged();
+
+  const QModelIndexList old_indexes = persistentIndexList();
+  QList<int> ids;
+  QHash<int,int> new_rows;
+  QModelIndexList new_indexes;
+
+  foreach (const QModelIndex &old_index, old_indexes) {
+    ids.append(messageId(old_index.row()));
+  }
+
+  // Changed states are already stored, so they are loaded from DB now.
+  clearPages();
+  m_cache->clear(m_rowCount);
+  m_orderChanged = false;
+
+  for (int i = 0; i < old_indexes.size(); i++) {
+    if (!new_rows.contains(ids.at(i))) {
+      new_rows.insert(ids.at(i), rowOfMessage(ids.at(i)));
+    }
+
+    const int new_row = new_rows.value(ids.at(i));
+
+    new_indexes.append(new_row >= 0 ? index(new_row, old_indexes.at(i).column()) : QModelIndex());
+  }
+
+  changePersistentIndexList(old_indexes, new_indexes);
+  emit layoutChanged();
+}
+
+void MessagesModel::loadUnreadRows() const {
+  QSqlQuery q(m_db);
+  int row = 0;
+
+  m_unreadRows.fill(0, (m_rowCount + 63) / 64);
+  m_unreadRowsLoaded = true;
+  q.setForwardOnly(true);
+
+  // Only read states are selected, in the same order as messages.
+  if (!DB_EXEC_SQL(q, columnStatement(MSG_DB_READ_INDEX))) {
+    qWarning("Loading of read states of messages failed: '%s'.", qPrintable(q.lastError().text()));
+    return;
+  }
+
+  while (row < m_rowCount && q.next()) {
+    // States changed in the model might not be stored in DB yet.
+    const bool unread = m_cache->containsData(row, MSG_DB_READ_INDEX) ?
+                        m_cache->data(index(row, MSG_DB_READ_INDEX)).toInt() == 0 :
+                        q.value(0).toInt() == 0;
+
+    setRowUnread(row++, unread);
+  }
+}
+
+void MessagesModel::setRowUnread(int row, bool unread) const {
+  if (unread) {
+    m_unreadRows[row / 64] |= Q_UINT64_C(1) << (row % 64);
+  }
+  else {
+    m_unreadRows[row / 64] &= ~(Q_UINT64_C(1) << (row % 64));
+  }
+}
+
+int MessagesModel::nextUnreadRow(int from_row, int to_row) const {
+  if (!m_unreadRowsLoaded) {
+    loadUnreadRows();
+  }
+
+  from_row = qMax(from_row, 0);
+  to_row = qMin(to_row, m_rowCount - 1);
+
+  if (from_row > to_row) {
+    return -1;
+  }
+
+  // Bitmap is scanned word by word, bits of rows
+  // preceding the first row are masked out.
+  const int last_word_index = to_row / 64;
+  int word_index = from_row / 64;
+  quint64 word = m_unreadRows.at(word_index) & (~Q_UINT64_C(0) << (from_row % 64));
+
+  while (word == 0) {
+    if (++word_index > last_word_index) {
+      return -1;
+    }
+
+    word = m_unreadRows.at(word_index);
+  }
+
+  const int row = word_index * 64 + qCountTrailingZeroBits(word);
+
+  return row <= to_row ? row : -1;
+}
+
+int MessagesModel::loadedRowOfMessage(int id) const {
+  return m_messageRows.value(id, -1);
+}
+
+int MessagesModel::rowOfMessage(int id) const {
+  const int loaded_row = loadedRowOfMessage(id);
+
+  if (loaded_row >= 0) {
+    return loaded_row;
+  }
+
+  QSqlQuery q(m_db);
+
+  q.setForwardOnly(true);
 
-  while (canFetchMore()) {
-    fetchMore();
+  if (DB_EXEC_SQL(q, selectStatement(QString(QSL("Messages.id = %1")).arg(QString::number(id)))) && q.next()) {
+    return rowOfRecord(q.record());
+  }
+  else {
+    return -1;
+  }
+}
+
+int MessagesModel::rowOfRecord(const QSqlRecord &record) const {
+  QSqlQuery q(m_db);
+  QVariantList values;
+  const QString preceding_condition = keysetCondition(record, values, false);
+
+  if (preceding_condition.isEmpty()) {
+    return -1;
+  }
+
+  // Row of message is given by number of messages which precede it.
+  q.setForwardOnly(true);
+  q.prepare(countStatement(preceding_condition));
+
+  foreach (const QVariant &value, values) {
+    q.addBindValue(value);
+  }
+
+  if (DB_EXEC(q) && q.next()) {
+    return q.value(0).toInt();
+  }
+  else {
+    qWarning("Row of message was not obtained: '%s'.", qPrintable(q.lastError().text()));
+    return -1;
   }
 }
 
+bool MessagesModel::sortKeysDiffer(const QSqlRecord &first, const QSqlRecord &second) const {
+  for (int column = 0; column < first.count(); column++) {
+    if (isSortColumn(column) && first.value(column) != second.value(column)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 bool MessagesModel::setData(const QModelIndex &index, const QVariant &value, int role) {
   Q_UNUSED(role)
 
-  m_cache->setData(index, value, record(index.row()));
+  if (!m_cache->setData(index, value)) {
+    return false;
+  }
+
+  if (index.column() == MSG_DB_READ_INDEX && m_unreadRowsLoaded) {
+    setRowUnread(index.row(), value.toInt() == 0);
+  }
+
+  if (isSortColumn(index.column())) {
+    m_orderChanged = true;
+  }
+
+  RowDisplay *display = rowDisplay(index.row());
+
+  if (display != nullptr) {
+    display->m_state = 0;
+  }
+
   return true;
 }
 
+MessagesModel::RowDisplay *MessagesModel::rowDisplay(int row_index) const {
+  const int page_index = row_index / MESSAGES_MODEL_PAGE_SIZE;
+  const int page_row = row_index % MESSAGES_MODEL_PAGE_SIZE;
+  const QHash<int,QVector<QSqlRecord> >::const_iterator records = m_pages.constFind(page_index);
+
+  if (records == m_pages.constEnd() || page_row >= records.value().size()) {
+    return nullptr;
+  }
+
+  QVector<RowDisplay> &displays = m_pageDisplays[page_index];
+
+  if (displays.isEmpty()) {
+    displays.resize(records.value().size());
+  }
+
+  return &displays[page_row];
+}
+
+QString MessagesModel::formattedDate(int row_index) const {
+  RowDisplay *display = rowDisplay(row_index);
+
+  if (display != nullptr && !display->m_date.isNull()) {
+    return display->m_date;
+  }
+
+  const QDateTime date = TextFactory::parseDateTime(record(row_index).value(MSG_DB_DCREATED_INDEX).value<qint64>()).toLocalTime();
+  const QString formatted_date = m_customDateFormat.isEmpty() ?
+                                 date.toString(Qt::DefaultLocaleShortDate) :
+                                 date.toString(m_customDateFormat);
+
+  // Page of row might have been loaded just now.
+  display = rowDisplay(row_index);
+
+  if (display != nullptr) {
+    display->m_date = formatted_date;
+  }
+
+  return formatted_date;
+}
+
+quint8 MessagesModel::rowState(int row_index) const {
+  RowDisplay *display = rowDisplay(row_index);
+
+  if (display != nullptr && display->m_state != 0) {
+    return display->m_state;
+  }
+
+  const bool is_bin = qobject_cast<RecycleBin*>(loadedItem()) != nullptr;
+  quint8 state = RowStateComputed;
+
+  if (data(row_index, MSG_DB_READ_INDEX, Qt::EditRole).toInt() == 1) {
+    state |= RowStateRead;
+  }
+
+  if (data(row_index, MSG_DB_IMPORTANT_INDEX, Qt::EditRole).toInt() == 1) {
+    state |= RowStateImportant;
+  }
+
+  if (data(row_index, is_bin ? MSG_DB_PDELETED_INDEX : MSG_DB_DELETED_INDEX, Qt::EditRole).toBool()) {
+    state |= RowStateDeleted;
+  }
+
+  display = rowDisplay(row_index);
+
+  if (display != nullptr) {
+    display->m_state = state;
+  }
+
+  return state;
+}
+
 
 void MessagesModel::setupFonts() {
   m_normalFont = Application::font("MessagesView");
@@ -97,25 +514,332 @@ void MessagesModel::loadMessages(RootItem *item) {
     }
   }
 
+  applyArchiveInclusion();
+  applySearchPattern();
   repopulate();
 }
 
-bool MessagesModel::setMessageImportantById(int id, RootItem::Importance important) {
-  for (int i = 0; i < rowCount(); i++) {
-    int found_id = data(i, MSG_DB_ID_INDEX, Qt::EditRole).toInt();
+bool MessagesModel::refreshMessages(const QList<int> &inserted_ids, const QList<int> &updated_ids) {
+  // Bodies of updated messages might have been changed.
+  foreach (int id, updated_ids) {
+    m_prefetchedMessages.remove(id);
+  }
+
+  if (m_selectedItem == nullptr || (inserted_ids.isEmpty() && updated_ids.isEmpty())) {
+    return true;
+  }
+
+  QList<int> rows;
+  QList<int> updated_rows;
 
-    if (found_id == id) {
-      bool set = setData(index(i, MSG_DB_IMPORTANT_INDEX), important);
+  if (!updated_ids.isEmpty()) {
+    QSqlQuery q(m_db);
+    QStringList textual_ids;
 
-      if (set) {
-        emit dataChanged(index(i, 0), index(i, MSG_DB_CUSTOM_HASH_INDEX));
+    foreach (int id, updated_ids) {
+      textual_ids.append(QString::number(id));
+    }
+
+    q.setForwardOnly(true);
+
+    // Only messages which belong to the list are interesting.
+    if (!DB_EXEC_SQL(q, selectStatement(QString(QSL("Messages.id IN (%1)")).arg(textual_ids.join(QSL(", ")))))) {
+      qWarning("Loading of updated messages failed: '%s'.", qPrintable(q.lastError().text()));
+      return false;
+    }
+
+    while (q.next()) {
+      const QSqlRecord updated_record = q.record();
+      const int row = loadedRowOfMessage(updated_record.value(MSG_DB_ID_INDEX).toInt());
+
+      // Pages are dropped below, so updated message, which is not loaded,
+      // is displayed in its new row once its page is loaded again.
+      if (row < 0) {
+        continue;
       }
 
-      return set;
+      // Loaded message with new value of sort key might be
+      // moved to another row, whole list is reloaded in that case.
+      if (sortKeysDiffer(m_pages.value(row / MESSAGES_MODEL_PAGE_SIZE).value(row % MESSAGES_MODEL_PAGE_SIZE), updated_record)) {
+        qDebug("Order of messages might be changed by updated message, list will be reloaded.");
+        return false;
+      }
+
+      updated_rows.append(row);
     }
   }
 
-  return false;
+  if (!inserted_ids.isEmpty()) {
+    QSqlQuery q(m_db);
+    QList<QSqlRecord> records;
+    QStringList textual_ids;
+
+    foreach (int id, inserted_ids) {
+      textual_ids.append(QString::number(id));
+    }
+
+    q.setForwardOnly(true);
+
+    // Only messages which belong to the list are interesting.
+    if (!DB_EXEC_SQL(q, selectStatement(QString(QSL("Messages.id IN (%1)")).arg(textual_ids.join(QSL(", ")))))) {
+      qWarning("Loading of inserted messages failed: '%s'.", qPrintable(q.lastError().text()));
+      return false;
+    }
+
+    while (q.next()) {
+      records.append(q.record());
+    }
+
+    if (records.size() > MESSAGES_MODEL_INCREMENTAL_LIMIT) {
+      qDebug("There are %d new messages in the list, it will be reloaded.", records.size());
+      return false;
+    }
+
+    // Rows are ascending because messages are loaded in sort order.
+    foreach (const QSqlRecord &record, records) {
+      const int row = rowOfRecord(record);
+
+      if (row < 0) {
+        return false;
+      }
+
+      rows.append(row);
+    }
+  }
+
+  QSqlQuery count_query(m_db);
+
+  count_query.setForwardOnly(true);
+
+  // Messages, which left the list when they were updated, cannot be removed
+  // from it incrementally, so numbers of messages must match.
+  if (!DB_EXEC_SQL(count_query, countStatement()) || !count_query.next() ||
+      count_query.value(0).toInt() != m_rowCount + rows.size()) {
+    qDebug("Number of messages in the list does not match, it will be reloaded.");
+    return false;
+  }
+
+  // Loaded pages are dropped because rows get shifted, updated
+  // messages are loaded again once they are displayed.
+  clearPages();
+
+  for (int i = 0; i < rows.size(); ) {
+    const int first_row = qMin(rows.at(i), m_rowCount);
+    int last = i;
+
+    // Messages which are next to each other are inserted at once.
+    while (last + 1 < rows.size() && rows.at(last + 1) == rows.at(last) + 1) {
+      last++;
+    }
+
+    const int count = last - i + 1;
+
+    beginInsertRows(QModelIndex(), first_row, first_row + count - 1);
+    m_cache->insertRows(first_row, count);
+    m_rowCount += count;
+    endInsertRows();
+
+    i = last + 1;
+  }
+
+  // States of rows are reloaded from DB too, unless some of them are not stored yet.
+  if (!isBulkOperationRunning()) {
+    m_cache->clear(m_rowCount);
+  }
+
+  foreach (int updated_row, updated_rows) {
+    int row = updated_row;
+
+    // Updated message is shifted by messages inserted before it.
+    foreach (int inserted_row, rows) {
+      if (inserted_row <= row) {
+        row++;
+      }
+    }
+
+    emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+  }
+
+  return true;
+}
+
+void MessagesModel::searchMessages(const QString &pattern) {
+  const QString simplified_pattern = pattern.simplified();
+
+  if (simplified_pattern == m_searchPattern) {
+    return;
+  }
+
+  m_searchPattern = simplified_pattern;
+  m_searchGeneration++;
+
+  if (m_searchPattern.isEmpty() || m_selectedItem == nullptr) {
+    // Clearing of pattern does not need any search, so it is applied right away.
+    m_searchPending = false;
+    m_searchTimer->stop();
+    setSearchFilter(QString());
+    repopulate();
+    emit searchFinished(false);
+  }
+  else {
+    m_searchTimer->start();
+  }
+}
+
+void MessagesModel::startSearch() {
+  if (m_searchWatcher->isRunning()) {
+    // Search for older pattern is still running, new one
+    // is started once it finishes and its results are dropped.
+    m_searchPending = true;
+    return;
+  }
+
+  m_searchPending = false;
+
+  if (m_searchPattern.isEmpty() || m_selectedItem == nullptr) {
+    return;
+  }
+
+  const QString pattern = m_searchPattern;
+  const QString messages_filter = filter();
+  const int account_id = m_selectedItem->getParentServiceRoot()->accountId();
+  const bool archive_included = !archiveSchema().isEmpty();
+
+  m_runningSearchGeneration = m_searchGeneration;
+
+  if (!workerThreadsUsable()) {
+    // NOTE: In-memory database can only be used by this thread, search
+    // is therefore only delayed until pattern stops changing.
+    const bool truncated = applySearchResults(DatabaseQueries::searchMessages(m_db, pattern, messages_filter,
+                                                                              archiveSchema(), MESSAGES_SEARCH_LIMIT + 1));
+
+    repopulate();
+    emit searchFinished(truncated);
+    return;
+  }
+
+  m_searchWatcher->setFuture(QtConcurrent::run(m_workerPool, [pattern, messages_filter, account_id, archive_included] {
+    QSqlDatabase database = qApp->database()->threadConnection();
+    const QString archive_schema = archive_included ?
+                                   qApp->database()->sqliteAttachArchive(database, account_id, false) :
+                                   QString();
+
+    // One more message is searched, so that truncated results can be detected.
+    const QList<int> ids = DatabaseQueries::searchMessages(database, pattern, messages_filter, archive_schema, MESSAGES_SEARCH_LIMIT + 1);
+
+    qApp->database()->sqliteDetachArchive(database, archive_schema);
+    return ids;
+  }));
+}
+
+void MessagesModel::onSearchFinished() {
+  if (m_runningSearchGeneration != m_searchGeneration) {
+    qDebug("Dropping results of stale search of messages.");
+
+    if (m_searchPending) {
+      startSearch();
+    }
+
+    return;
+  }
+
+  const bool truncated = applySearchResults(m_searchWatcher->result());
+
+  repopulate();
+  emit searchFinished(truncated);
+}
+
+void MessagesModel::setArchiveIncluded(bool included) {
+  if (included != m_archiveIncluded) {
+    m_archiveIncluded = included;
+    applyArchiveInclusion();
+    applySearchPattern();
+    repopulate();
+  }
+}
+
+bool MessagesModel::isArchiveIncluded() const {
+  return m_archiveIncluded;
+}
+
+void MessagesModel::applyArchiveInclusion() {
+  const QString old_archive_schema = archiveSchema();
+
+  // New archive is attached before old one is detached, so that
+  // archive of the same account is not reattached.
+  if (m_archiveIncluded && m_selectedItem != nullptr) {
+    setArchiveSchema(qApp->database()->sqliteAttachArchive(m_db, m_selectedItem->getParentServiceRoot()->accountId(), false));
+  }
+  else {
+    setArchiveSchema(QString());
+  }
+
+  qApp->database()->sqliteDetachArchive(m_db, old_archive_schema);
+}
+
+void MessagesModel::applySearchPattern() {
+  // Pending or running searches are superseded by this one.
+  m_searchGeneration++;
+  m_searchPending = false;
+  m_searchTimer->stop();
+
+  if (m_searchPattern.isEmpty() || m_selectedItem == nullptr) {
+    setSearchFilter(QString());
+    return;
+  }
+
+  // Search itself runs in worker thread, list is repopulated once it finishes.
+  applySearchResults(QList<int>());
+  m_searchTimer->start();
+}
+
+bool MessagesModel::applySearchResults(QList<int> ids) {
+  const bool truncated = ids.size() > MESSAGES_SEARCH_LIMIT;
+
+  if (truncated) {
+    ids = ids.mid(0, MESSAGES_SEARCH_LIMIT);
+  }
+
+  // NOTE: Failed search yields no IDs, so that no messages are displayed.
+  if (ids.isEmpty()) {
+    setSearchFilter(QSL(DEFAULT_SQL_MESSAGES_FILTER));
+  }
+  else {
+    QStringList textual_ids;
+
+    foreach (int id, ids) {
+      textual_ids.append(QString::number(id));
+    }
+
+    setSearchFilter(QString(QSL("Messages.id IN (%1)")).arg(textual_ids.join(QSL(", "))));
+  }
+
+  return truncated;
+}
+
+bool MessagesModel::setMessageImportantById(int id, RootItem::Importance important) {
+  // Messages which are not loaded yet get their new state from DB once they are loaded.
+  const int row = loadedRowOfMessage(id);
+
+  if (row < 0) {
+    if (isSortColumn(MSG_DB_IMPORTANT_INDEX)) {
+      m_orderChanged = true;
+      reloadChangedOrder();
+    }
+
+    return false;
+  }
+
+  bool set = setData(index(row, MSG_DB_IMPORTANT_INDEX), important);
+
+  if (set) {
+    emit dataChanged(index(row, 0), index(row, MSG_DB_CUSTOM_HASH_INDEX));
+
+    // Importance is already stored by the caller.
+    reloadChangedOrder();
+  }
+
+  return set;
 }
 
 void MessagesModel::highlightMessages(MessagesModel::MessageHighlighter highlight) {
@@ -143,6 +867,8 @@ void MessagesModel::updateDateFormat() {
   else {
     m_customDateFormat = QString();
   }
+
+  m_pageDisplays.clear();
 }
 
 void MessagesModel::reloadWholeLayout() {
@@ -150,8 +876,112 @@ void MessagesModel::reloadWholeLayout() {
   emit layoutChanged();
 }
 
-Message MessagesModel::messageAt(int row_index) const {   
-  return Message::fromSqlRecord(m_cache->containsData(row_index) ? m_cache->record(row_index) : record(row_index));
+Message MessagesModel::messageAt(int row_index) const {
+  Message message = Message::fromSqlRecord(record(row_index));
+
+  // States changed in the model take precedence over those loaded from DB.
+  message.m_isRead = data(row_index, MSG_DB_READ_INDEX, Qt::EditRole).toBool();
+  message.m_isImportant = data(row_index, MSG_DB_IMPORTANT_INDEX, Qt::EditRole).toBool();
+  return message;
+}
+
+Message MessagesModel::messageIdentityAt(int row_index) const {
+  // Record is looked up only once, only read and importance
+  // states can be changed in the model.
+  const QSqlRecord message_record = record(row_index);
+  Message message;
+
+  message.m_id = message_record.value(MSG_DB_ID_INDEX).toInt();
+  message.m_isRead = (m_cache->containsData(row_index, MSG_DB_READ_INDEX) ?
+                      m_cache->data(index(row_index, MSG_DB_READ_INDEX)) :
+                      message_record.value(MSG_DB_READ_INDEX)).toBool();
+  message.m_isImportant = (m_cache->containsData(row_index, MSG_DB_IMPORTANT_INDEX) ?
+                           m_cache->data(index(row_index, MSG_DB_IMPORTANT_INDEX)) :
+                           message_record.value(MSG_DB_IMPORTANT_INDEX)).toBool();
+  message.m_feedId = message_record.value(MSG_DB_FEED_CUSTOM_ID_INDEX).toString();
+  message.m_accountId = message_record.value(MSG_DB_ACCOUNT_ID_INDEX).toInt();
+  message.m_customId = message_record.value(MSG_DB_CUSTOM_ID_INDEX).toString();
+  message.m_customHash = message_record.value(MSG_DB_CUSTOM_HASH_INDEX).toString();
+
+  return message;
+}
+
+Message MessagesModel::messageWithBodyAt(int row_index) const {
+  Message message = messageAt(row_index);
+  const QHash<int,Message>::const_iterator prefetched = m_prefetchedMessages.constFind(message.m_id);
+
+  if (prefetched != m_prefetchedMessages.constEnd()) {
+    message.m_contents = prefetched.value().m_contents;
+    message.m_enclosures = prefetched.value().m_enclosures;
+  }
+  else {
+    DatabaseQueries::loadMessageBody(m_db, message);
+  }
+
+  return message;
+}
+
+void MessagesModel::prefetchMessages(const QList<int> &row_indexes) {
+  QList<Message> messages;
+
+  foreach (int row_index, row_indexes) {
+    if (row_index >= 0 && row_index < m_rowCount) {
+      const Message message = messageAt(row_index);
+
+      if (!m_prefetchedMessages.contains(message.m_id)) {
+        messages.append(message);
+      }
+    }
+  }
+
+  // Bodies of messages from in-memory database are loaded
+  // quickly enough when messages are displayed.
+  if (messages.isEmpty() || !workerThreadsUsable()) {
+    return;
+  }
+
+  if (m_prefetchWatcher->isRunning()) {
+    // Only the newest request matters, older pending one is dropped.
+    m_pendingPrefetch = messages;
+  }
+  else {
+    startPrefetch(messages);
+  }
+}
+
+void MessagesModel::startPrefetch(const QList<Message> &messages) {
+  m_prefetchWatcher->setFuture(QtConcurrent::run(m_workerPool, [messages] {
+    QSqlDatabase database = qApp->database()->threadConnection();
+    QList<Message> loaded_messages = messages;
+
+    for (int i = 0; i < loaded_messages.size(); i++) {
+      DatabaseQueries::loadMessageBody(database, loaded_messages[i]);
+    }
+
+    return loaded_messages;
+  }));
+}
+
+void MessagesModel::onPrefetchFinished() {
+  const QList<Message> messages = m_prefetchWatcher->result();
+
+  // Only recently prefetched messages are kept.
+  if (m_prefetchedMessages.size() + messages.size() > MESSAGES_PREFETCH_LIMIT) {
+    m_prefetchedMessages.clear();
+  }
+
+  foreach (const Message &message, messages) {
+    m_prefetchedMessages.insert(message.m_id, message);
+  }
+
+  emit messagesPrefetched(messages);
+
+  if (!m_pendingPrefetch.isEmpty()) {
+    const QList<Message> pending_messages = m_pendingPrefetch;
+
+    m_pendingPrefetch.clear();
+    startPrefetch(pending_messages);
+  }
 }
 
 void MessagesModel::setupHeaderData() {
@@ -200,22 +1030,15 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const {
       int index_column = idx.column();
 
       if (index_column == MSG_DB_DCREATED_INDEX) {
-        QDateTime dt = TextFactory::parseDateTime(QSqlQueryModel::data(idx, role).value<qint64>()).toLocalTime();
-
-        if (m_customDateFormat.isEmpty()) {
-          return dt.toString(Qt::DefaultLocaleShortDate);
-        }
-        else {
-          return dt.toString(m_customDateFormat);
-        }
+        return formattedDate(idx.row());
       }
       else if (index_column == MSG_DB_AUTHOR_INDEX) {
-        const QString author_name = QSqlQueryModel::data(idx, role).toString();
+        const QString author_name = record(idx.row()).value(idx.column()).toString();
 
         return author_name.isEmpty() ? QSL("-") : author_name;
       }
       else if (index_column != MSG_DB_IMPORTANT_INDEX && index_column != MSG_DB_READ_INDEX) {
-        return QSqlQueryModel::data(idx, role);
+        return record(idx.row()).value(idx.column());
       }
       else {
         return QVariant();
@@ -223,27 +1046,13 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const {
     }
 
     case Qt::EditRole:
-      return m_cache->containsData(idx.row()) ? m_cache->data(idx) : QSqlQueryModel::data(idx, role);
+      return m_cache->containsData(idx.row(), idx.column()) ? m_cache->data(idx) : record(idx.row()).value(idx.column());
 
     case Qt::FontRole: {
-      QModelIndex idx_read = index(idx.row(), MSG_DB_READ_INDEX);
-      QVariant data_read = data(idx_read, Qt::EditRole);
-
-      const bool is_bin = qobject_cast<RecycleBin*>(loadedItem()) != nullptr;
-      bool is_deleted;
-
-      if (is_bin) {
-        QModelIndex idx_del = index(idx.row(), MSG_DB_PDELETED_INDEX);
-        is_deleted = data(idx_del, Qt::EditRole).toBool();
-      }
-      else {
-        QModelIndex idx_del = index(idx.row(), MSG_DB_DELETED_INDEX);
-        is_deleted = data(idx_del, Qt::EditRole).toBool();
-      }
+      const quint8 state = rowState(idx.row());
+      const bool striked = (state & RowStateDeleted) != 0;
 
-      const bool striked = is_deleted;
-
-      if (data_read.toBool()) {
+      if ((state & RowStateRead) != 0) {
         return striked ? m_normalStrikedFont : m_normalFont;
       }
       else {
@@ -253,19 +1062,11 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const {
 
     case Qt::ForegroundRole:
       switch (m_messageHighlighter) {
-        case HighlightImportant: {
-          QModelIndex idx_important = index(idx.row(), MSG_DB_IMPORTANT_INDEX);
-          QVariant dta = m_cache->containsData(idx_important.row()) ? m_cache->data(idx_important) : QSqlQueryModel::data(idx_important);
-
-          return dta.toInt() == 1 ? QColor(Qt::blue) : QVariant();
-        }
-
-        case HighlightUnread: {
-          QModelIndex idx_read = index(idx.row(), MSG_DB_READ_INDEX);
-          QVariant dta = m_cache->containsData(idx_read.row()) ? m_cache->data(idx_read) : QSqlQueryModel::data(idx_read);
+        case HighlightImportant:
+          return (rowState(idx.row()) & RowStateImportant) != 0 ? QColor(Qt::blue) : QVariant();
 
-          return dta.toInt() == 0 ? QColor(Qt::blue) : QVariant();
-        }
+        case HighlightUnread:
+          return (rowState(idx.row()) & RowStateRead) == 0 ? QColor(Qt::blue) : QVariant();
 
         case NoHighlighting:
         default:
@@ -276,16 +1077,10 @@ QVariant MessagesModel::data(const QModelIndex &idx, int role) const {
       const int index_column = idx.column();
 
       if (index_column == MSG_DB_READ_INDEX) {
-        QModelIndex idx_read = index(idx.row(), MSG_DB_READ_INDEX);
-        QVariant dta = m_cache->containsData(idx_read.row()) ? m_cache->data(idx_read) : QSqlQueryModel::data(idx_read);
-
-        return dta.toInt() == 1 ? m_readIcon : m_unreadIcon;
+        return (rowState(idx.row()) & RowStateRead) != 0 ? m_readIcon : m_unreadIcon;
       }
       else if (index_column == MSG_DB_IMPORTANT_INDEX) {
-        QModelIndex idx_important = index(idx.row(), MSG_DB_IMPORTANT_INDEX);
-        QVariant dta = m_cache->containsData(idx_important.row()) ? m_cache->data(idx_important) : QSqlQueryModel::data(idx_important);
-
-        return dta.toInt() == 1 ? m_favoriteIcon : QVariant();
+        return (rowState(idx.row()) & RowStateImportant) != 0 ? m_favoriteIcon : QVariant();
       }
       else {
         return QVariant();
@@ -304,6 +1099,10 @@ bool MessagesModel::setMessageRead(int row_index, RootItem::ReadStatus read) {
     return true;
   }
 
+  if (withoutArchivedMessages(QModelIndexList() << index(row_index, MSG_DB_ID_INDEX)).isEmpty()) {
+    return false;
+  }
+
   Message message = messageAt(row_index);
 
   if (!m_selectedItem->getParentServiceRoot()->onBeforeSetMessagesRead(m_selectedItem, QList<Message>() << message, read)) {
@@ -320,33 +1119,46 @@ bool MessagesModel::setMessageRead(int row_index, RootItem::ReadStatus read) {
     return false;
   }
 
-  if (DatabaseQueries::markMessagesReadUnread(m_db, QStringList() << QString::number(message.m_id), read)) {
-    return m_selectedItem->getParentServiceRoot()->onAfterSetMessagesRead(m_selectedItem, QList<Message>() << message, read);
-  }
-  else {
-    return false;
-  }
+  QPointer<RootItem> selected_item = m_selectedItem;
+
+  return performBulkOperation(read == RootItem::Read ? MessagesBulkUpdater::MarkRead : MessagesBulkUpdater::MarkUnread,
+                              QStringList() << QString::number(message.m_id), [selected_item, message, read]() {
+    return !selected_item.isNull() &&
+        selected_item->getParentServiceRoot()->onAfterSetMessagesRead(selected_item, QList<Message>() << message, read);
+  });
 }
 
 bool MessagesModel::setMessageReadById(int id, RootItem::ReadStatus read) {
-  for (int i = 0; i < rowCount(); i++) {
-    int found_id = data(i, MSG_DB_ID_INDEX, Qt::EditRole).toInt();
+  const int row = loadedRowOfMessage(id);
+
+  if (row < 0) {
+    // Read state is already stored by the caller, message
+    // which is not loaded might move in loaded pages.
+    if (isSortColumn(MSG_DB_READ_INDEX)) {
+      m_orderChanged = true;
+      reloadChangedOrder();
+    }
+
+    return false;
+  }
 
-    if (found_id == id) {
-      bool set = setData(index(i, MSG_DB_READ_INDEX), read);
+  bool set = setData(index(row, MSG_DB_READ_INDEX), read);
 
-      if (set) {
-        emit dataChanged(index(i, 0), index(i, MSG_DB_CUSTOM_HASH_INDEX));
-      }
+  if (set) {
+    emit dataChanged(index(row, 0), index(row, MSG_DB_CUSTOM_HASH_INDEX));
 
-      return set;
-    }
+    // Read state is already stored by the caller.
+    reloadChangedOrder();
   }
 
-  return false;
+  return set;
 }
 
 bool MessagesModel::switchMessageImportance(int row_index) {
+  if (withoutArchivedMessages(QModelIndexList() << index(row_index, MSG_DB_ID_INDEX)).isEmpty()) {
+    return false;
+  }
+
   const QModelIndex target_index = index(row_index, MSG_DB_IMPORTANT_INDEX);
   const RootItem::Importance current_importance = (RootItem::Importance) data(target_index, Qt::EditRole).toInt();
   const RootItem::Importance next_importance = current_importance == RootItem::Important ?
@@ -368,26 +1180,33 @@ bool MessagesModel::switchMessageImportance(int row_index) {
     return false;
   }
 
+  emit dataChanged(index(row_index, 0), index(row_index, MSG_DB_FEED_CUSTOM_ID_INDEX), QVector<int>() << Qt::FontRole);
+
   // Commit changes.
-  if (DatabaseQueries::markMessageImportant(m_db, message.m_id, next_importance)) {
-    emit dataChanged(index(row_index, 0), index(row_index, MSG_DB_FEED_CUSTOM_ID_INDEX), QVector<int>() << Qt::FontRole);
+  QPointer<RootItem> selected_item = m_selectedItem;
+
+  return performBulkOperation(MessagesBulkUpdater::SwitchImportance, QStringList() << QString::number(message.m_id),
+                              [selected_item, pair]() {
+    return !selected_item.isNull() &&
+        selected_item->getParentServiceRoot()->onAfterSwitchMessageImportance(selected_item,
+                                                                              QList<QPair<Message,RootItem::Importance> >() << pair);
+  });
+}
 
-    return m_selectedItem->getParentServiceRoot()->onAfterSwitchMessageImportance(m_selectedItem,
-                                                                                  QList<QPair<Message,RootItem::Importance> >() << pair);
-  }
-  else {
+bool MessagesModel::switchBatchMessageImportance(const QModelIndexList &selected_messages) {
+  const QModelIndexList messages = withoutArchivedMessages(selected_messages);
+
+  if (messages.isEmpty()) {
     return false;
   }
-}
 
-bool MessagesModel::switchBatchMessageImportance(const QModelIndexList &messages) {
   QStringList message_ids;
   QList<QPair<Message,RootItem::Importance> > message_states;
 
   // Obtain IDs of all desired messages.
   foreach (const QModelIndex &message, messages) {
-    const Message msg = messageAt(message.row());
-    RootItem::Importance message_importance = messageImportance((message.row()));
+    const Message msg = messageIdentityAt(message.row());
+    RootItem::Importance message_importance = msg.m_isImportant ? RootItem::Important : RootItem::NotImportant;
 
     message_states.append(QPair<Message,RootItem::Importance>(msg, message_importance == RootItem::Important ?
                                                                 RootItem::NotImportant :
@@ -406,21 +1225,27 @@ bool MessagesModel::switchBatchMessageImportance(const QModelIndexList &messages
     return false;
   }
 
-  if (DatabaseQueries::switchMessagesImportance(m_db, message_ids)) {
-    return m_selectedItem->getParentServiceRoot()->onAfterSwitchMessageImportance(m_selectedItem, message_states);
-  }
-  else {
+  QPointer<RootItem> selected_item = m_selectedItem;
+
+  return performBulkOperation(MessagesBulkUpdater::SwitchImportance, message_ids, [selected_item, message_states]() {
+    return !selected_item.isNull() &&
+        selected_item->getParentServiceRoot()->onAfterSwitchMessageImportance(selected_item, message_states);
+  });
+}
+
+bool MessagesModel::setBatchMessagesDeleted(const QModelIndexList &selected_messages) {
+  const QModelIndexList messages = withoutArchivedMessages(selected_messages);
+
+  if (messages.isEmpty()) {
     return false;
   }
-}
 
-bool MessagesModel::setBatchMessagesDeleted(const QModelIndexList &messages) {
   QStringList message_ids;
   QList<Message> msgs;
 
   // Obtain IDs of all desired messages.
   foreach (const QModelIndex &message, messages) {
-    const Message msg = messageAt(message.row());
+    const Message msg = messageIdentityAt(message.row());
 
     msgs.append(msg);
     message_ids.append(QString::number(msg.m_id));
@@ -439,30 +1264,30 @@ bool MessagesModel::setBatchMessagesDeleted(const QModelIndexList &messages) {
     return false;
   }
 
-  bool deleted;
+  QPointer<RootItem> selected_item = m_selectedItem;
 
-  if (m_selectedItem->kind() != RootItemKind::Bin) {
-    deleted = DatabaseQueries::deleteOrRestoreMessagesToFromBin(m_db, message_ids, true);
-  }
-  else {
-    deleted = DatabaseQueries::permanentlyDeleteMessages(m_db, message_ids);
-  }
+  return performBulkOperation(m_selectedItem->kind() != RootItemKind::Bin ?
+                                MessagesBulkUpdater::MoveToBin :
+                                MessagesBulkUpdater::PermanentlyDelete,
+                              message_ids, [selected_item, msgs]() {
+    return !selected_item.isNull() &&
+        selected_item->getParentServiceRoot()->onAfterMessagesDelete(selected_item, msgs);
+  });
+}
 
-  if (deleted) {
-    return m_selectedItem->getParentServiceRoot()->onAfterMessagesDelete(m_selectedItem, msgs);
-  }
-  else {
+bool MessagesModel::setBatchMessagesRead(const QModelIndexList &selected_messages, RootItem::ReadStatus read) {
+  const QModelIndexList messages = withoutArchivedMessages(selected_messages);
+
+  if (messages.isEmpty()) {
     return false;
   }
-}
 
-bool MessagesModel::setBatchMessagesRead(const QModelIndexList &messages, RootItem::ReadStatus read) {
   QStringList message_ids;
   QList<Message> msgs;
 
   // Obtain IDs of all desired messages.
   foreach (const QModelIndex &message, messages) {
-    Message msg = messageAt(message.row());
+    const Message msg = messageIdentityAt(message.row());
 
     msgs.append(msg);
     message_ids.append(QString::number(msg.m_id));
@@ -476,21 +1301,28 @@ bool MessagesModel::setBatchMessagesRead(const QModelIndexList &messages, RootIt
     return false;
   }
 
-  if (DatabaseQueries::markMessagesReadUnread(m_db, message_ids, read)) {
-    return m_selectedItem->getParentServiceRoot()->onAfterSetMessagesRead(m_selectedItem, msgs, read);
-  }
-  else {
+  QPointer<RootItem> selected_item = m_selectedItem;
+
+  return performBulkOperation(read == RootItem::Read ? MessagesBulkUpdater::MarkRead : MessagesBulkUpdater::MarkUnread,
+                              message_ids, [selected_item, msgs, read]() {
+    return !selected_item.isNull() &&
+        selected_item->getParentServiceRoot()->onAfterSetMessagesRead(selected_item, msgs, read);
+  });
+}
+
+bool MessagesModel::setBatchMessagesRestored(const QModelIndexList &selected_messages) {
+  const QModelIndexList messages = withoutArchivedMessages(selected_messages);
+
+  if (messages.isEmpty()) {
     return false;
   }
-}
 
-bool MessagesModel::setBatchMessagesRestored(const QModelIndexList &messages) {
   QStringList message_ids;
   QList<Message> msgs;
 
   // Obtain IDs of all desired messages.
   foreach (const QModelIndex &message, messages) {
-    const Message msg = messageAt(message.row());
+    const Message msg = messageIdentityAt(message.row());
 
     msgs.append(msg);
     message_ids.append(QString::number(msg.m_id));
@@ -505,12 +1337,91 @@ bool MessagesModel::setBatchMessagesRestored(const QModelIndexList &messages) {
     return false;
   }
 
-  if (DatabaseQueries::deleteOrRestoreMessagesToFromBin(m_db, message_ids, false)) {
-    return m_selectedItem->getParentServiceRoot()->onAfterMessagesRestoredFromBin(m_selectedItem, msgs);
+  QPointer<RootItem> selected_item = m_selectedItem;
+
+  return performBulkOperation(MessagesBulkUpdater::RestoreFromBin, message_ids, [selected_item, msgs]() {
+    return !selected_item.isNull() &&
+        selected_item->getParentServiceRoot()->onAfterMessagesRestoredFromBin(selected_item, msgs);
+  });
+}
+
+QModelIndexList MessagesModel::withoutArchivedMessages(const QModelIndexList &messages) const {
+  if (archiveSchema().isEmpty()) {
+    return messages;
+  }
+
+  QStringList ids;
+
+  foreach (const QModelIndex &message, messages) {
+    ids.append(QString::number(messageId(message.row())));
+  }
+
+  bool ok;
+  const QSet<int> archived_ids = DatabaseQueries::archivedMessageIds(m_db, archiveSchema(), ids, &ok);
+
+  if (!ok) {
+    return QModelIndexList();
+  }
+  else if (archived_ids.isEmpty()) {
+    return messages;
+  }
+
+  QModelIndexList unarchived_messages;
+
+  foreach (const QModelIndex &message, messages) {
+    if (!archived_ids.contains(messageId(message.row()))) {
+      unarchived_messages.append(message);
+    }
+  }
+
+  qDebug("Skipping %d archived messages, they are read-only.", messages.size() - unarchived_messages.size());
+  return unarchived_messages;
+}
+
+bool MessagesModel::isBulkOperationRunning() const {
+  return !m_bulkOperationCallbacks.isEmpty();
+}
+
+bool MessagesModel::performBulkOperation(MessagesBulkUpdater::Operation operation, const QStringList &ids,
+                                         const std::function<bool()> &after_operation) {
+  if (ids.size() < MESSAGES_BULK_ASYNC_THRESHOLD && !isBulkOperationRunning()) {
+    // Small selections are processed right away. When some operation is still
+    // queued, this one is queued too, so that operations are stored in the order
+    // they were performed, e.g. importance switched twice is switched back.
+    const bool result = MessagesBulkUpdater::executeOperation(m_db, operation, ids) && after_operation();
+
+    reloadChangedOrder();
+    return result;
+  }
+
+  if (m_bulkUpdater == nullptr) {
+    m_bulkUpdater = qApp->feedReader()->messagesBulkUpdater();
+
+    connect(m_bulkUpdater, &MessagesBulkUpdater::operationStarted, this, &MessagesModel::bulkOperationStarted);
+    connect(m_bulkUpdater, &MessagesBulkUpdater::operationProgress, this, &MessagesModel::bulkOperationProgress);
+    connect(m_bulkUpdater, &MessagesBulkUpdater::operationFinished, this, &MessagesModel::onBulkOperationFinished);
+  }
+
+  // Large selections (and any operations which follow them) are processed
+  // in worker thread, services are notified once all messages are stored.
+  m_bulkOperationCallbacks.enqueue(after_operation);
+  QMetaObject::invokeMethod(m_bulkUpdater, "performOperation",
+                            Q_ARG(MessagesBulkUpdater::Operation, operation), Q_ARG(QStringList, ids));
+  return true;
+}
+
+void MessagesModel::onBulkOperationFinished(bool result) {
+  const std::function<bool()> after_operation = m_bulkOperationCallbacks.dequeue();
+
+  if (result) {
+    after_operation();
   }
   else {
-    return false;
+    qWarning("Bulk operation on messages failed.");
   }
+
+  reloadChangedOrder();
+  emit bulkOperationFinished(result);
 }
 
 QVariant MessagesModel::headerData(int section, Qt::Orientation orientation, int role) const {
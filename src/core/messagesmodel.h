@@ -18,20 +18,32 @@
 #ifndef MESSAGESMODEL_H
 #define MESSAGESMODEL_H
 
-#include <QSqlQueryModel>
+#include <QAbstractTableModel>
 #include "core/messagesmodelsqllayer.h"
 
 #include "definitions/definitions.h"
 #include "core/message.h"
+#include "core/messagesbulkupdater.h"
 #include "services/abstract/rootitem.h"
 
 #include <QFont>
 #include <QIcon>
+#include <QQueue>
+#include <QHash>
+#include <QVector>
+#include <QSqlRecord>
+#include <QTimer>
+#include <QFutureWatcher>
+
+#include <functional>
 
 
 class MessagesModelCache;
+class QThreadPool;
 
-class MessagesModel : public QSqlQueryModel, public MessagesModelSqlLayer {
+// Model of messages which knows number of matching messages up front and
+// loads them lazily in pages, only a few recently used pages are kept in memory.
+class MessagesModel : public QAbstractTableModel, public MessagesModelSqlLayer {
     Q_OBJECT
 
   public:
@@ -47,19 +59,44 @@ class MessagesModel : public QSqlQueryModel, public MessagesModelSqlLayer {
     explicit MessagesModel(QObject *parent = 0);
     virtual ~MessagesModel();
 
-    // Fetches ALL available data to the model.
-    // NOTE: This activates the SQL query and populates the model with new data.
+    // Counts messages matching current filters and drops all loaded
+    // messages, they are loaded again once the view asks for them.
     void repopulate();
 
     // Model implementation.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
     bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     QVariant data(int row, int column, int role = Qt::DisplayRole) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
     Qt::ItemFlags flags(const QModelIndex &index) const;
 
+    // Returns record of message at given index,
+    // page with the message is loaded if needed.
+    QSqlRecord record(int row_index) const;
+
     // Returns message at given index.
     Message messageAt(int row_index) const;
+
+    // Returns first unread row between given rows (inclusive) or -1.
+    int nextUnreadRow(int from_row, int to_row) const;
+
+    // Returns row of message with given ID or -1 if message is not in the list.
+    // Rows of loaded messages are known right away, other rows are computed by DB.
+    int rowOfMessage(int id) const;
+
+    // Returns message with only its identifying data (IDs, feed and read/important
+    // states) filled in, which is much cheaper than messageAt().
+    Message messageIdentityAt(int row_index) const;
+
+    // Returns message including its contents and enclosures,
+    // which are not loaded into the model itself.
+    Message messageWithBodyAt(int row_index) const;
+
+    // Loads bodies of messages in given rows in worker thread, so that
+    // messageWithBodyAt() does not wait for DB once they get selected.
+    void prefetchMessages(const QList<int> &row_indexes);
     int messageId(int row_index) const;
     RootItem::Importance messageImportance(int row_index) const;
 
@@ -77,28 +114,188 @@ class MessagesModel : public QSqlQueryModel, public MessagesModelSqlLayer {
     bool setBatchMessagesRead(const QModelIndexList &messages, RootItem::ReadStatus read);
     bool setBatchMessagesRestored(const QModelIndexList &messages);
 
+    // Returns true if some large batch operation is still being stored in worker thread.
+    bool isBulkOperationRunning() const;
+
     // Highlights messages.
     void highlightMessages(MessageHighlighter highlight);
 
     // Loads messages of given feeds.
     void loadMessages(RootItem *item);
 
+    // Puts inserted messages which match current filters into the list in their
+    // sorted positions and refreshes rows of updated messages. False is returned if list
+    // has to be reloaded completely instead, for example if there are too many messages
+    // or if loaded updated message might be moved to another row.
+    bool refreshMessages(const QList<int> &inserted_ids, const QList<int> &updated_ids);
+
+    // Narrows loaded messages to those matching given full-text search pattern,
+    // empty pattern shows all of them. Search itself runs in worker thread
+    // once pattern stops changing, searchFinished() is emitted when it is applied.
+    void searchMessages(const QString &pattern);
+
+    // Includes or excludes archived messages of account of loaded item.
+    // Archived messages are only displayed, their states cannot be changed.
+    void setArchiveIncluded(bool included);
+    bool isArchiveIncluded() const;
+
   public slots:
     // NOTE: These methods DO NOT actually change data in the DB, just in the model.
     // These are particularly used by msg browser.
     bool setMessageImportantById(int id, RootItem::Importance important);
     bool setMessageReadById(int id, RootItem::ReadStatus read);
 
+  signals:
+    void bulkOperationStarted();
+    void bulkOperationProgress(int processed, int total);
+    void bulkOperationFinished(bool result);
+
+    // Emitted when results of full-text search were applied to the list,
+    // "truncated" is true if only most relevant of matching messages are displayed.
+    void searchFinished(bool truncated);
+
+    // Emitted when bodies of prefetched messages are loaded.
+    void messagesPrefetched(const QList<Message> &messages);
+
+  private slots:
+    void onBulkOperationFinished(bool result);
+
+    // Starts full-text search in worker thread, results
+    // of stale searches are dropped once they are finished.
+    void startSearch();
+    void onSearchFinished();
+
+    void onPrefetchFinished();
+
   private:
+    // Returns given messages except those from archive, which cannot be changed.
+    QModelIndexList withoutArchivedMessages(const QModelIndexList &messages) const;
+
+    // Stores new states of given messages to DB, large selections are stored
+    // asynchronously. Given function is called once messages are stored.
+    bool performBulkOperation(MessagesBulkUpdater::Operation operation, const QStringList &ids,
+                              const std::function<bool()> &after_operation);
+
     void setupHeaderData();
     void setupFonts();
     void setupIcons();
 
+    void startPrefetch(const QList<Message> &messages);
+
+    // Starts delayed full-text search of new list of messages, no
+    // messages are listed until it finishes.
+    void applySearchPattern();
+    // Returns true if there were more results than displayed.
+    bool applySearchResults(QList<int> ids);
+
+    // Attaches archive of account of loaded item if it is requested.
+    void applyArchiveInclusion();
+
+    // Returns page with given index, loads it if needed.
+    const QVector<QSqlRecord> &page(int page_index) const;
+    void loadPage(int page_index) const;
+
+    // Returns loaded row of message with given ID or -1.
+    int loadedRowOfMessage(int id) const;
+
+    // Returns row of given message computed by DB or -1.
+    int rowOfRecord(const QSqlRecord &record) const;
+
+    // Drops all loaded pages and states of rows.
+    void clearPages();
+
+    // Returns false for in-memory database, its only connection belongs
+    // to main thread, so it cannot be used by worker threads.
+    bool workerThreadsUsable() const;
+
+    // Returns true if records differ in some column, which messages are sorted by.
+    bool sortKeysDiffer(const QSqlRecord &first, const QSqlRecord &second) const;
+
+    // Reloads pages once changed sort keys of messages are stored, so that
+    // loaded pages and pages loaded later follow the same order of messages.
+    // Persistent indexes, e.g. selection, are moved with their messages.
+    void reloadChangedOrder();
+
+    // Flags of row which decide its font, color and icons.
+    enum RowState {
+      RowStateComputed = 1,
+      RowStateRead = 2,
+      RowStateImportant = 4,
+      RowStateDeleted = 8
+    };
+
+    // Display data of loaded row which are computed once and then reused
+    // for repaints, they are dropped together with their page.
+    struct RowDisplay {
+      QString m_date;
+      quint8 m_state;
+
+      RowDisplay() : m_date(QString()), m_state(0) {
+      }
+    };
+
+    // Returns cached display data of given row or nullptr if its page is not loaded.
+    RowDisplay *rowDisplay(int row_index) const;
+    QString formattedDate(int row_index) const;
+    quint8 rowState(int row_index) const;
+
+    // Loads read states of all rows into bitmap of unread rows.
+    void loadUnreadRows() const;
+    void setRowUnread(int row, bool unread) const;
+
     MessagesModelCache *m_cache;
     MessageHighlighter m_messageHighlighter;
 
+    // Number of messages matching current filters.
+    int m_rowCount;
+
+    // Loaded pages, most recently used pages are at the end of usage list.
+    mutable QHash<int,QVector<QSqlRecord> > m_pages;
+    mutable QList<int> m_pageUsage;
+
+    // Last messages of pages which were loaded, following pages are
+    // selected via keyset condition instead of expensive offset.
+    mutable QHash<int,QSqlRecord> m_pageBoundaries;
+
+    // Display data of rows of loaded pages.
+    mutable QHash<int,QVector<RowDisplay> > m_pageDisplays;
+
+    // Rows of messages from loaded pages, hashed by IDs of messages.
+    mutable QHash<int,int> m_messageRows;
+
+    // Bitmap with set bits for unread rows, it is loaded on first use.
+    mutable QVector<quint64> m_unreadRows;
+    mutable bool m_unreadRowsLoaded;
+
+    // Some message got new value of column, which messages are sorted by,
+    // so its loaded row does not have to match its position in DB.
+    bool m_orderChanged;
+
     QString m_customDateFormat;
     RootItem *m_selectedItem;
+    QString m_searchPattern;
+    bool m_archiveIncluded;
+
+    // Searches and prefetching run in own threads, so that they
+    // do not wait for other tasks in global thread pool.
+    QThreadPool *m_workerPool;
+
+    // Searches are delayed while pattern is being typed, only the newest
+    // generation of search is applied and at most one search runs at a time.
+    QTimer *m_searchTimer;
+    QFutureWatcher<QList<int> > *m_searchWatcher;
+    int m_searchGeneration;
+    int m_runningSearchGeneration;
+    bool m_searchPending;
+
+    // Messages with bodies loaded ahead of time, hashed by their IDs. Messages
+    // requested while other ones are being loaded wait in pending list.
+    QHash<int,Message> m_prefetchedMessages;
+    QFutureWatcher<QList<Message> > *m_prefetchWatcher;
+    QList<Message> m_pendingPrefetch;
+
+    MessagesBulkUpdater *m_bulkUpdater;
+    QQueue<std::function<bool()> > m_bulkOperationCallbacks;
     QList<QString> m_headerData;
     QList<QString> m_tooltipData;
 
@@ -17,23 +17,73 @@
 
 #include "core/messagesmodelcache.h"
 
-#include "miscellaneous/textfactory.h"
+#include "definitions/definitions.h"
 
 
-MessagesModelCache::MessagesModelCache(QObject *parent) : QObject(parent), m_msgCache(QHash<int,QSqlRecord>()) {
+MessagesModelCache::MessagesModelCache(QObject *parent) : QObject(parent), m_states(QVector<quint8>()), m_rowCount(0) {
 }
 
 MessagesModelCache::~MessagesModelCache() {
 }
 
-void MessagesModelCache::setData(const QModelIndex &index, const QVariant &value, const QSqlRecord &record) {
-  if (!m_msgCache.contains(index.row())) {
-    m_msgCache[index.row()] = record;
+void MessagesModelCache::clear(int row_count) {
+  m_states.clear();
+  m_rowCount = row_count;
+}
+
+void MessagesModelCache::insertRows(int row, int count) {
+  if (!m_states.isEmpty()) {
+    m_states.insert(row, count, 0);
   }
 
-  m_msgCache[index.row()].setValue(index.column(), value);
+  m_rowCount += count;
 }
 
-QVariant MessagesModelCache::data(const QModelIndex &idx) {
-  return m_msgCache[idx.row()].value(idx.column());
+bool MessagesModelCache::setData(const QModelIndex &index, const QVariant &value) {
+  const quint8 flag = columnFlag(index.column());
+
+  if (flag == 0 || index.row() < 0 || index.row() >= m_rowCount) {
+    return false;
+  }
+
+  // States are allocated once the first change is made.
+  if (m_states.isEmpty()) {
+    m_states.fill(0, m_rowCount);
+  }
+
+  quint8 &state = m_states[index.row()];
+
+  state |= flag << 4;
+
+  if (value.toInt() != 0) {
+    state |= flag;
+  }
+  else {
+    state &= ~flag;
+  }
+
+  return true;
+}
+
+QVariant MessagesModelCache::data(const QModelIndex &idx) const {
+  return (m_states.at(idx.row()) & columnFlag(idx.column())) != 0 ? 1 : 0;
+}
+
+quint8 MessagesModelCache::columnFlag(int column) {
+  switch (column) {
+    case MSG_DB_READ_INDEX:
+      return 0x01;
+
+    case MSG_DB_IMPORTANT_INDEX:
+      return 0x02;
+
+    case MSG_DB_DELETED_INDEX:
+      return 0x04;
+
+    case MSG_DB_PDELETED_INDEX:
+      return 0x08;
+
+    default:
+      return 0;
+  }
 }
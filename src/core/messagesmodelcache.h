@@ -20,12 +20,15 @@
 
 #include <QObject>
 
-#include "core/message.h"
-
 #include <QVariant>
+#include <QVector>
 #include <QModelIndex>
 
 
+// Holds states of messages which were changed in the model but which are
+// not reloaded from DB yet. Only flag columns (read, important, deleted and
+// permanently deleted) can be changed, each row takes single byte, lower half
+// of it holds values of flags and upper half says which of them were changed.
 class MessagesModelCache : public QObject {
     Q_OBJECT
 
@@ -33,23 +36,30 @@ class MessagesModelCache : public QObject {
     explicit MessagesModelCache(QObject *parent = nullptr);
     virtual ~MessagesModelCache();
 
-    inline bool containsData(int row_idx) const {
-      return m_msgCache.contains(row_idx);
-    }
+    // Returns true if value of given column of given row was changed.
+    inline bool containsData(int row_idx, int column) const {
+      const quint8 flag = columnFlag(column);
 
-    inline QSqlRecord record(int row_idx) const {
-      return m_msgCache.value(row_idx);
+      return flag != 0 && row_idx >= 0 && row_idx < m_states.size() && (m_states.at(row_idx) & (flag << 4)) != 0;
     }
 
-    inline void clear() {
-      m_msgCache.clear();
-    }
+    // Drops all changes, model now has given number of rows.
+    void clear(int row_count);
 
-    void setData(const QModelIndex &index, const QVariant &value, const QSqlRecord &record);
-    QVariant data(const QModelIndex &idx);
+    // Makes room for rows inserted into the model.
+    void insertRows(int row, int count);
+
+    // Stores new value of given flag column, false is returned
+    // for columns which cannot be changed.
+    bool setData(const QModelIndex &index, const QVariant &value);
+    QVariant data(const QModelIndex &idx) const;
 
   private:
-    QHash<int,QSqlRecord> m_msgCache;
+    // Returns bit of given flag column or 0 if column is not a flag.
+    static quint8 columnFlag(int column);
+
+    QVector<quint8> m_states;
+    int m_rowCount;
 };
 
 #endif // MESSAGESMODELCACHE_H
@@ -22,7 +22,7 @@
 
 
 MessagesModelSqlLayer::MessagesModelSqlLayer()
-  : m_filter(QSL(DEFAULT_SQL_MESSAGES_FILTER)), m_fieldNames(QMap<int,QString>()),
+  : m_filter(QSL(DEFAULT_SQL_MESSAGES_FILTER)), m_searchFilter(QString()), m_archiveSchema(QString()), m_fieldNames(QMap<int,QString>()),
     m_sortColumns(QList<int>()), m_sortOrders(QList<Qt::SortOrder>()){
   m_db = qApp->database()->connection(QSL("MessagesModel"), DatabaseFactory::FromSettings);
 
@@ -35,9 +35,11 @@ MessagesModelSqlLayer::MessagesModelSqlLayer()
   m_fieldNames[MSG_DB_URL_INDEX] = "Messages.url";
   m_fieldNames[MSG_DB_AUTHOR_INDEX] = "Messages.author";
   m_fieldNames[MSG_DB_DCREATED_INDEX] = "Messages.date_created";
-  m_fieldNames[MSG_DB_CONTENTS_INDEX] = "Messages.contents";
+  // Bodies of messages are stored in separate table and they are loaded
+  // only when message is opened, list contains just empty placeholders.
+  m_fieldNames[MSG_DB_CONTENTS_INDEX] = "''";
   m_fieldNames[MSG_DB_PDELETED_INDEX] = "Messages.is_pdeleted";
-  m_fieldNames[MSG_DB_ENCLOSURES_INDEX] = "Messages.enclosures";
+  m_fieldNames[MSG_DB_ENCLOSURES_INDEX] = "''";
   m_fieldNames[MSG_DB_ACCOUNT_ID_INDEX] = "Messages.account_id";
   m_fieldNames[MSG_DB_CUSTOM_ID_INDEX]  = "Messages.custom_id";
   m_fieldNames[MSG_DB_CUSTOM_HASH_INDEX] = "Messages.custom_hash";
@@ -77,29 +79,130 @@ void MessagesModelSqlLayer::setFilter(const QString &filter) {
   m_filter = filter;
 }
 
+QString MessagesModelSqlLayer::filter() const {
+  return m_filter;
+}
+
+void MessagesModelSqlLayer::setSearchFilter(const QString &search_filter) {
+  m_searchFilter = search_filter;
+}
+
+void MessagesModelSqlLayer::setArchiveSchema(const QString &archive_schema) {
+  m_archiveSchema = archive_schema;
+}
+
+QString MessagesModelSqlLayer::archiveSchema() const {
+  return m_archiveSchema;
+}
+
 QString MessagesModelSqlLayer::formatFields() const {
   return m_fieldNames.values().join(QSL(", "));
 }
 
-QString MessagesModelSqlLayer::selectStatement() const {
-  return QL1S("SELECT ") + formatFields() +
-      QSL(" FROM Messages LEFT JOIN Feeds ON Messages.feed = Feeds.custom_id AND Messages.account_id = Feeds.account_id WHERE ") +
-      m_filter + orderByClause() + QL1C(';');
+QString MessagesModelSqlLayer::selectStatement(const QString &condition) const {
+  return QL1S("SELECT ") + formatFields() + fromClause() + whereClause(condition) + orderByClause() + QL1C(';');
 }
 
-QString MessagesModelSqlLayer::orderByClause() const {
-  if (m_sortColumns.isEmpty()) {
-    return QString();
-  }
-  else {
-    QStringList sorts;
+QString MessagesModelSqlLayer::countStatement(const QString &condition) const {
+  return QL1S("SELECT COUNT(*)") + fromClause() + whereClause(condition) + QL1C(';');
+}
 
-    for (int i = 0; i < m_sortColumns.size(); i++) {
-      QString field_name(m_fieldNames[m_sortColumns[i]]);
+QString MessagesModelSqlLayer::columnStatement(int column) const {
+  return QL1S("SELECT ") + m_fieldNames[column] + fromClause() + whereClause(QString()) + orderByClause() + QL1C(';');
+}
+
+QString MessagesModelSqlLayer::pageStatement(const QString &keyset_condition, int limit, int offset) const {
+  return QL1S("SELECT ") + formatFields() + fromClause() + whereClause(keyset_condition) + orderByClause() +
+      QString(QSL(" LIMIT %1 OFFSET %2;")).arg(QString::number(limit), QString::number(offset));
+}
+
+QString MessagesModelSqlLayer::keysetCondition(const QSqlRecord &record, QVariantList &values, bool following) const {
+  QStringList alternatives;
+  QStringList equalities;
+  QVariantList equal_values;
+
+  values.clear();
+
+  // Messages following given one have greater (or lower, for descending order)
+  // value of the first sort key or the same value and greater value of the next key etc.
+  foreach (const SortKey &key, sortKeys()) {
+    const QVariant value = record.value(key.first);
 
-      sorts.append(field_name + (m_sortOrders[i] == Qt::AscendingOrder ? QSL(" ASC") : QSL(" DESC")));
+    if (value.isNull()) {
+      // NULL values cannot be compared, caller has to skip messages via offset.
+      values.clear();
+      return QString();
     }
 
-    return QL1S(" ORDER BY ") + sorts.join(QSL(", "));
+    const QString &field_name = m_fieldNames[key.first];
+    const bool greater = (key.second == Qt::AscendingOrder) == following;
+    const QString comparison = field_name + (greater ? QSL(" > ?") : QSL(" < ?"));
+
+    alternatives.append(QString(QSL("(%1)")).arg((QStringList(equalities) << comparison).join(QSL(" AND "))));
+    values << equal_values << value;
+    equalities.append(field_name + QSL(" = ?"));
+    equal_values.append(value);
   }
+
+  return alternatives.join(QSL(" OR "));
+}
+
+QString MessagesModelSqlLayer::fromClause() const {
+  return QSL(" FROM ") + messagesSource() + QSL(" LEFT JOIN Feeds ON Messages.feed_id = Feeds.id");
+}
+
+QString MessagesModelSqlLayer::whereClause(const QString &condition) const {
+  QString where_clause = m_searchFilter.isEmpty() ?
+                         QString(QSL(" WHERE (%1)")).arg(m_filter) :
+                         QString(QSL(" WHERE (%1) AND (%2)")).arg(m_filter, m_searchFilter);
+
+  if (!condition.isEmpty()) {
+    where_clause += QString(QSL(" AND (%1)")).arg(condition);
+  }
+
+  return where_clause;
+}
+
+bool MessagesModelSqlLayer::isSortColumn(int column) const {
+  return m_sortColumns.contains(column);
+}
+
+QList<SortKey> MessagesModelSqlLayer::sortKeys() const {
+  QList<SortKey> keys;
+
+  for (int i = 0; i < m_sortColumns.size(); i++) {
+    keys.append(SortKey(m_sortColumns[i], m_sortOrders[i]));
+  }
+
+  if (!m_sortColumns.contains(MSG_DB_ID_INDEX)) {
+    keys.append(SortKey(MSG_DB_ID_INDEX, Qt::AscendingOrder));
+  }
+
+  return keys;
+}
+
+QString MessagesModelSqlLayer::messagesSource() const {
+  if (m_archiveSchema.isEmpty()) {
+    return QSL("Messages");
+  }
+  else {
+    const QString columns = QSL("id, is_read, is_deleted, is_important, feed, feed_id, title, url, author, date_created, "
+                                "is_pdeleted, account_id, custom_id, custom_hash");
+
+    // NOTE: Databases created before message IDs were not reused could
+    // contain archived message with ID of some other message, only the
+    // message from main database is listed then, so that IDs stay unique.
+    return QString(QSL("(SELECT %1 FROM main.Messages UNION ALL SELECT %1 FROM %2.Messages "
+                       "WHERE id NOT IN (SELECT id FROM main.Messages)) AS Messages")).arg(columns, m_archiveSchema);
+  }
+}
+
+QString MessagesModelSqlLayer::orderByClause() const {
+  QStringList sorts;
+
+  foreach (const SortKey &key, sortKeys()) {
+    sorts.append(m_fieldNames[key.first] + (key.second == Qt::AscendingOrder ? QSL(" ASC") : QSL(" DESC")));
+  }
+
+  return QL1S(" ORDER BY ") + sorts.join(QSL(", "));
 }
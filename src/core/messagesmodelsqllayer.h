@@ -23,8 +23,13 @@
 
 #include <QMap>
 #include <QList>
+#include <QPair>
+#include <QSqlRecord>
+#include <QVariant>
 
 
+typedef QPair<int,Qt::SortOrder> SortKey;
+
 class MessagesModelSqlLayer {
   public:
     explicit MessagesModelSqlLayer();
@@ -34,16 +39,57 @@ class MessagesModelSqlLayer {
 
     // Sets SQL WHERE clause, without "WHERE" keyword.
     void setFilter(const QString &filter);
+    QString filter() const;
+
+    // Sets additional SQL WHERE clause, which narrows results
+    // of primary filter, empty clause disables it.
+    void setSearchFilter(const QString &search_filter);
+
+    // Sets schema of attached archive database whose messages are
+    // listed together with messages from main database, empty
+    // schema lists only messages from main database.
+    void setArchiveSchema(const QString &archive_schema);
+    QString archiveSchema() const;
 
   protected:
     QString orderByClause() const;
-    QString selectStatement() const;
     QString formatFields() const;
+    QString messagesSource() const;
+
+    // Returns statement which selects (or counts) messages matching current
+    // filters, they can be narrowed further by given condition.
+    QString selectStatement(const QString &condition = QString()) const;
+    QString countStatement(const QString &condition = QString()) const;
+
+    // Returns statement which selects only given column of all messages.
+    QString columnStatement(int column) const;
+
+    // Returns statement which selects at most "limit" messages in current
+    // sort order. Messages are either skipped via "offset" or only those
+    // following some known message are selected via "keyset_condition".
+    QString pageStatement(const QString &keyset_condition, int limit, int offset) const;
+
+    // Returns condition which selects messages following (or preceding) given
+    // record in current sort order, values of placeholders are stored in "values".
+    // Empty condition is returned if record has NULL sort key.
+    QString keysetCondition(const QSqlRecord &record, QVariantList &values, bool following = true) const;
+
+    // Returns true if messages are sorted by given column.
+    bool isSortColumn(int column) const;
 
     QSqlDatabase m_db;
 
   private:
+    QString fromClause() const;
+    QString whereClause(const QString &condition) const;
+
+    // Returns sorted columns, message ID is always the last one,
+    // so that the order of messages is total.
+    QList<SortKey> sortKeys() const;
+
     QString m_filter;
+    QString m_searchFilter;
+    QString m_archiveSchema;
 
     // NOTE: These two lists contain data for multicolumn sorting.
     // They are always same length. Most important sort column/order
@@ -50,22 +50,16 @@ QModelIndex MessagesProxyModel::getNextPreviousUnreadItemIndex(int default_row)
 }
 
 QModelIndex MessagesProxyModel::getNextUnreadItemIndex(int default_row, int max_row) const {
-  while (default_row <= max_row) {
-    // Get info if the message is read or not.
-    const QModelIndex proxy_index = index(default_row, MSG_DB_READ_INDEX);
-    const bool is_read = m_sourceModel->data(mapToSource(proxy_index).row(),
-                                             MSG_DB_READ_INDEX, Qt::EditRole).toInt() == 1;
-
-    if (!is_read) {
-      // We found unread message, mark it.
-      return proxy_index;
-    }
-    else {
-      default_row++;
-    }
-  }
+  // NOTE: Messages are neither sorted nor filtered here, so rows
+  // are the same as rows of source model, which tracks unread rows.
+  const int unread_row = m_sourceModel->nextUnreadRow(default_row, max_row);
 
-  return QModelIndex();
+  if (unread_row < 0) {
+    return QModelIndex();
+  }
+  else {
+    return mapFromSource(m_sourceModel->index(unread_row, MSG_DB_READ_INDEX));
+  }
 }
 
 bool MessagesProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const {
@@ -30,6 +30,35 @@
 #define MAX_MULTICOLUMN_SORT_STATES           3
 #define ENCLOSURES_OUTER_SEPARATOR            '#'
 #define ECNLOSURES_INNER_SEPARATOR            '&'
+#define COMPRESSED_TEXT_HEADER                "#rssguard-z1#"
+#define COMPRESSED_TEXT_LEVEL                 9
+#define COMPRESS_CONTENTS_BATCH_SIZE          500
+#define MESSAGES_SEARCH_LIMIT                 1000
+#define MESSAGES_SEARCH_DELAY                 250
+#define MESSAGES_PREFETCH_COUNT               3
+#define MESSAGES_PREFETCH_LIMIT               32
+#define MESSAGES_HTML_CACHE_SIZE              8388608
+#define ICONS_CACHE_SIZE                      1024
+#define NEWSPAPER_MESSAGE_HEIGHT              300
+#define MESSAGES_MODEL_PAGE_SIZE              256
+#define MESSAGES_MODEL_MAX_PAGES              16
+#define MESSAGES_MODEL_PREFETCH_MARGIN        64
+#define MESSAGES_MODEL_INCREMENTAL_LIMIT      100
+#define MESSAGES_MODEL_MAX_THREADS            2
+#define MESSAGES_BULK_CHUNK_SIZE              500
+#define MESSAGES_BULK_CHUNK_MAX_BYTES         800000
+#define SQLITE_MAX_BOUND_VALUES               999
+#define MESSAGES_BULK_ASYNC_THRESHOLD         2000
+#define ARCHIVE_MESSAGES_BATCH_SIZE           500
+#define DATABASE_COMPACTION_INTERVAL          30000
+#define DATABASE_COMPACTION_STEP_PAGES        256
+#define DATABASE_HEALTH_CHECK_INTERVAL        60000
+#define DATABASE_POOL_MAX_CONNECTIONS         12
+#define DATABASE_POOL_WAIT_TIMEOUT            5000
+#define DATABASE_SLOW_QUERY_THRESHOLD         250
+#define DATABASE_PROFILER_MAX_STATEMENTS      1000
+#define DATABASE_PROFILER_DUMP_COUNT          20
+#define DEFAULT_DAYS_TO_ARCHIVE_MSG           90
 #define URI_SCHEME_FEED_SHORT                 "feed:"
 #define URI_SCHEME_FEED                       "feed://"
 #define URI_SCHEME_HTTP                       "http://"
@@ -108,9 +137,13 @@
 #define APP_DB_SQLITE_INIT            "db_init_sqlite.sql"
 #define APP_DB_SQLITE_PATH            "database/local"
 #define APP_DB_SQLITE_FILE            "database.db"
+#define APP_DB_SQLITE_ARCHIVE_INIT    "db_archive_sqlite.sql"
+#define APP_DB_SQLITE_ARCHIVE_FILE    "archive_%1.db"
+#define APP_DB_SQLITE_ARCHIVE_SCHEMA  "archive_%1"
+#define APP_DB_POOL_CONNECTION        "pool_%1_%2"
 
 // Keep this in sync with schema versions declared in SQL initialization code.
-#define APP_DB_SCHEMA_VERSION         "8"
+#define APP_DB_SCHEMA_VERSION         "17"
 #define APP_DB_UPDATE_FILE_PATTERN    "db_update_%1_%2_%3.sql"
 #define APP_DB_COMMENT_SPLIT          "-- !\n"
 #define APP_DB_NAME_PLACEHOLDER       "##"
@@ -119,6 +152,7 @@
 #define APP_CFG_FILE        "config.ini"
 
 #define APP_QUIT_INSTANCE   "-q"
+#define APP_DUMP_QUERIES    "-d"
 #define APP_IS_RUNNING      "app_is_running"
 #define APP_SKIN_USER_FOLDER "skins"
 #define APP_SKIN_DEFAULT    "vergilius"
@@ -175,6 +209,7 @@
 #define CAT_DB_ICON_INDEX         5
 #define CAT_DB_ACCOUNT_ID_INDEX   6
 #define CAT_DB_CUSTOM_ID_INDEX    7
+#define CAT_DB_ICON_DATA_INDEX    8
 
 // Indexes of columns as they are DEFINED IN THE TABLE for FEEDS.
 #define FDS_DB_ID_INDEX               0
@@ -193,6 +228,7 @@
 #define FDS_DB_TYPE_INDEX             13
 #define FDS_DB_ACCOUNT_ID_INDEX       14
 #define FDS_DB_CUSTOM_ID_INDEX        15
+#define FDS_DB_ICON_DATA_INDEX        16
 
 // Indexes of columns for feed models.
 #define FDS_MODEL_TITLE_INDEX           0
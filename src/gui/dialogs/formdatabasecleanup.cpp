@@ -35,6 +35,9 @@ FormDatabaseCleanup::FormDatabaseCleanup(QWidget *parent) : QDialog(parent), m_u
 
   connect(m_ui->m_spinDays, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &FormDatabaseCleanup::updateDaysSuffix);
   m_ui->m_spinDays->setValue(DEFAULT_DAYS_TO_DELETE_MSG);
+  connect(m_ui->m_spinArchiveDays, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+          this, &FormDatabaseCleanup::updateArchiveDaysSuffix);
+  m_ui->m_spinArchiveDays->setValue(DEFAULT_DAYS_TO_ARCHIVE_MSG);
   m_ui->m_lblResult->setStatus(WidgetWithStatus::Information, tr("I am ready."), tr("I am ready."));
   loadDatabaseInfo();
 }
@@ -56,6 +59,7 @@ void FormDatabaseCleanup::setCleaner(DatabaseCleaner *cleaner) {
   connect(m_cleaner, &DatabaseCleaner::purgeStarted, this, &FormDatabaseCleanup::onPurgeStarted);
   connect(m_cleaner, &DatabaseCleaner::purgeProgress, this, &FormDatabaseCleanup::onPurgeProgress);
   connect(m_cleaner, &DatabaseCleaner::purgeFinished, this,&FormDatabaseCleanup::onPurgeFinished);
+  connect(m_cleaner, &DatabaseCleaner::compactionProgress, this, &FormDatabaseCleanup::onCompactionProgress);
 }
 
 void FormDatabaseCleanup::closeEvent(QCloseEvent *event) {
@@ -80,6 +84,10 @@ void FormDatabaseCleanup::updateDaysSuffix(int number) {
   m_ui->m_spinDays->setSuffix(tr(" day(s)", 0, number));
 }
 
+void FormDatabaseCleanup::updateArchiveDaysSuffix(int number) {
+  m_ui->m_spinArchiveDays->setSuffix(tr(" day(s)", 0, number));
+}
+
 void FormDatabaseCleanup::startPurging() {
   CleanerOrders orders;
 
@@ -89,6 +97,10 @@ void FormDatabaseCleanup::startPurging() {
   orders.m_removeReadMessages = m_ui->m_checkRemoveReadMessages->isChecked();
   orders.m_shrinkDatabase = m_ui->m_checkShrink->isEnabled() && m_ui->m_checkShrink->isChecked();
   orders.m_removeStarredMessages = m_ui->m_checkRemoveStarredMessages->isChecked();
+  orders.m_compressContents = m_ui->m_checkCompressContents->isChecked();
+  orders.m_archiveOldMessages = m_ui->m_checkArchiveOldMessages->isEnabled() && m_ui->m_checkArchiveOldMessages->isChecked();
+  orders.m_barrierForArchivingOldMessagesInDays = m_ui->m_spinArchiveDays->value();
+  orders.m_reclaimFreeSpace = m_ui->m_checkReclaimFreeSpace->isEnabled() && m_ui->m_checkReclaimFreeSpace->isChecked();
 
   emit purgeRequested(orders);
 }
@@ -120,6 +132,23 @@ void FormDatabaseCleanup::onPurgeFinished(bool finished) {
   loadDatabaseInfo();
 }
 
+void FormDatabaseCleanup::onCompactionProgress(qint64 reclaimed_size, qint64 reclaimable_size) {
+  Q_UNUSED(reclaimed_size)
+
+  showReclaimableSize(reclaimable_size);
+}
+
+void FormDatabaseCleanup::showReclaimableSize(qint64 reclaimable_size) {
+  const QString reclaimable_size_str = QString::number(reclaimable_size / 1000000.0) + QL1S(" MB");
+
+  if (m_ui->m_checkReclaimFreeSpace->isEnabled()) {
+    m_ui->m_txtReclaimableSize->setText(reclaimable_size_str);
+  }
+  else {
+    m_ui->m_txtReclaimableSize->setText(tr("%1, shrink database file to reclaim it").arg(reclaimable_size_str));
+  }
+}
+
 void FormDatabaseCleanup::loadDatabaseInfo() {
   qint64 file_size = qApp->database()->getDatabaseFileSize();
   qint64 data_size = qApp->database()->getDatabaseDataSize();
@@ -131,5 +160,17 @@ void FormDatabaseCleanup::loadDatabaseInfo() {
   m_ui->m_txtDatabaseType->setText(qApp->database()->humanDriverName(qApp->database()->activeDatabaseDriver()));
   m_ui->m_checkShrink->setEnabled(qApp->database()->activeDatabaseDriver() == DatabaseFactory::SQLITE ||
                                   qApp->database()->activeDatabaseDriver() == DatabaseFactory::SQLITE_MEMORY);
-  m_ui->m_checkShrink->setChecked(m_ui->m_checkShrink->isEnabled());
+
+  // Free space is reclaimed in steps only if database file supports it,
+  // otherwise whole file must be rewritten.
+  m_ui->m_checkReclaimFreeSpace->setEnabled(qApp->database()->sqliteIncrementalVacuumEnabled());
+  m_ui->m_checkReclaimFreeSpace->setChecked(m_ui->m_checkReclaimFreeSpace->isEnabled());
+  m_ui->m_checkShrink->setChecked(m_ui->m_checkShrink->isEnabled() && !m_ui->m_checkReclaimFreeSpace->isEnabled());
+  m_ui->m_lblReclaimableSize->setVisible(m_ui->m_checkShrink->isEnabled());
+  m_ui->m_txtReclaimableSize->setVisible(m_ui->m_checkShrink->isEnabled());
+  showReclaimableSize(qApp->database()->getDatabaseReclaimableSize());
+
+  // Archives are separate SQLite files, they are not available for MySQL.
+  m_ui->m_checkArchiveOldMessages->setEnabled(m_ui->m_checkShrink->isEnabled());
+  m_ui->m_spinArchiveDays->setEnabled(m_ui->m_checkShrink->isEnabled());
 }
@@ -41,16 +41,19 @@ class FormDatabaseCleanup : public QDialog {
 
   private slots:
     void updateDaysSuffix(int number);
+    void updateArchiveDaysSuffix(int number);
     void startPurging();
     void onPurgeStarted();
     void onPurgeProgress(int progress, const QString &description);
     void onPurgeFinished(bool finished);
+    void onCompactionProgress(qint64 reclaimed_size, qint64 reclaimable_size);
 
   signals:
     void purgeRequested(const CleanerOrders &which_data);
 
   private:
     void loadDatabaseInfo();
+    void showReclaimableSize(qint64 reclaimable_size);
 
   private:
     QScopedPointer<Ui::FormDatabaseCleanup> m_ui;
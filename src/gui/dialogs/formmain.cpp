@@ -351,10 +351,8 @@ void FormMain::updateAccountsMenu() {
 }
 
 void FormMain::onFeedUpdatesFinished(const FeedDownloadResults &results) {
-  Q_UNUSED(results)
-
   statusBar()->clearProgressFeeds();
-  tabWidget()->feedMessageViewer()->messagesView()->reloadSelections();
+  tabWidget()->feedMessageViewer()->messagesView()->refreshMessages(results.insertedMessages(), results.updatedMessages());
 }
 
 void FormMain::onFeedUpdatesStarted() {
@@ -368,6 +366,20 @@ void FormMain::onFeedUpdatesProgress(const Feed *feed, int current, int total) {
                                  tr("Updated feed '%1'").arg(feed->title()));
 }
 
+void FormMain::onMessagesBulkOperationStarted() {
+  statusBar()->showProgressFeeds(0, tr("Storing changes of messages"));
+}
+
+void FormMain::onMessagesBulkOperationProgress(int processed, int total) {
+  statusBar()->showProgressFeeds((processed * 100.0) / total,
+                                 //: Text display in status bar when changes of many messages are stored.
+                                 tr("Stored changes of %1/%2 messages").arg(QString::number(processed), QString::number(total)));
+}
+
+void FormMain::onMessagesBulkOperationFinished() {
+  statusBar()->clearProgressFeeds();
+}
+
 void FormMain::updateMessageButtonsAvailability() {
   const bool one_message_selected = tabWidget()->feedMessageViewer()->messagesView()->selectionModel()->selectedRows().size() == 1;
   const bool atleast_one_message_selected = !tabWidget()->feedMessageViewer()->messagesView()->selectionModel()->selectedRows().isEmpty();
@@ -635,6 +647,13 @@ void FormMain::createConnections() {
   connect(qApp->feedReader(), &FeedReader::feedUpdatesProgress, this, &FormMain::onFeedUpdatesProgress);
   connect(qApp->feedReader(), &FeedReader::feedUpdatesFinished, this, &FormMain::onFeedUpdatesFinished);
 
+  connect(qApp->feedReader()->messagesModel(), &MessagesModel::bulkOperationStarted,
+          this, &FormMain::onMessagesBulkOperationStarted);
+  connect(qApp->feedReader()->messagesModel(), &MessagesModel::bulkOperationProgress,
+          this, &FormMain::onMessagesBulkOperationProgress);
+  connect(qApp->feedReader()->messagesModel(), &MessagesModel::bulkOperationFinished,
+          this, &FormMain::onMessagesBulkOperationFinished);
+
   // Toolbar forwardings.
   connect(m_ui->m_actionAddFeedIntoSelectedAccount, &QAction::triggered,
           tabWidget()->feedMessageViewer()->feedsView(), &FeedsView::addFeedIntoSelectedAccount);
@@ -77,6 +77,10 @@ class FormMain : public QMainWindow {
     void onFeedUpdatesProgress(const Feed *feed, int current, int total);
     void onFeedUpdatesFinished(const FeedDownloadResults &results);
 
+    void onMessagesBulkOperationStarted();
+    void onMessagesBulkOperationProgress(int processed, int total);
+    void onMessagesBulkOperationFinished();
+
     // Displays various dialogs.
     void backupDatabaseSettings();
     void restoreDatabaseSettings();
@@ -193,6 +193,7 @@ void FeedMessageViewer::createConnections() {
   // Filtering & searching.
   connect(m_toolBarMessages, &MessagesToolBar::messageSearchPatternChanged, m_messagesView, &MessagesView::searchMessages);
   connect(m_toolBarMessages, &MessagesToolBar::messageFilterChanged, m_messagesView, &MessagesView::filterMessages);
+  connect(m_toolBarMessages, &MessagesToolBar::archiveInclusionChanged, m_messagesView, &MessagesView::includeArchivedMessages);
   
 #if defined(USE_WEBENGINE)
   connect(m_messagesView, &MessagesView::currentMessageRemoved, m_messagesBrowser, &WebBrowser::clear);
@@ -204,6 +205,8 @@ void FeedMessageViewer::createConnections() {
 #else
   connect(m_messagesView, &MessagesView::currentMessageRemoved, m_messagesBrowser, &MessagePreviewer::clear);
   connect(m_messagesView, &MessagesView::currentMessageChanged, m_messagesBrowser, &MessagePreviewer::loadMessage);
+  connect(m_messagesView->sourceModel(), &MessagesModel::messagesPrefetched,
+          m_messagesBrowser, &MessagePreviewer::prepareMessages);
   connect(m_messagesBrowser, &MessagePreviewer::markMessageRead,
           m_messagesView->sourceModel(), &MessagesModel::setMessageReadById);
   connect(m_messagesBrowser, &MessagePreviewer::markMessageImportant,
@@ -20,6 +20,7 @@
 #include "miscellaneous/application.h"
 #include "network-web/webfactory.h"
 #include "miscellaneous/databasequeries.h"
+#include "miscellaneous/messagehtmlcache.h"
 #include "gui/messagebox.h"
 #include "gui/dialogs/formmain.h"
 #include "services/abstract/serviceroot.h"
@@ -27,6 +28,7 @@
 #include <QScrollBar>
 #include <QToolBar>
 #include <QToolTip>
+#include <QtConcurrent/QtConcurrentRun>
 
 
 void MessagePreviewer::createConnections() {
@@ -99,7 +101,8 @@ void MessagePreviewer::createConnections() {
 }
 
 MessagePreviewer::MessagePreviewer(QWidget *parent) : QWidget(parent),
-  m_ui(new Ui::MessagePreviewer), m_pictures(QStringList()) {
+  m_ui(new Ui::MessagePreviewer), m_preparedWatcher(new QFutureWatcher<void>(this)),
+  m_pendingMessages(QList<Message>()) {
   m_ui->setupUi(this);
   m_ui->m_txtMessage->viewport()->setAutoFillBackground(true);
   m_toolBar = new QToolBar(this);
@@ -107,6 +110,7 @@ MessagePreviewer::MessagePreviewer(QWidget *parent) : QWidget(parent),
   m_ui->m_layout->addWidget(m_toolBar, 0, 0, -1, 1);
 
   createConnections();
+  connect(m_preparedWatcher, &QFutureWatcher<void>::finished, this, &MessagePreviewer::onMessagesPrepared);
 
   m_actionSwitchImportance->setCheckable(true);
 
@@ -115,6 +119,7 @@ MessagePreviewer::MessagePreviewer(QWidget *parent) : QWidget(parent),
 }
 
 MessagePreviewer::~MessagePreviewer() {
+  m_preparedWatcher->waitForFinished();
 }
 
 void MessagePreviewer::reloadFontSettings() {
@@ -129,7 +134,6 @@ void MessagePreviewer::reloadFontSettings() {
 
 void MessagePreviewer::clear() {
   m_ui->m_txtMessage->clear();
-  m_pictures.clear();
   hide();
 }
 
@@ -143,7 +147,7 @@ void MessagePreviewer::loadMessage(const Message &message, RootItem *root) {
 
   if (!m_root.isNull()) {
     m_actionSwitchImportance->setChecked(m_message.m_isImportant);
-    m_ui->m_txtMessage->setHtml(prepareHtmlForMessage(m_message));
+    m_ui->m_txtMessage->setHtml(htmlForMessage(m_message));
 
     updateButtons();
     show();
@@ -152,6 +156,30 @@ void MessagePreviewer::loadMessage(const Message &message, RootItem *root) {
   }
 }
 
+void MessagePreviewer::prepareMessages(const QList<Message> &messages) {
+  if (m_preparedWatcher->isRunning()) {
+    // Older pending request is dropped, its messages are not adjacent anymore.
+    m_pendingMessages = messages;
+    return;
+  }
+
+  // Prepared HTML is stored in cache.
+  m_preparedWatcher->setFuture(QtConcurrent::run([messages] {
+    foreach (const Message &message, messages) {
+      htmlForMessage(message);
+    }
+  }));
+}
+
+void MessagePreviewer::onMessagesPrepared() {
+  if (!m_pendingMessages.isEmpty()) {
+    const QList<Message> pending_messages = m_pendingMessages;
+
+    m_pendingMessages.clear();
+    prepareMessages(pending_messages);
+  }
+}
+
 void MessagePreviewer::markMessageAsRead() {
   markMessageAsReadUnread(RootItem::Read);
 }
@@ -206,6 +234,17 @@ void MessagePreviewer::updateButtons() {
   m_actionMarkUnread->setEnabled(m_message.m_isRead);
 }
 
+QString MessagePreviewer::htmlForMessage(const Message &message) {
+  QString html = MessageHtmlCache::html(message, QSL("previewer"));
+
+  if (html.isNull()) {
+    html = prepareHtmlForMessage(message);
+    MessageHtmlCache::insert(message, QSL("previewer"), html);
+  }
+
+  return html;
+}
+
 QString MessagePreviewer::prepareHtmlForMessage(const Message &message) {
   QString html = QString("<h2 align=\"center\">%1</h2>").arg(message.m_title);
 
@@ -221,8 +260,6 @@ QString MessagePreviewer::prepareHtmlForMessage(const Message &message) {
   imgTagRegex.setMinimal(true);
 
   while( (offset = imgTagRegex.indexIn(message.m_contents, offset)) != -1){
-    m_pictures.append(imgTagRegex.cap(1));
-
     offset += imgTagRegex.matchedLength();
     html += QString("[%2] <a href=\"%1\">%1</a><br/>").arg(imgTagRegex.cap(1), tr("image"));
   }
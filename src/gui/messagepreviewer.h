@@ -26,6 +26,7 @@
 #include "services/abstract/rootitem.h"
 
 #include <QPointer>
+#include <QFutureWatcher>
 
 
 namespace Ui {
@@ -48,7 +49,12 @@ class MessagePreviewer : public QWidget {
     void hideToolbar();
     void loadMessage(const Message &message, RootItem *root);
 
+    // Prepares HTML of given messages in worker thread,
+    // so that they are displayed instantly once they get selected.
+    void prepareMessages(const QList<Message> &messages);
+
   private slots:
+    void onMessagesPrepared();
     void markMessageAsRead();
     void markMessageAsUnread();
     void markMessageAsReadUnread(RootItem::ReadStatus read);
@@ -62,13 +68,20 @@ class MessagePreviewer : public QWidget {
   private:
     void createConnections();
     void updateButtons();
-    QString prepareHtmlForMessage(const Message &message);
+    static QString prepareHtmlForMessage(const Message &message);
+
+    // Returns HTML of message from cache, message is rendered if it is not there.
+    static QString htmlForMessage(const Message &message);
 
     QToolBar *m_toolBar;
     QScopedPointer<Ui::MessagePreviewer> m_ui;
     Message m_message;
-    QStringList m_pictures;
     QPointer<RootItem> m_root;
+    QFutureWatcher<void> *m_preparedWatcher;
+
+    // Messages requested while other ones are being prepared,
+    // only the newest request is kept.
+    QList<Message> m_pendingMessages;
 
     QAction *m_actionMarkRead;
     QAction *m_actionMarkUnread;
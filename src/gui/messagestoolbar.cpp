@@ -32,6 +32,7 @@ MessagesToolBar::MessagesToolBar(const QString &title, QWidget *parent)
   : BaseToolBar(title, parent) {
   initializeSearchBox();
   initializeHighlighter();
+  initializeArchiveInclusion();
 }
 
 MessagesToolBar::~MessagesToolBar() {
@@ -42,6 +43,7 @@ QList<QAction*> MessagesToolBar::availableActions() const {
 
   available_actions.append(m_actionSearchMessages);
   available_actions.append(m_actionMessageHighlighter);
+  available_actions.append(m_actionIncludeArchivedMessages);
 
   return available_actions;
 }
@@ -161,6 +163,16 @@ void MessagesToolBar::initializeHighlighter() {
           this, SLOT(handleMessageHighlighterChange(QAction*)));
 }
 
+void MessagesToolBar::initializeArchiveInclusion() {
+  m_actionIncludeArchivedMessages = new QAction(qApp->icons()->fromTheme(QSL("document-open-recent")),
+                                                tr("Include archived messages"), this);
+  m_actionIncludeArchivedMessages->setObjectName(QSL("m_actionIncludeArchivedMessages"));
+  m_actionIncludeArchivedMessages->setToolTip(tr("Display and search also messages moved to archive by database cleanup"));
+  m_actionIncludeArchivedMessages->setCheckable(true);
+
+  connect(m_actionIncludeArchivedMessages, &QAction::toggled, this, &MessagesToolBar::archiveInclusionChanged);
+}
+
 QStringList MessagesToolBar::defaultActions() const {
   return QString(GUI::MessagesToolbarDefaultButtonsDef).split(',',
                                                               QString::SkipEmptyParts);
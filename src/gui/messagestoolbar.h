@@ -62,6 +62,9 @@ class MessagesToolBar : public BaseToolBar {
     // Emitted if message filter is changed.
     void messageFilterChanged(MessagesModel::MessageHighlighter filter);
 
+    // Emitted if archived messages should be shown or hidden.
+    void archiveInclusionChanged(bool include);
+
   private slots:
     // Called when highlighter gets changed.
     void handleMessageHighlighterChange(QAction *action);
@@ -69,12 +72,15 @@ class MessagesToolBar : public BaseToolBar {
   private:
     void initializeSearchBox();
     void initializeHighlighter();
+    void initializeArchiveInclusion();
 
   private:
     QWidgetAction *m_actionMessageHighlighter;
     QToolButton *m_btnMessageHighlighter;
     QMenu *m_menuMessageHighlighter;
 
+    QAction *m_actionIncludeArchivedMessages;
+
     QWidgetAction *m_actionSearchMessages;
     MessagesSearchLineEdit *m_txtSearchMessages;
 };
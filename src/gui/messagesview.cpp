@@ -78,6 +78,7 @@ void MessagesView::createConnections() {
   // Adjust columns when layout gets changed.
   connect(header(), &QHeaderView::geometriesChanged, this, &MessagesView::adjustColumns);
   connect(header(), &QHeaderView::sortIndicatorChanged, this, &MessagesView::onSortIndicatorChanged);
+  connect(m_sourceModel, &MessagesModel::searchFinished, this, &MessagesView::onSearchFinished);
 }
 
 void MessagesView::keyboardSearch(const QString &search) {
@@ -102,24 +103,11 @@ void MessagesView::reloadSelections() {
 
   // Now, we must find the same previously focused message.
   if (selected_message.m_id > 0) {
-    if (m_proxyModel->rowCount() == 0) {
-      current_index = QModelIndex();
-    }
-    else {
-      for (int i = 0; i < m_proxyModel->rowCount(); i++) {
-        QModelIndex msg_idx = m_proxyModel->index(i, MSG_DB_TITLE_INDEX);
-        Message msg = m_sourceModel->messageAt(m_proxyModel->mapToSource(msg_idx).row());
-
-        if (msg.m_id == selected_message.m_id) {
-          current_index = msg_idx;
-          break;
-        }
+    const int row = m_sourceModel->rowOfMessage(selected_message.m_id);
 
-        if (i == m_proxyModel->rowCount() - 1) {
-          current_index = QModelIndex();
-        }
-      }
-    }
+    current_index = row < 0 ?
+                    QModelIndex() :
+                    m_proxyModel->mapFromSource(m_sourceModel->index(row, MSG_DB_TITLE_INDEX));
   }
 
   if (current_index.isValid()) {
@@ -138,6 +126,12 @@ void MessagesView::reloadSelections() {
   qDebug("Reloading of msg selections took %lld miliseconds.", dt1.msecsTo(dt2));
 }
 
+void MessagesView::refreshMessages(const QList<int> &inserted_ids, const QList<int> &updated_ids) {
+  if (!m_sourceModel->refreshMessages(inserted_ids, updated_ids)) {
+    reloadSelections();
+  }
+}
+
 void MessagesView::setupAppearance() {
   setUniformRowHeights(true);
   setAcceptDrops(false);
@@ -212,11 +206,12 @@ void MessagesView::mousePressEvent(QMouseEvent *event) {
       const QModelIndex clicked_index = indexAt(event->pos());
 
       if (clicked_index.isValid()) {
-        const QModelIndex mapped_index = m_proxyModel->mapToSource(clicked_index);
+        // Message can move to another row if messages are sorted by importance.
+        const QPersistentModelIndex mapped_index = m_proxyModel->mapToSource(clicked_index);
 
         if (mapped_index.column() == MSG_DB_IMPORTANT_INDEX) {
           if (m_sourceModel->switchMessageImportance(mapped_index.row())) {
-            emit currentMessageChanged(m_sourceModel->messageAt(mapped_index.row()), m_sourceModel->loadedItem());
+            emit currentMessageChanged(m_sourceModel->messageWithBodyAt(mapped_index.row()), m_sourceModel->loadedItem());
           }
         }
       }
@@ -257,7 +252,7 @@ void MessagesView::selectionChanged(const QItemSelection &selected, const QItemS
          mapped_current_index.row(), mapped_current_index.column());
 
   if (mapped_current_index.isValid() && selected_rows.count() > 0) {
-    Message message = m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row());
+    Message message = m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row());
 
     // Set this message as read only if current item
     // wasn't changed by "mark selected messages unread" action.
@@ -265,6 +260,9 @@ void MessagesView::selectionChanged(const QItemSelection &selected, const QItemS
     message.m_isRead = true;
 
     emit currentMessageChanged(message, m_sourceModel->loadedItem());
+
+    // Current message can move to another row if messages are sorted by read state.
+    prefetchAdjacentMessages(currentIndex());
   }
   else {
     emit currentMessageRemoved();
@@ -277,6 +275,27 @@ void MessagesView::selectionChanged(const QItemSelection &selected, const QItemS
   QTreeView::selectionChanged(selected, deselected);
 }
 
+void MessagesView::prefetchAdjacentMessages(const QModelIndex &current_index) {
+  const int row_count = m_proxyModel->rowCount();
+  QList<int> rows;
+
+  // Nearest messages are loaded first.
+  for (int distance = 1; distance <= MESSAGES_PREFETCH_COUNT; distance++) {
+    const int next_row = current_index.row() + distance;
+    const int previous_row = current_index.row() - distance;
+
+    if (next_row < row_count) {
+      rows.append(m_proxyModel->mapToSource(m_proxyModel->index(next_row, 0)).row());
+    }
+
+    if (previous_row >= 0) {
+      rows.append(m_proxyModel->mapToSource(m_proxyModel->index(previous_row, 0)).row());
+    }
+  }
+
+  m_sourceModel->prefetchMessages(rows);
+}
+
 void MessagesView::loadItem(RootItem *item) {
   const int col = header()->sortIndicatorSection();
   const Qt::SortOrder ord = header()->sortIndicatorOrder();
@@ -324,7 +343,7 @@ void MessagesView::openSelectedMessagesInternally() {
 
 void MessagesView::sendSelectedMessageViaEmail() {
   if (selectionModel()->selectedRows().size() == 1) {
-    const Message message = m_sourceModel->messageAt(m_proxyModel->mapToSource(selectionModel()->selectedRows().at(0)).row());
+    const Message message = m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(selectionModel()->selectedRows().at(0)).row());
 
     if (!WebFactory::instance()->sendMessageViaEmail(message)) {
       MessageBox::show(this,
@@ -354,10 +373,10 @@ void MessagesView::setSelectedMessagesReadStatus(RootItem::ReadStatus read) {
   const QModelIndexList mapped_indexes = m_proxyModel->mapListToSource(selected_indexes);
 
   m_sourceModel->setBatchMessagesRead(mapped_indexes, read);
-  current_index = m_proxyModel->index(current_index.row(), current_index.column());
+  current_index = selectionModel()->currentIndex();
 
   if (current_index.isValid()) {
-    emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
+    emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
   }
   else {
     emit currentMessageRemoved();
@@ -379,7 +398,7 @@ void MessagesView::deleteSelectedMessages() {
 
   if (current_index.isValid()) {
     setCurrentIndex(current_index);
-    emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
+    emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
   }
   else {
     emit currentMessageRemoved();
@@ -400,7 +419,7 @@ void MessagesView::restoreSelectedMessages() {
   current_index = m_proxyModel->index(current_index.row(), current_index.column());
 
   if (current_index.isValid()) {
-    emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
+    emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
 
   }
   else {
@@ -419,10 +438,10 @@ void MessagesView::switchSelectedMessagesImportance() {
   const QModelIndexList mapped_indexes = m_proxyModel->mapListToSource(selected_indexes);
 
   m_sourceModel->switchBatchMessageImportance(mapped_indexes);
-  current_index = m_proxyModel->index(current_index.row(), current_index.column());
+  current_index = selectionModel()->currentIndex();
 
   if (current_index.isValid()) {
-    emit currentMessageChanged(m_sourceModel->messageAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
+    emit currentMessageChanged(m_sourceModel->messageWithBodyAt(m_proxyModel->mapToSource(current_index).row()), m_sourceModel->loadedItem());
   }
   else {
     // Messages were probably removed from the model, nothing can
@@ -488,7 +507,16 @@ void MessagesView::selectNextUnreadItem() {
 }
 
 void MessagesView::searchMessages(const QString &pattern) {
-  m_proxyModel->setFilterRegExp(pattern);
+  m_sourceModel->searchMessages(pattern);
+}
+
+void MessagesView::onSearchFinished(bool truncated) {
+  if (truncated) {
+    qApp->showGuiMessage(tr("Too many messages found"),
+                         tr("Only %1 most relevant messages matching the search are displayed, "
+                            "refine the search to see the others.").arg(MESSAGES_SEARCH_LIMIT),
+                         QSystemTrayIcon::Information, qApp->mainFormWidget());
+  }
 
   if (selectionModel()->selectedRows().size() == 0) {
     emit currentMessageRemoved();
@@ -503,6 +531,14 @@ void MessagesView::filterMessages(MessagesModel::MessageHighlighter filter) {
   m_sourceModel->highlightMessages(filter);
 }
 
+void MessagesView::includeArchivedMessages(bool include) {
+  m_sourceModel->setArchiveIncluded(include);
+
+  if (selectionModel()->selectedRows().size() == 0) {
+    emit currentMessageRemoved();
+  }
+}
+
 void MessagesView::adjustColumns() {
   if (header()->count() > 0 && !m_columnsAdjusted) {
     m_columnsAdjusted = true;
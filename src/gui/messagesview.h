@@ -52,6 +52,10 @@ class MessagesView : public QTreeView {
     // and it needs to be reloaded to the view.
     void reloadSelections();
 
+    // Called after feeds were updated, only inserted and updated
+    // messages are refreshed if possible, so that selection is kept.
+    void refreshMessages(const QList<int> &inserted_ids, const QList<int> &updated_ids);
+
     // Loads un-deleted messages from selected feeds.
     void loadItem(RootItem *item);
 
@@ -76,6 +80,9 @@ class MessagesView : public QTreeView {
     void searchMessages(const QString &pattern);
     void filterMessages(MessagesModel::MessageHighlighter filter);
 
+    // Shows or hides archived messages.
+    void includeArchivedMessages(bool include);
+
   private slots:
     // Marks given indexes as selected.
     void reselectIndexes(const QModelIndexList &indexes);
@@ -86,6 +93,9 @@ class MessagesView : public QTreeView {
     // Saves current sort state.
     void onSortIndicatorChanged(int column, Qt::SortOrder order);
 
+    // Keeps selected message visible after search results were applied.
+    void onSearchFinished(bool truncated);
+
   signals:
     // Link/message openers.
     void openLinkNewTab(const QString &link);
@@ -99,6 +109,10 @@ class MessagesView : public QTreeView {
   private:
     void sort(int column, Qt::SortOrder order, bool repopulate_data, bool change_header, bool emit_changed_from_header);
 
+    // Starts loading of messages around given one, so that
+    // moving to them does not have to wait for DB.
+    void prefetchAdjacentMessages(const QModelIndex &current_index);
+
     // Creates needed connections.
     void createConnections();
 
@@ -18,48 +18,126 @@
 #include "gui/newspaperpreviewer.h"
 
 #include "gui/messagepreviewer.h"
-#include "gui/dialogs/formmain.h"
 #include "miscellaneous/application.h"
+#include "miscellaneous/databasefactory.h"
+#include "miscellaneous/databasequeries.h"
 
 #include <QScrollBar>
 
 
 NewspaperPreviewer::NewspaperPreviewer(RootItem *root, QList<Message> messages, QWidget *parent)
-  : TabContent(parent), m_ui(new Ui::NewspaperPreviewer), m_root(root), m_messages(messages) {
-  m_ui->setupUi(this); 
-  connect(m_ui->m_btnShowMoreMessages, &QPushButton::clicked, this, &NewspaperPreviewer::showMoreMessages);
-  showMoreMessages();
+  : TabContent(parent), m_ui(new Ui::NewspaperPreviewer), m_root(root), m_messageIds(QVector<int>()),
+    m_accountIds(QVector<int>()), m_displayedPreviewers(QHash<int,MessagePreviewer*>()),
+    m_freePreviewers(QList<MessagePreviewer*>()) {
+  m_messageIds.reserve(messages.size());
+  m_accountIds.reserve(messages.size());
+
+  foreach (const Message &message, messages) {
+    m_messageIds.append(message.m_id);
+    m_accountIds.append(message.m_accountId);
+  }
+
+  m_ui->setupUi(this);
+  m_ui->m_viewport->installEventFilter(this);
+  m_ui->m_scrollBar->setSingleStep(NEWSPAPER_MESSAGE_HEIGHT / 10);
+
+  connect(m_ui->m_scrollBar, &QScrollBar::valueChanged, this, &NewspaperPreviewer::layoutMessages);
 }
 
 NewspaperPreviewer::~NewspaperPreviewer() {
 }
 
-void NewspaperPreviewer::showMoreMessages() {
-  if (!m_root.isNull()) {
-    int current_scroll = m_ui->scrollArea->verticalScrollBar()->value();
+bool NewspaperPreviewer::eventFilter(QObject *watched, QEvent *event) {
+  if (watched == m_ui->m_viewport) {
+    if (event->type() == QEvent::Resize) {
+      updateScrollRange();
+      layoutMessages();
+    }
+    else if (event->type() == QEvent::Wheel) {
+      // Wheel events not consumed by previewers scroll the whole view.
+      qApp->sendEvent(m_ui->m_scrollBar, event);
+      return true;
+    }
+  }
+
+  return TabContent::eventFilter(watched, event);
+}
 
-    for (int i = 0; i < 10 && !m_messages.isEmpty(); i++) {
-      Message msg = m_messages.takeFirst();
-      MessagePreviewer *prev = new MessagePreviewer(this);
-      QMargins margins = prev->layout()->contentsMargins();
+void NewspaperPreviewer::layoutMessages() {
+  if (m_messageIds.isEmpty()) {
+    return;
+  }
 
-      connect(prev, &MessagePreviewer::requestMessageListReload, this, &NewspaperPreviewer::requestMessageListReload);
+  const int offset = m_ui->m_scrollBar->value();
+  const int first_row = offset / NEWSPAPER_MESSAGE_HEIGHT;
+  const int last_row = qMin(m_messageIds.size() - 1, (offset + m_ui->m_viewport->height()) / NEWSPAPER_MESSAGE_HEIGHT);
+  QHash<int,MessagePreviewer*> displayed_previewers;
 
-      margins.setRight(0);
-      prev->layout()->setContentsMargins(margins);
-      prev->setFixedHeight(300);
-      prev->loadMessage(msg, m_root);
-      m_ui->m_layout->insertWidget(m_ui->m_layout->count() - 2, prev);
+  // Previewers of messages which got scrolled out are recycled.
+  for (QHash<int,MessagePreviewer*>::const_iterator i = m_displayedPreviewers.constBegin(); i != m_displayedPreviewers.constEnd(); i++) {
+    if (i.key() >= first_row && i.key() <= last_row) {
+      displayed_previewers.insert(i.key(), i.value());
     }
+    else {
+      i.value()->hide();
+      m_freePreviewers.append(i.value());
+    }
+  }
 
-    m_ui->m_btnShowMoreMessages->setText(tr("Show more messages (%n remaining)", "", m_messages.size()));
-    m_ui->m_btnShowMoreMessages->setEnabled(!m_messages.isEmpty());
-    m_ui->scrollArea->verticalScrollBar()->setValue(current_scroll);
+  QList<int> new_rows;
+  QList<Message> new_messages;
+
+  for (int row = first_row; row <= last_row; row++) {
+    if (!displayed_previewers.contains(row)) {
+      Message message;
+
+      message.m_id = m_messageIds.at(row);
+      message.m_accountId = m_accountIds.at(row);
+      new_rows.append(row);
+      new_messages.append(message);
+    }
   }
-  else {
-    qApp->showGuiMessage(tr("Cannot show more messages"),
-                         tr("Cannot show more messages because parent feed was removed."),
-                         QSystemTrayIcon::Warning,
-                         qApp->mainForm(), true);
+
+  // Messages which got displayed are loaded at once, with their current states.
+  if (!new_messages.isEmpty() &&
+      !DatabaseQueries::loadMessagesWithBodies(qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings),
+                                               new_messages)) {
+    qWarning("Loading of %d messages for newspaper view failed.", new_messages.size());
+
+    for (int i = 0; i < new_messages.size(); i++) {
+      new_messages[i].m_contents = tr("Message cannot be loaded from database.");
+    }
+  }
+
+  for (int i = 0; i < new_rows.size(); i++) {
+    MessagePreviewer *previewer = m_freePreviewers.isEmpty() ? createPreviewer() : m_freePreviewers.takeLast();
+
+    previewer->loadMessage(new_messages.at(i), m_root);
+    displayed_previewers.insert(new_rows.at(i), previewer);
+  }
+
+  for (int row = first_row; row <= last_row; row++) {
+    displayed_previewers.value(row)->setGeometry(0, row * NEWSPAPER_MESSAGE_HEIGHT - offset,
+                                                 m_ui->m_viewport->width(), NEWSPAPER_MESSAGE_HEIGHT);
   }
+
+  m_displayedPreviewers = displayed_previewers;
+}
+
+void NewspaperPreviewer::updateScrollRange() {
+  const int viewport_height = m_ui->m_viewport->height();
+
+  m_ui->m_scrollBar->setRange(0, qMax(0, m_messageIds.size() * NEWSPAPER_MESSAGE_HEIGHT - viewport_height));
+  m_ui->m_scrollBar->setPageStep(viewport_height);
+}
+
+MessagePreviewer *NewspaperPreviewer::createPreviewer() {
+  MessagePreviewer *previewer = new MessagePreviewer(m_ui->m_viewport);
+  QMargins margins = previewer->layout()->contentsMargins();
+
+  connect(previewer, &MessagePreviewer::requestMessageListReload, this, &NewspaperPreviewer::requestMessageListReload);
+
+  margins.setRight(0);
+  previewer->layout()->setContentsMargins(margins);
+  return previewer;
 }
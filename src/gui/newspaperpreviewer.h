@@ -28,6 +28,8 @@
 #include "services/abstract/rootitem.h"
 
 #include <QPointer>
+#include <QHash>
+#include <QVector>
 
 
 namespace Ui {
@@ -35,7 +37,11 @@ namespace Ui {
 }
 
 class RootItem;
+class MessagePreviewer;
 
+// Newspaper view which displays only messages visible in its viewport.
+// Small pool of previewers is reused while scrolling. Only IDs of messages
+// are kept, messages are loaded from DB once they get displayed.
 class NewspaperPreviewer : public TabContent {
     Q_OBJECT
 
@@ -43,16 +49,31 @@ class NewspaperPreviewer : public TabContent {
     explicit NewspaperPreviewer(RootItem *root, QList<Message> messages, QWidget *parent = 0);
     virtual ~NewspaperPreviewer();
 
+  protected:
+    bool eventFilter(QObject *watched, QEvent *event);
+
   private slots:
-    void showMoreMessages();
+    // Displays messages which are visible for current scroll position.
+    void layoutMessages();
 
   signals:
     void requestMessageListReload(bool mark_current_as_read);
 
   private:
+    void updateScrollRange();
+    MessagePreviewer *createPreviewer();
+
     QScopedPointer<Ui::NewspaperPreviewer> m_ui;
     QPointer<RootItem> m_root;
-    QList<Message> m_messages;
+
+    // IDs of messages and IDs of their accounts, whose
+    // archives are searched for archived messages.
+    QVector<int> m_messageIds;
+    QVector<int> m_accountIds;
+
+    // Previewers of displayed rows and previewers which can be reused.
+    QHash<int,MessagePreviewer*> m_displayedPreviewers;
+    QList<MessagePreviewer*> m_freePreviewers;
 };
 
 #endif // NEWSPAPERPREVIEWER_H
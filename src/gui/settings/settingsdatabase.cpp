@@ -38,6 +38,7 @@ SettingsDatabase::SettingsDatabase(Settings *settings, QWidget *parent)
   connect(m_ui->m_txtMysqlHostname->lineEdit(), &QLineEdit::textChanged, this, &SettingsDatabase::dirtifySettings);
   connect(m_ui->m_txtMysqlPassword->lineEdit(), &QLineEdit::textChanged, this, &SettingsDatabase::dirtifySettings);
   connect(m_ui->m_checkUseTransactions, &QCheckBox::toggled, this, &SettingsDatabase::dirtifySettings);
+  connect(m_ui->m_checkCompressMessageContents, &QCheckBox::toggled, this, &SettingsDatabase::dirtifySettings);
   connect(m_ui->m_txtMysqlUsername->lineEdit(), &QLineEdit::textChanged, this, &SettingsDatabase::dirtifySettings);
   connect(m_ui->m_spinMysqlPort, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &SettingsDatabase::dirtifySettings);
 
@@ -140,6 +141,7 @@ void SettingsDatabase::loadSettings() {
   onBeginLoadSettings();
 
   m_ui->m_checkUseTransactions->setChecked(qApp->settings()->value(GROUP(Database), SETTING(Database::UseTransactions)).toBool());
+  m_ui->m_checkCompressMessageContents->setChecked(qApp->settings()->value(GROUP(Database), SETTING(Database::CompressMessageContents)).toBool());
   m_ui->m_lblMysqlTestResult->setStatus(WidgetWithStatus::Information,  tr("No connection test triggered so far."), tr("You did not executed any connection test yet."));
 
   // Load SQLite.
@@ -189,6 +191,7 @@ void SettingsDatabase::saveSettings() {
   const bool new_inmemory = m_ui->m_checkSqliteUseInMemoryDatabase->isChecked();
 
   qApp->settings()->setValue(GROUP(Database), Database::UseTransactions, m_ui->m_checkUseTransactions->isChecked());
+  qApp->settings()->setValue(GROUP(Database), Database::CompressMessageContents, m_ui->m_checkCompressMessageContents->isChecked());
 
   // Save data storage settings.
   QString original_db_driver = settings()->value(GROUP(Database), SETTING(Database::ActiveDriver)).toString();
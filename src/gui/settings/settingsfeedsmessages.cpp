@@ -20,6 +20,7 @@
 #include "definitions/definitions.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/feedreader.h"
+#include "miscellaneous/messagehtmlcache.h"
 #include "gui/dialogs/formmain.h"
 #include "gui/feedmessageviewer.h"
 #include "gui/feedsview.h"
@@ -144,6 +145,9 @@ void SettingsFeedsMessages::saveSettings() {
   qApp->feedReader()->updateAutoUpdateStatus();
   qApp->feedReader()->feedsModel()->reloadWholeLayout();
   qApp->feedReader()->messagesModel()->updateDateFormat();
+
+  // Rendered messages contain image heights and dates.
+  MessageHtmlCache::clear();
   qApp->feedReader()->messagesModel()->reloadWholeLayout();
 
   onEndSaveSettings();
@@ -22,6 +22,8 @@
 #include "miscellaneous/settings.h"
 #include "miscellaneous/textfactory.h"
 #include "miscellaneous/iconfactory.h"
+#include "miscellaneous/databasefactory.h"
+#include "miscellaneous/databasequeries.h"
 #include "gui/tabbar.h"
 #include "gui/messagesview.h"
 #include "gui/feedsview.h"
@@ -213,7 +215,15 @@ int TabWidget::addNewspaperView(RootItem *root, const QList<Message> &messages)
   setCurrentIndex(index);
 
 #if defined(USE_WEBENGINE)
-  prev->loadMessages(messages, root);
+  // Whole newspaper is rendered as single page, so it needs all bodies.
+  QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings);
+  QList<Message> messages_with_bodies = messages;
+
+  if (!DatabaseQueries::loadMessagesWithBodies(database, messages_with_bodies)) {
+    qWarning("Loading of messages for newspaper view failed, they are displayed without bodies.");
+  }
+
+  prev->loadMessages(messages_with_bodies, root);
 #endif
 
   return index;
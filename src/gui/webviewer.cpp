@@ -19,6 +19,7 @@
 
 #include "miscellaneous/skinfactory.h"
 #include "miscellaneous/application.h"
+#include "miscellaneous/messagehtmlcache.h"
 #include "definitions/definitions.h"
 #include "network-web/webpage.h"
 #include "gui/dialogs/formmain.h"
@@ -85,6 +86,17 @@ void WebViewer::loadMessages(const QList<Message> &messages) {
   QString single_message_layout = skin.m_layoutMarkup;
 
   foreach (const Message &message, messages) {
+    // Markup of message contains actions which depend on its states.
+    const QString layout = QString(QSL("%1/%2%3")).arg(skin.m_baseName,
+                                                       QString::number(message.m_isRead),
+                                                       QString::number(message.m_isImportant));
+    QString message_layout = MessageHtmlCache::html(message, layout);
+
+    if (!message_layout.isNull()) {
+      messages_layout.append(message_layout);
+      continue;
+    }
+
     QString enclosures;
     QString enclosure_images;
 
@@ -100,19 +112,21 @@ void WebViewer::loadMessages(const QList<Message> &messages) {
       }
     }
 
-    messages_layout.append(single_message_layout
-                           .arg(message.m_title,
-                                tr("Written by ") + (message.m_author.isEmpty() ?
-                                                       tr("unknown author") :
-                                                       message.m_author),
-                                message.m_url,
-                                message.m_contents,
-                                message.m_created.toString(Qt::DefaultLocaleShortDate),
-                                enclosures,
-                                message.m_isRead ? "mark-unread" : "mark-read",
-                                message.m_isImportant ? "mark-unstarred" : "mark-starred",
-                                QString::number(message.m_id))
-                           .arg(enclosure_images));
+    message_layout = single_message_layout.arg(message.m_title,
+                                               tr("Written by ") + (message.m_author.isEmpty() ?
+                                                                      tr("unknown author") :
+                                                                      message.m_author),
+                                               message.m_url,
+                                               message.m_contents,
+                                               message.m_created.toString(Qt::DefaultLocaleShortDate),
+                                               enclosures,
+                                               message.m_isRead ? "mark-unread" : "mark-read",
+                                               message.m_isImportant ? "mark-unstarred" : "mark-starred",
+                                               QString::number(message.m_id))
+                     .arg(enclosure_images);
+
+    MessageHtmlCache::insert(message, layout, message_layout);
+    messages_layout.append(message_layout);
   }
 
   m_messageContents = skin.m_layoutMarkupWrapper.arg(messages.size() == 1 ? messages.at(0).m_title : tr("Newspaper view"),
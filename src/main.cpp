@@ -47,7 +47,8 @@ int main(int argc, char *argv[]) {
     if (str == "-h") {
       qDebug("Usage: rssguard [OPTIONS]\n\n"
              "Option\t\tMeaning\n"
-             "-h\t\tDisplays this help.");
+             "-h\t\tDisplays this help.\n"
+             "-d\t\tLogs SQL statements of running instance with highest total execution time.");
 
       return EXIT_SUCCESS;
     }
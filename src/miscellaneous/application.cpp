@@ -21,6 +21,8 @@
 #include "miscellaneous/iofactory.h"
 #include "miscellaneous/mutex.h"
 #include "miscellaneous/feedreader.h"
+#include "miscellaneous/databasequeryprofiler.h"
+#include "miscellaneous/messagehtmlcache.h"
 #include "gui/feedsview.h"
 #include "gui/feedmessageviewer.h"
 #include "gui/messagebox.h"
@@ -276,6 +278,9 @@ void Application::processExecutionMessage(const QString &message) {
   if (messages.contains(APP_QUIT_INSTANCE)) {
     quit();
   }
+  else if (messages.contains(APP_DUMP_QUERIES)) {
+    DatabaseQueryProfiler::logTopStatements(DATABASE_PROFILER_DUMP_COUNT);
+  }
   else {
     foreach (const QString &msg, messages) {
       if (msg == APP_IS_RUNNING) {
@@ -374,6 +379,7 @@ void Application::onAboutToQuit() {
 
   qApp->feedReader()->quit();
   database()->saveDatabase();
+  MessageHtmlCache::logStatistics();
 
   if (mainForm() != nullptr) {
     mainForm()->saveSize();
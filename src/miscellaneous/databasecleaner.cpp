@@ -37,9 +37,9 @@ void DatabaseCleaner::purgeDatabaseData(const CleanerOrders &which_data) {
   emit purgeStarted();
 
   bool result = true;
-  const int difference = 99 / 8;
+  const int difference = 99 / 14;
   int progress = 0;
-  QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings);
+  QSqlDatabase database = qApp->database()->threadConnection();
 
   if (which_data.m_removeReadMessages) {
     progress += difference;
@@ -63,6 +63,18 @@ void DatabaseCleaner::purgeDatabaseData(const CleanerOrders &which_data) {
     emit purgeProgress(progress, tr("Recycle bin purged..."));
   }
 
+  if (which_data.m_archiveOldMessages) {
+    int archived_messages = 0;
+
+    progress += difference;
+    emit purgeProgress(progress, tr("Moving old messages to archive..."));
+
+    result &= archiveOldMessages(database, which_data.m_barrierForArchivingOldMessagesInDays, &archived_messages);
+
+    progress += difference;
+    emit purgeProgress(progress, tr("%n old messages archived...", 0, archived_messages));
+  }
+
   if (which_data.m_removeOldMessages) {
     progress += difference;
     emit purgeProgress(progress, tr("Removing old messages..."));
@@ -74,6 +86,30 @@ void DatabaseCleaner::purgeDatabaseData(const CleanerOrders &which_data) {
     emit purgeProgress(progress, tr("Old messages purged..."));
   }
 
+  if (which_data.m_compressContents) {
+    qint64 saved_bytes = 0;
+
+    progress += difference;
+    emit purgeProgress(progress, tr("Compressing contents of messages..."));
+
+    result &= compressContents(database, &saved_bytes);
+
+    progress += difference;
+    emit purgeProgress(progress, tr("Contents of messages compressed, %1 MB saved...").arg(saved_bytes / 1000000.0));
+  }
+
+  if (which_data.m_reclaimFreeSpace && !which_data.m_shrinkDatabase) {
+    qint64 reclaimed_bytes = 0;
+
+    progress += difference;
+    emit purgeProgress(progress, tr("Reclaiming free space of database file..."));
+
+    result &= reclaimFreeSpace(&reclaimed_bytes);
+
+    progress += difference;
+    emit purgeProgress(progress, tr("Free space reclaimed, %1 MB released...").arg(reclaimed_bytes / 1000000.0));
+  }
+
   if (which_data.m_shrinkDatabase) {
     progress += difference;
     emit purgeProgress(progress, tr("Shrinking database file..."));
@@ -88,6 +124,18 @@ void DatabaseCleaner::purgeDatabaseData(const CleanerOrders &which_data) {
   emit purgeFinished(result);
 }
 
+void DatabaseCleaner::compactDatabase(int max_pages) {
+  qint64 reclaimable_size = 0;
+  const qint64 reclaimed_size = qApp->database()->sqliteIncrementalVacuum(metaObject()->className(), max_pages, &reclaimable_size);
+
+  if (reclaimed_size > 0) {
+    qDebug("Reclaimed %lld bytes of database file, %lld bytes are still reclaimable.", reclaimed_size, reclaimable_size);
+    emit compactionProgress(reclaimed_size, reclaimable_size);
+  }
+
+  emit compactionFinished();
+}
+
 bool DatabaseCleaner::purgeStarredMessages(const QSqlDatabase &database) {  
   return DatabaseQueries::purgeImportantMessages(database);
 }
@@ -100,6 +148,40 @@ bool DatabaseCleaner::purgeOldMessages(const QSqlDatabase &database, int days) {
   return DatabaseQueries::purgeOldMessages(database, days);
 }
 
+bool DatabaseCleaner::archiveOldMessages(const QSqlDatabase &database, int days, int *archived_messages) {
+  bool ok;
+
+  *archived_messages = DatabaseQueries::archiveOldMessages(database, days, ARCHIVE_MESSAGES_BATCH_SIZE, &ok);
+  return ok;
+}
+
 bool DatabaseCleaner::purgeRecycleBin(const QSqlDatabase &database) {
   return DatabaseQueries::purgeRecycleBin(database);
 }
+
+bool DatabaseCleaner::reclaimFreeSpace(qint64 *reclaimed_bytes) {
+  qint64 reclaimable_size = 0;
+  qint64 reclaimed_size;
+
+  // Free space is reclaimed in steps, so that progress can be reported.
+  do {
+    reclaimed_size = qApp->database()->sqliteIncrementalVacuum(metaObject()->className(), DATABASE_COMPACTION_STEP_PAGES,
+                                                               &reclaimable_size);
+
+    if (reclaimed_size < 0) {
+      return false;
+    }
+
+    *reclaimed_bytes += reclaimed_size;
+    emit compactionProgress(reclaimed_size, reclaimable_size);
+  } while (reclaimed_size > 0 && reclaimable_size > 0);
+
+  return true;
+}
+
+bool DatabaseCleaner::compressContents(const QSqlDatabase &database, qint64 *saved_bytes) {
+  bool ok;
+
+  DatabaseQueries::compressMessageContents(database, COMPRESS_CONTENTS_BATCH_SIZE, saved_bytes, &ok);
+  return ok;
+}
@@ -29,7 +29,11 @@ struct CleanerOrders {
   bool m_removeOldMessages;
   bool m_removeRecycleBin;
   bool m_removeStarredMessages;
+  bool m_compressContents;
+  bool m_archiveOldMessages;
+  bool m_reclaimFreeSpace;
   int m_barrierForRemovingOldMessagesInDays;
+  int m_barrierForArchivingOldMessagesInDays;
 };
 
 class DatabaseCleaner : public QObject {
@@ -45,14 +49,24 @@ class DatabaseCleaner : public QObject {
     void purgeProgress(int progress, const QString &description);
     void purgeFinished(bool result);
 
+    // Emitted after each step of incremental reclaiming of free space.
+    void compactionProgress(qint64 reclaimed_size, qint64 reclaimable_size);
+    void compactionFinished();
+
   public slots:
     void purgeDatabaseData(const CleanerOrders &which_data);
 
+    // Reclaims at most given number of free pages of database file.
+    void compactDatabase(int max_pages);
+
   private:
     bool purgeStarredMessages(const QSqlDatabase &database);
     bool purgeReadMessages(const QSqlDatabase &database);
     bool purgeOldMessages(const QSqlDatabase &database, int days);
+    bool archiveOldMessages(const QSqlDatabase &database, int days, int *archived_messages);
     bool purgeRecycleBin(const QSqlDatabase &database);
+    bool compressContents(const QSqlDatabase &database, qint64 *saved_bytes);
+    bool reclaimFreeSpace(qint64 *reclaimed_bytes);
 };
 
 #endif // DATABASECLEANER_H
@@ -20,9 +20,15 @@
 #include "miscellaneous/iofactory.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/textfactory.h"
+#include "miscellaneous/databasequerycache.h"
+#include "miscellaneous/databasequeryprofiler.h"
+#include "miscellaneous/databasequeries.h"
 #include "gui/messagebox.h"
 
 #include <QDir>
+#include <QThread>
+#include <QDateTime>
+#include <QMutexLocker>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
@@ -30,14 +36,29 @@
 
 DatabaseFactory::DatabaseFactory(QObject *parent)
   : QObject(parent),
+    m_poolStatistics(),
     m_mysqlDatabaseInitialized(false),
     m_sqliteFileBasedDatabaseinitialized(false),
     m_sqliteInMemoryDatabaseInitialized(false) {
   setObjectName(QSL("DatabaseFactory"));
+
+  DatabaseQueryProfiler::setSlowQueryThreshold(qApp->settings()->value(GROUP(Database),
+                                                                       SETTING(Database::SlowQueryThreshold)).toInt());
+  DatabaseQueryProfiler::setQueryPlanCapture(qApp->settings()->value(GROUP(Database),
+                                                                     SETTING(Database::CaptureQueryPlans)).toBool());
   determineDriver();
 }
 
 DatabaseFactory::~DatabaseFactory() {
+  // Main thread never emits finished() as worker threads do,
+  // so its pooled connections are released here.
+  releaseThreadConnections();
+
+  // Cached queries must be destroyed while their drivers still exist.
+  DatabaseQueryCache::logStatistics();
+  DatabaseQueryCache::clearAll();
+  DatabaseQueryProfiler::logTopStatements(DATABASE_PROFILER_DUMP_COUNT);
+  logConnectionPoolStatistics();
 }
 
 qint64 DatabaseFactory::getDatabaseFileSize() const {
@@ -55,7 +76,7 @@ qint64 DatabaseFactory::getDatabaseDataSize() const {
     qint64 result = 1;
     QSqlQuery query(database);
 
-    if (query.exec(QSL("PRAGMA page_count;"))) {
+    if (DB_EXEC_SQL(query, QSL("PRAGMA page_count;"))) {
       query.next();
       result *= query.value(0).value<qint64>();
     }
@@ -63,7 +84,7 @@ qint64 DatabaseFactory::getDatabaseDataSize() const {
       return 0;
     }
 
-    if (query.exec(QSL("PRAGMA page_size;"))) {
+    if (DB_EXEC_SQL(query, QSL("PRAGMA page_size;"))) {
       query.next();
       result *= query.value(0).value<qint64>();
     }
@@ -78,7 +99,7 @@ qint64 DatabaseFactory::getDatabaseDataSize() const {
     qint64 result = 1;
     QSqlQuery query(database);
 
-    if (query.exec("SELECT Round(Sum(data_length + index_length), 1) "
+    if (DB_EXEC_SQL(query, "SELECT Round(Sum(data_length + index_length), 1) "
                    "FROM information_schema.tables "
                    "GROUP BY table_schema;")) {
       while (query.next()) {
@@ -96,6 +117,18 @@ qint64 DatabaseFactory::getDatabaseDataSize() const {
   }
 }
 
+qint64 DatabaseFactory::getDatabaseReclaimableSize() const {
+  if (m_activeDatabaseDriver == SQLITE || m_activeDatabaseDriver == SQLITE_MEMORY) {
+    // Free space is always measured in database file, not in in-memory copy.
+    QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::StrictlyFileBased);
+
+    return qMax(sqliteReclaimableSize(database), qint64(0));
+  }
+  else {
+    return 0;
+  }
+}
+
 DatabaseFactory::MySQLError DatabaseFactory::mysqlTestConnection(const QString &hostname, int port, const QString &w_database,
                                                                  const QString &username, const QString &password) {
   QSqlDatabase database = QSqlDatabase::addDatabase(APP_DB_MYSQL_DRIVER, APP_DB_MYSQL_TEST);
@@ -191,6 +224,8 @@ void DatabaseFactory::sqliteAssemblyDatabaseFilePath()  {
 }
 
 QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase() {
+  DatabaseQueryCache::clear(QL1S(QSqlDatabase::defaultConnection));
+
   QSqlDatabase database = QSqlDatabase::addDatabase(APP_DB_SQLITE_DRIVER);
 
   database.setDatabaseName(QSL(":memory:"));
@@ -202,16 +237,12 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase() {
     QSqlQuery query_db(database);
 
     query_db.setForwardOnly(true);
-    query_db.exec(QSL("PRAGMA encoding = \"UTF-8\""));
-    query_db.exec(QSL("PRAGMA synchronous = OFF"));
-    query_db.exec(QSL("PRAGMA journal_mode = MEMORY"));
-    query_db.exec(QSL("PRAGMA page_size = 4096"));
-    query_db.exec(QSL("PRAGMA cache_size = 16384"));
-    query_db.exec(QSL("PRAGMA count_changes = OFF"));
-    query_db.exec(QSL("PRAGMA temp_store = MEMORY"));
+    DB_EXEC_SQL(query_db, QSL("PRAGMA encoding = \"UTF-8\""));
+    DB_EXEC_SQL(query_db, QSL("PRAGMA page_size = 4096"));
+    sqliteConfigureConnection(database);
 
     // Sample query which checks for existence of tables.
-    query_db.exec(QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"));
+    DB_EXEC_SQL(query_db, QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"));
 
     if (query_db.lastError().isValid()) {
       qWarning("Error occurred. In-memory SQLite database is not initialized. Initializing now.");
@@ -229,7 +260,7 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase() {
       database.transaction();
 
       foreach(const QString &statement, statements) {
-        query_db.exec(statement);
+        DB_EXEC_SQL(query_db, statement);
 
         if (query_db.lastError().isValid()) {
           qFatal("In-memory SQLite database initialization failed. Initialization script '%s' is not correct.", APP_DB_SQLITE_INIT);
@@ -251,13 +282,14 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase() {
     QSqlQuery copy_contents(database);
 
     // Attach database.
-    copy_contents.exec(QString("ATTACH DATABASE '%1' AS 'storage';").arg(file_database.databaseName()));
+    DB_EXEC_SQL(copy_contents, QString("ATTACH DATABASE '%1' AS 'storage';").arg(file_database.databaseName()));
 
     // Copy all stuff.
     // WARNING: All tables belong here.
+    // NOTE: Full-text index is copied via its shadow tables, not via the virtual table itself.
     QStringList tables;
 
-    if (copy_contents.exec(QSL("SELECT name FROM storage.sqlite_master WHERE type='table';"))) {
+    if (DB_EXEC_SQL(copy_contents, QSL("SELECT name FROM storage.sqlite_master WHERE type='table' AND sql NOT LIKE 'CREATE VIRTUAL TABLE%';"))) {
       while (copy_contents.next()) {
         tables.append(copy_contents.value(0).toString());
       }
@@ -267,13 +299,22 @@ QSqlDatabase DatabaseFactory::sqliteInitializeInMemoryDatabase() {
     }
 
     foreach (const QString &table, tables) {
-      copy_contents.exec(QString("INSERT INTO main.%1 SELECT * FROM storage.%1;").arg(table));
+      // Message counters are recalculated by triggers while messages are copied,
+      // sequences of IDs are updated while rows are copied too and are copied last.
+      if (table != QL1S("MessageCounters") && table != QL1S("sqlite_sequence")) {
+        const QString columns = sqliteTableColumns(database, QSL("storage"), table);
+
+        DB_EXEC_SQL(copy_contents, QString("INSERT INTO main.%1 (%2) SELECT %2 FROM storage.%1;").arg(table, columns));
+      }
     }
 
+    DB_EXEC_SQL(copy_contents, QSL("DELETE FROM main.sqlite_sequence;"));
+    DB_EXEC_SQL(copy_contents, QSL("INSERT INTO main.sqlite_sequence (name, seq) SELECT name, seq FROM storage.sqlite_sequence;"));
+
     qDebug("Copying data from file-based database into working in-memory database.");
 
     // Detach database and finish.
-    copy_contents.exec(QSL("DETACH 'storage'"));
+    DB_EXEC_SQL(copy_contents, QSL("DETACH 'storage'"));
     copy_contents.finish();
 
     query_db.finish();
@@ -306,6 +347,7 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
   // Folders are created. Create new QSQLDatabase object.
   QSqlDatabase database;
 
+  DatabaseQueryCache::clear(connection_name);
   database = QSqlDatabase::addDatabase(APP_DB_SQLITE_DRIVER, connection_name);
   database.setDatabaseName(db_file.fileName());
 
@@ -317,16 +359,16 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
     QSqlQuery query_db(database);
 
     query_db.setForwardOnly(true);
-    query_db.exec(QSL("PRAGMA encoding = \"UTF-8\""));
-    query_db.exec(QSL("PRAGMA synchronous = OFF"));
-    query_db.exec(QSL("PRAGMA journal_mode = MEMORY"));
-    query_db.exec(QSL("PRAGMA page_size = 4096"));
-    query_db.exec(QSL("PRAGMA cache_size = 16384"));
-    query_db.exec(QSL("PRAGMA count_changes = OFF"));
-    query_db.exec(QSL("PRAGMA temp_store = MEMORY"));
+    DB_EXEC_SQL(query_db, QSL("PRAGMA encoding = \"UTF-8\""));
+    DB_EXEC_SQL(query_db, QSL("PRAGMA page_size = 4096"));
+    sqliteConfigureConnection(database);
+
+    // NOTE: This has effect only for new database files, which are
+    // not initialized yet, or when database file is vacuumed.
+    DB_EXEC_SQL(query_db, QSL("PRAGMA auto_vacuum = INCREMENTAL"));
 
     // Sample query which checks for existence of tables.
-    if (!query_db.exec(QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
+    if (!DB_EXEC_SQL(query_db, QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
       qWarning("Error occurred. File-based SQLite database is not initialized. Initializing now.");
 
       QFile file_init(APP_SQL_PATH + QDir::separator() + APP_DB_SQLITE_INIT);
@@ -342,7 +384,7 @@ QSqlDatabase DatabaseFactory::sqliteInitializeFileBasedDatabase(const QString &c
       database.transaction();
 
       foreach(const QString &statement, statements) {
-        query_db.exec(statement);
+        DB_EXEC_SQL(query_db, statement);
 
         if (query_db.lastError().isValid()) {
           qFatal("File-based SQLite database initialization failed. Initialization script '%s' is not correct.",
@@ -389,6 +431,279 @@ QString DatabaseFactory::sqliteDatabaseFilePath() const {
   return m_sqliteDatabaseFilePath + QDir::separator() + APP_DB_SQLITE_FILE;
 }
 
+QString DatabaseFactory::sqliteArchiveFilePath(int account_id) const {
+  return m_sqliteDatabaseFilePath + QDir::separator() + QString(APP_DB_SQLITE_ARCHIVE_FILE).arg(account_id);
+}
+
+bool DatabaseFactory::sqliteIncrementalVacuumEnabled() const {
+  if (m_activeDatabaseDriver != SQLITE && m_activeDatabaseDriver != SQLITE_MEMORY) {
+    return false;
+  }
+
+  QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::StrictlyFileBased);
+  QSqlQuery query(database);
+
+  // Value 2 stands for INCREMENTAL mode.
+  return DB_EXEC_SQL(query, QSL("PRAGMA auto_vacuum;")) && query.next() && query.value(0).toInt() == 2;
+}
+
+qint64 DatabaseFactory::sqliteIncrementalVacuum(const QString &connection_name, int max_pages, qint64 *reclaimable_size) {
+  if (m_activeDatabaseDriver != SQLITE && m_activeDatabaseDriver != SQLITE_MEMORY) {
+    return -1;
+  }
+
+  QSqlDatabase database = sqliteConnection(connection_name, StrictlyFileBased);
+  QSqlQuery query(database);
+
+  query.setForwardOnly(true);
+
+  if (!DB_EXEC_SQL(query, QSL("PRAGMA auto_vacuum;")) || !query.next() || query.value(0).toInt() != 2) {
+    // Free space can be reclaimed only by full vacuuming.
+    return -1;
+  }
+
+  if (!DB_EXEC_SQL(query, QSL("PRAGMA page_size;")) || !query.next()) {
+    return -1;
+  }
+
+  const qint64 page_size = query.value(0).value<qint64>();
+  const qint64 free_size_before = sqliteReclaimableSize(database);
+
+  if (free_size_before < 0) {
+    return -1;
+  }
+
+  const int pages = qMin(qint64(max_pages), free_size_before / page_size);
+
+  if (pages > 0) {
+    // NOTE: Qt steps statements without result columns only once and each step
+    // of "incremental_vacuum" reclaims single page, therefore the pragma is
+    // executed once per page. Single transaction makes this cheap.
+    database.transaction();
+    query.prepare(QSL("PRAGMA incremental_vacuum(1);"));
+
+    for (int i = 0; i < pages; i++) {
+      if (!DB_EXEC(query)) {
+        qWarning("Incremental vacuuming of database failed: '%s'.", qPrintable(query.lastError().text()));
+        break;
+      }
+    }
+
+    query.finish();
+
+    if (!database.commit()) {
+      qWarning("Incremental vacuuming of database was not committed: '%s'.", qPrintable(database.lastError().text()));
+      database.rollback();
+      return -1;
+    }
+  }
+
+  const qint64 free_size_after = qMax(sqliteReclaimableSize(database), qint64(0));
+
+  if (reclaimable_size != nullptr) {
+    *reclaimable_size = free_size_after;
+  }
+
+  return qMax(free_size_before - free_size_after, qint64(0));
+}
+
+qint64 DatabaseFactory::sqliteReclaimableSize(QSqlDatabase database) const {
+  QSqlQuery query(database);
+  qint64 free_pages;
+
+  query.setForwardOnly(true);
+
+  if (DB_EXEC_SQL(query, QSL("PRAGMA freelist_count;")) && query.next()) {
+    free_pages = query.value(0).value<qint64>();
+  }
+  else {
+    return -1;
+  }
+
+  if (DB_EXEC_SQL(query, QSL("PRAGMA page_size;")) && query.next()) {
+    return free_pages * query.value(0).value<qint64>();
+  }
+  else {
+    return -1;
+  }
+}
+
+QString DatabaseFactory::sqliteTableColumns(QSqlDatabase database, const QString &schema, const QString &table) const {
+  QSqlQuery query(database);
+  QStringList columns;
+
+  query.setForwardOnly(true);
+
+  if (DB_EXEC_SQL(query, QString(QSL("PRAGMA %1.table_info(%2);")).arg(schema, table))) {
+    while (query.next()) {
+      columns.append(query.value(1).toString());
+    }
+  }
+
+  return columns.join(QSL(", "));
+}
+
+QString DatabaseFactory::sqliteAttachArchive(QSqlDatabase db, int account_id, bool create_if_missing) {
+  if (m_activeDatabaseDriver == MYSQL) {
+    // Archives are available only for SQLite.
+    return QString();
+  }
+
+  const QString schema = QString(APP_DB_SQLITE_ARCHIVE_SCHEMA).arg(account_id);
+  QSqlQuery query(db);
+
+  query.setForwardOnly(true);
+
+  if (DB_EXEC_SQL(query, QSL("PRAGMA database_list"))) {
+    while (query.next()) {
+      if (query.value(1).toString() == schema) {
+        QMutexLocker locker(&m_archivesMutex);
+
+        m_attachedArchives[db.connectionName()][schema]++;
+        return schema;
+      }
+    }
+  }
+
+  const QString archive_file = sqliteArchiveFilePath(account_id);
+
+  if (!QFile::exists(archive_file)) {
+    if (!create_if_missing) {
+      return QString();
+    }
+
+    QDir().mkpath(m_sqliteDatabaseFilePath);
+  }
+
+  query.prepare(QString("ATTACH DATABASE :file AS %1").arg(schema));
+  query.bindValue(QSL(":file"), QDir::toNativeSeparators(archive_file));
+
+  if (!DB_EXEC(query)) {
+    qWarning("Archive database '%s' was not attached: '%s'.",
+             qPrintable(QDir::toNativeSeparators(archive_file)),
+             qPrintable(query.lastError().text()));
+    return QString();
+  }
+
+  QFile file_init(APP_SQL_PATH + QDir::separator() + APP_DB_SQLITE_ARCHIVE_INIT);
+
+  if (!file_init.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    qCritical("SQLite archive initialization file '%s' from directory '%s' was not found.",
+              APP_DB_SQLITE_ARCHIVE_INIT,
+              qPrintable(APP_SQL_PATH));
+    DB_EXEC_SQL(query, QString("DETACH DATABASE %1").arg(schema));
+    return QString();
+  }
+
+  const QStringList statements = QString(file_init.readAll()).split(APP_DB_COMMENT_SPLIT, QString::SkipEmptyParts);
+
+  if (!sqliteUpdateArchiveSchema(db, schema)) {
+    DB_EXEC_SQL(query, QString("DETACH DATABASE %1").arg(schema));
+    return QString();
+  }
+
+  foreach (const QString &statement, statements) {
+    if (!DB_EXEC_SQL(query, statement.arg(schema))) {
+      qCritical("SQLite archive '%s' initialization failed: '%s'.",
+                qPrintable(schema),
+                qPrintable(query.lastError().text()));
+      DB_EXEC_SQL(query, QString("DETACH DATABASE %1").arg(schema));
+      return QString();
+    }
+  }
+
+  // Databases created before message IDs were not reused could contain archived
+  // messages with IDs higher than any message left, new messages must not get them.
+  DB_EXEC_SQL(query, QSL("INSERT INTO main.sqlite_sequence (name, seq) SELECT 'Messages', 0 "
+                         "WHERE NOT EXISTS (SELECT 1 FROM main.sqlite_sequence WHERE name = 'Messages');"));
+
+  if (!DB_EXEC_SQL(query, QString(QSL("UPDATE main.sqlite_sequence SET seq = MAX(seq, IFNULL((SELECT MAX(id) FROM %1.Messages), 0)) "
+                                      "WHERE name = 'Messages';")).arg(schema))) {
+    qWarning("Sequence of message IDs was not updated for archive '%s': '%s'.",
+             qPrintable(schema), qPrintable(query.lastError().text()));
+  }
+
+  qDebug("Archive database '%s' attached as '%s'.",
+         qPrintable(QDir::toNativeSeparators(archive_file)),
+         qPrintable(schema));
+
+  {
+    QMutexLocker locker(&m_archivesMutex);
+    m_attachedArchives[db.connectionName()][schema]++;
+  }
+
+  return schema;
+}
+
+void DatabaseFactory::sqliteDetachArchive(QSqlDatabase db, const QString &schema) {
+  if (schema.isEmpty()) {
+    return;
+  }
+
+  {
+    QMutexLocker locker(&m_archivesMutex);
+    QHash<QString,int> &archives = m_attachedArchives[db.connectionName()];
+
+    if (--archives[schema] > 0) {
+      // Archive is still used by others.
+      return;
+    }
+
+    archives.remove(schema);
+  }
+
+  QSqlQuery query(db);
+
+  if (DB_EXEC_SQL(query, QString(QSL("DETACH DATABASE %1")).arg(schema))) {
+    qDebug("Archive database '%s' detached.", qPrintable(schema));
+  }
+  else {
+    qWarning("Archive database '%s' was not detached: '%s'.", qPrintable(schema), qPrintable(query.lastError().text()));
+  }
+}
+
+bool DatabaseFactory::sqliteUpdateArchiveSchema(QSqlDatabase database, const QString &schema) {
+  QSqlQuery query(database);
+  bool has_messages = false;
+
+  query.setForwardOnly(true);
+
+  if (!DB_EXEC_SQL(query, QString("PRAGMA %1.table_info(Messages)").arg(schema))) {
+    qCritical("Columns of SQLite archive '%s' were not obtained: '%s'.",
+              qPrintable(schema),
+              qPrintable(query.lastError().text()));
+    return false;
+  }
+
+  while (query.next()) {
+    if (query.value(1).toString() == QL1S("feed_id")) {
+      // Archive is up-to-date.
+      return true;
+    }
+
+    has_messages = true;
+  }
+
+  if (!has_messages) {
+    // Archive is empty, it is created with all columns.
+    return true;
+  }
+
+  // Archives created before schema 15 do not have surrogate feed keys,
+  // they are filled in from feeds which are currently stored.
+  if (!DB_EXEC_SQL(query, QString("ALTER TABLE %1.Messages ADD COLUMN feed_id INTEGER").arg(schema)) ||
+      !DB_EXEC_SQL(query, QString("UPDATE %1.Messages SET feed_id = (SELECT id FROM main.Feeds "
+                                  "WHERE Feeds.custom_id = Messages.feed AND Feeds.account_id = Messages.account_id)").arg(schema))) {
+    qCritical("SQLite archive '%s' was not updated: '%s'.",
+              qPrintable(schema),
+              qPrintable(query.lastError().text()));
+    return false;
+  }
+
+  qDebug("SQLite archive '%s' was updated to use surrogate feed keys.", qPrintable(schema));
+  return true;
+}
+
 bool DatabaseFactory::sqliteUpdateDatabaseSchema(QSqlDatabase database, const QString &source_db_schema_version) {
   int working_version = QString(source_db_schema_version).remove('.').toInt();
   const int current_version = QString(APP_DB_SCHEMA_VERSION).remove('.').toInt();
@@ -427,6 +742,16 @@ bool DatabaseFactory::sqliteUpdateDatabaseSchema(QSqlDatabase database, const QS
       }
     }
 
+    // Shared icons were just introduced, move icons stored inline to them.
+    if (working_version == 13 && !DatabaseQueries::migrateLegacyIcons(database)) {
+      qCritical("Some icons of feeds or categories were not moved to shared icons.");
+    }
+
+    // Search index was just created, it is missing contents of compressed messages.
+    if (working_version == 10 && !DatabaseQueries::indexCompressedMessages(database, COMPRESS_CONTENTS_BATCH_SIZE)) {
+      qCritical("Some compressed messages were not indexed for full-text search.");
+    }
+
     // Increment the version.
     qDebug("Updating database schema: '%d' -> '%d'.", working_version, working_version + 1);
     working_version++;
@@ -465,6 +790,16 @@ bool DatabaseFactory::mysqlUpdateDatabaseSchema(QSqlDatabase database, const QSt
       }
     }
 
+    // Shared icons were just introduced, move icons stored inline to them.
+    if (working_version == 13 && !DatabaseQueries::migrateLegacyIcons(database)) {
+      qCritical("Some icons of feeds or categories were not moved to shared icons.");
+    }
+
+    // Search index was just created, it is missing contents of compressed messages.
+    if (working_version == 10 && !DatabaseQueries::indexCompressedMessages(database, COMPRESS_CONTENTS_BATCH_SIZE)) {
+      qCritical("Some compressed messages were not indexed for full-text search.");
+    }
+
     // Increment the version.
     qDebug("Updating database schema: '%d' -> '%d'.", working_version, working_version + 1);
     working_version++;
@@ -509,8 +844,196 @@ QString DatabaseFactory::humanDriverName(const QString &driver_code) const {
   }
 }
 
+QSqlDatabase DatabaseFactory::threadConnection(DesiredType desired_type) {
+  if (desired_type == StrictlyInMemory || (desired_type == FromSettings && m_activeDatabaseDriver == SQLITE_MEMORY)) {
+    // All threads share the only in-memory database connection, but each
+    // of them has its own prepared queries, which must be dropped with it.
+    QThread *thread = QThread::currentThread();
+    bool is_new = false;
+
+    if (thread != qApp->thread()) {
+      QMutexLocker locker(&m_poolMutex);
+
+      if (!m_sharedConnectionThreads.contains(thread)) {
+        m_sharedConnectionThreads.insert(thread);
+        is_new = true;
+      }
+    }
+
+    if (is_new) {
+      connect(thread, &QThread::finished, this, [this, thread]() {
+        {
+          QMutexLocker locker(&m_poolMutex);
+          m_sharedConnectionThreads.remove(thread);
+        }
+
+        DatabaseQueryCache::clear(thread);
+      }, Qt::DirectConnection);
+    }
+
+    return connection(objectName(), desired_type);
+  }
+
+  QThread *thread = QThread::currentThread();
+  const QString connection_name = QString(APP_DB_POOL_CONNECTION).arg(QString::number(quintptr(thread), 16),
+                                                                      QString::number(desired_type));
+  bool is_new;
+
+  {
+    QMutexLocker locker(&m_poolMutex);
+
+    is_new = !m_pooledConnections.contains(connection_name);
+    m_poolStatistics.m_acquired++;
+
+    if (is_new && m_poolStatistics.m_active >= DATABASE_POOL_MAX_CONNECTIONS && thread != qApp->thread()) {
+      // Worker thread waits a while for connection of some finished thread when
+      // the pool is full. Main thread never waits, so that GUI does not freeze.
+      // Connection is created anyway once the wait times out, so that workers
+      // holding all connections cannot block each other forever.
+      m_poolConnectionReleased.wait(&m_poolMutex, DATABASE_POOL_WAIT_TIMEOUT);
+
+      if (m_poolStatistics.m_active >= DATABASE_POOL_MAX_CONNECTIONS) {
+        qWarning("Database connection pool is full, connection for thread is created over its limit.");
+        m_poolStatistics.m_overflows++;
+      }
+    }
+
+    if (is_new) {
+      m_pooledConnections.insert(connection_name, QDateTime::currentMSecsSinceEpoch());
+      m_poolStatistics.m_created++;
+      m_poolStatistics.m_active++;
+    }
+  }
+
+  QSqlDatabase database = connection(connection_name, desired_type);
+
+  if (is_new) {
+    qDebug("Created pooled database connection '%s'.", qPrintable(connection_name));
+
+    // NOTE: Signal is emitted from finishing thread itself, so that
+    // connection is removed in the thread which used it.
+    connect(thread, &QThread::finished, this, [this, connection_name]() {
+      releasePooledConnection(connection_name);
+    }, Qt::DirectConnection);
+  }
+  else {
+    checkPooledConnection(connection_name, database);
+  }
+
+  return database;
+}
+
+DatabaseFactory::ConnectionPoolStatistics DatabaseFactory::connectionPoolStatistics() const {
+  QMutexLocker locker(&m_poolMutex);
+  return m_poolStatistics;
+}
+
+void DatabaseFactory::logConnectionPoolStatistics() const {
+  const ConnectionPoolStatistics stats = connectionPoolStatistics();
+
+  qDebug("Connection pool: %lld connections created, %lld acquisitions, %lld failed health checks, %d active connections, "
+         "%lld connections over limit.",
+         stats.m_created, stats.m_acquired, stats.m_failedHealthChecks, stats.m_active, stats.m_overflows);
+}
+
+void DatabaseFactory::checkPooledConnection(const QString &connection_name, QSqlDatabase &database) {
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  qint64 last_use;
+
+  {
+    QMutexLocker locker(&m_poolMutex);
+
+    last_use = m_pooledConnections.value(connection_name, now);
+    m_pooledConnections.insert(connection_name, now);
+  }
+
+  if (now - last_use < DATABASE_HEALTH_CHECK_INTERVAL) {
+    return;
+  }
+
+  QSqlQuery query(database);
+
+  query.setForwardOnly(true);
+
+  if (DB_EXEC_SQL(query, QSL("SELECT 1;")) && query.next()) {
+    return;
+  }
+
+  qWarning("Pooled database connection '%s' is not usable: '%s'. Reopening it.",
+           qPrintable(connection_name), qPrintable(query.lastError().text()));
+
+  {
+    QMutexLocker locker(&m_poolMutex);
+    m_poolStatistics.m_failedHealthChecks++;
+  }
+
+  query.clear();
+
+  // Prepared queries and attached archives of old connection are not valid anymore.
+  DatabaseQueryCache::clear(connection_name);
+
+  {
+    QMutexLocker locker(&m_archivesMutex);
+    m_attachedArchives.remove(connection_name);
+  }
+
+  database.close();
+
+  if (!database.open()) {
+    qCritical("Pooled database connection '%s' was not reopened: '%s'.",
+              qPrintable(connection_name), qPrintable(database.lastError().text()));
+  }
+  else if (m_activeDatabaseDriver == MYSQL) {
+    mysqlConfigureConnection(database);
+  }
+  else {
+    sqliteConfigureConnection(database);
+  }
+}
+
+void DatabaseFactory::releasePooledConnection(const QString &connection_name) {
+  {
+    QMutexLocker locker(&m_poolMutex);
+
+    if (m_pooledConnections.remove(connection_name) == 0) {
+      return;
+    }
+
+    m_poolStatistics.m_active--;
+    m_poolConnectionReleased.wakeOne();
+  }
+
+  removeConnection(connection_name);
+}
+
+void DatabaseFactory::releaseThreadConnections() {
+  const QString prefix = QString(APP_DB_POOL_CONNECTION).arg(QString::number(quintptr(QThread::currentThread()), 16), QString());
+  QStringList connection_names;
+
+  {
+    QMutexLocker locker(&m_poolMutex);
+
+    foreach (const QString &connection_name, m_pooledConnections.keys()) {
+      if (connection_name.startsWith(prefix)) {
+        connection_names.append(connection_name);
+      }
+    }
+  }
+
+  foreach (const QString &connection_name, connection_names) {
+    releasePooledConnection(connection_name);
+  }
+}
+
 void DatabaseFactory::removeConnection(const QString &connection_name) {
   qDebug("Removing database connection '%s'.", qPrintable(connection_name));
+  DatabaseQueryCache::clear(connection_name);
+
+  {
+    QMutexLocker locker(&m_archivesMutex);
+    m_attachedArchives.remove(connection_name);
+  }
+
   QSqlDatabase::removeDatabase(connection_name);
 }
 
@@ -531,13 +1054,14 @@ void DatabaseFactory::sqliteSaveMemoryDatabase() {
   QSqlQuery copy_contents(database);
 
   // Attach database.
-  copy_contents.exec(QString(QSL("ATTACH DATABASE '%1' AS 'storage';")).arg(file_database.databaseName()));
+  DB_EXEC_SQL(copy_contents, QString(QSL("ATTACH DATABASE '%1' AS 'storage';")).arg(file_database.databaseName()));
 
   // Copy all stuff.
   // WARNING: All tables belong here.
+  // NOTE: Full-text index is copied via its shadow tables, not via the virtual table itself.
   QStringList tables;
 
-  if (copy_contents.exec(QSL("SELECT name FROM storage.sqlite_master WHERE type='table';"))) {
+  if (DB_EXEC_SQL(copy_contents, QSL("SELECT name FROM storage.sqlite_master WHERE type='table' AND sql NOT LIKE 'CREATE VIRTUAL TABLE%';"))) {
     while (copy_contents.next()) {
       tables.append(copy_contents.value(0).toString());
     }
@@ -546,13 +1070,32 @@ void DatabaseFactory::sqliteSaveMemoryDatabase() {
     qFatal("Cannot obtain list of table names from file-base SQLite database.");
   }
 
+  // Message counters are recalculated from scratch by triggers while messages are copied.
+  DB_EXEC_SQL(copy_contents, QSL("DELETE FROM storage.MessageCounters;"));
+
+  // All tables are emptied before any of them is filled, otherwise deleting
+  // of messages would remove their already copied bodies via trigger.
+  foreach (const QString &table, tables) {
+    if (table != QL1S("MessageCounters")) {
+      DB_EXEC_SQL(copy_contents, QString(QSL("DELETE FROM storage.%1;")).arg(table));
+    }
+  }
+
   foreach (const QString &table, tables) {
-    copy_contents.exec(QString(QSL("DELETE FROM storage.%1;")).arg(table));
-    copy_contents.exec(QString(QSL("INSERT INTO storage.%1 SELECT * FROM main.%1;")).arg(table));
+    if (table != QL1S("MessageCounters") && table != QL1S("sqlite_sequence")) {
+      const QString columns = sqliteTableColumns(database, QSL("storage"), table);
+
+      DB_EXEC_SQL(copy_contents, QString(QSL("INSERT INTO storage.%1 (%2) SELECT %2 FROM main.%1;")).arg(table, columns));
+    }
   }
 
+  // Sequences of IDs were bumped while rows were copied, they
+  // are replaced, so that IDs of deleted messages are not reused.
+  DB_EXEC_SQL(copy_contents, QSL("DELETE FROM storage.sqlite_sequence;"));
+  DB_EXEC_SQL(copy_contents, QSL("INSERT INTO storage.sqlite_sequence (name, seq) SELECT name, seq FROM main.sqlite_sequence;"));
+
   // Detach database and finish.
-  copy_contents.exec(QSL("DETACH 'storage'"));
+  DB_EXEC_SQL(copy_contents, QSL("DETACH 'storage'"));
   copy_contents.finish();
 }
 
@@ -621,6 +1164,7 @@ QSqlDatabase DatabaseFactory::mysqlConnection(const QString &connection_name) {
              qPrintable(database.lastError().text()));
     }
     else {
+      mysqlConfigureConnection(database);
       qDebug("MySQL database connection '%s' to file '%s' seems to be established.",
              qPrintable(connection_name),
              qPrintable(QDir::toNativeSeparators(database.databaseName())));
@@ -632,6 +1176,8 @@ QSqlDatabase DatabaseFactory::mysqlConnection(const QString &connection_name) {
 
 QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_name) {
   // Folders are created. Create new QSQLDatabase object.
+  DatabaseQueryCache::clear(connection_name);
+
   QSqlDatabase database = QSqlDatabase::addDatabase(APP_DB_MYSQL_DRIVER, connection_name);
   const QString database_name = qApp->settings()->value(GROUP(Database), SETTING(Database::MySQLDatabase)).toString();
 
@@ -656,8 +1202,9 @@ QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_
   else {
     QSqlQuery query_db(database);
     query_db.setForwardOnly(true);
+    mysqlConfigureConnection(database);
 
-    if (!query_db.exec(QString("USE %1").arg(database_name)) || !query_db.exec(QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
+    if (!DB_EXEC_SQL(query_db, QString("USE %1").arg(database_name)) || !DB_EXEC_SQL(query_db, QSL("SELECT inf_value FROM Information WHERE inf_key = 'schema_version'"))) {
       // If no "rssguard" database exists or schema version is wrong, then initialize it.
       qWarning("Error occurred. MySQL database is not initialized. Initializing now.");
 
@@ -675,7 +1222,7 @@ QSqlDatabase DatabaseFactory::mysqlInitializeDatabase(const QString &connection_
 
       foreach(QString statement, statements) {
         // Assign real database name and run the query.
-        query_db.exec(statement.replace(APP_DB_NAME_PLACEHOLDER, database_name));
+        DB_EXEC_SQL(query_db, statement.replace(APP_DB_NAME_PLACEHOLDER, database_name));
 
         if (query_db.lastError().isValid()) {
           qFatal("MySQL database initialization failed. Initialization script '%s' is not correct. Error : '%s'.",
@@ -720,7 +1267,7 @@ bool DatabaseFactory::mysqlVacuumDatabase() {
   QSqlDatabase database = mysqlConnection(objectName());
   QSqlQuery query_vacuum(database);
 
-  return query_vacuum.exec(QSL("OPTIMIZE TABLE rssguard.feeds;")) && query_vacuum.exec(QSL("OPTIMIZE TABLE rssguard.messages;"));
+  return DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE rssguard.feeds;")) && DB_EXEC_SQL(query_vacuum, QSL("OPTIMIZE TABLE rssguard.messages;"));
 }
 
 QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name, DatabaseFactory::DesiredType desired_type) {
@@ -756,6 +1303,7 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name, D
     }
     else {
       QSqlDatabase database;
+      bool is_new = false;
 
       if (QSqlDatabase::contains(connection_name)) {
         qDebug("SQLite connection '%s' is already active.", qPrintable(connection_name));
@@ -774,6 +1322,7 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name, D
 
         // Setup database file path.
         database.setDatabaseName(db_file.fileName());
+        is_new = true;
       }
 
       if (!database.isOpen() && !database.open()) {
@@ -781,6 +1330,10 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name, D
                qPrintable(database.lastError().text()));
       }
       else {
+        if (is_new) {
+          sqliteConfigureConnection(database);
+        }
+
         qDebug("File-based SQLite database connection '%s' to file '%s' seems to be established.",
                qPrintable(connection_name),
                qPrintable(QDir::toNativeSeparators(database.databaseName())));
@@ -791,6 +1344,27 @@ QSqlDatabase DatabaseFactory::sqliteConnection(const QString &connection_name, D
   }
 }
 
+void DatabaseFactory::mysqlConfigureConnection(QSqlDatabase database) {
+  QSqlQuery query_db(database);
+
+  // Connection must use the same character set as the database,
+  // otherwise characters outside of BMP are lost.
+  if (!DB_EXEC_SQL(query_db, QSL("SET NAMES utf8mb4"))) {
+    qWarning("Character set of MySQL connection was not set: '%s'.", qPrintable(query_db.lastError().text()));
+  }
+}
+
+void DatabaseFactory::sqliteConfigureConnection(QSqlDatabase database) {
+  QSqlQuery query_db(database);
+
+  query_db.setForwardOnly(true);
+  DB_EXEC_SQL(query_db, QSL("PRAGMA synchronous = OFF"));
+  DB_EXEC_SQL(query_db, QSL("PRAGMA journal_mode = MEMORY"));
+  DB_EXEC_SQL(query_db, QSL("PRAGMA cache_size = 16384"));
+  DB_EXEC_SQL(query_db, QSL("PRAGMA count_changes = OFF"));
+  DB_EXEC_SQL(query_db, QSL("PRAGMA temp_store = MEMORY"));
+}
+
 bool DatabaseFactory::sqliteVacuumDatabase() {  
   QSqlDatabase database;
 
@@ -807,7 +1381,10 @@ bool DatabaseFactory::sqliteVacuumDatabase() {
 
   QSqlQuery query_vacuum(database);
 
-  return query_vacuum.exec(QSL("VACUUM"));
+  // Full vacuuming also switches older database files to incremental
+  // mode, so that their free space can be reclaimed in small steps later.
+  DB_EXEC_SQL(query_vacuum, QSL("PRAGMA auto_vacuum = INCREMENTAL"));
+  return DB_EXEC_SQL(query_vacuum, QSL("VACUUM"));
 }
 
 void DatabaseFactory::saveDatabase() {
@@ -20,6 +20,13 @@
 
 #include <QObject>
 #include <QSqlDatabase>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+
+
+class QThread;
 
 
 class DatabaseFactory : public QObject {
@@ -51,6 +58,24 @@ class DatabaseFactory : public QObject {
       MySQLUnknownHost      = 2005
     };
 
+    struct ConnectionPoolStatistics {
+      // Number of connections created by the pool.
+      qint64 m_created;
+
+      // Number of times connection was handed out by the pool.
+      qint64 m_acquired;
+
+      // Number of connections which failed health check and were reopened.
+      qint64 m_failedHealthChecks;
+
+      // Number of connections currently owned by living threads.
+      int m_active;
+
+      // Number of connections created over the limit of the pool,
+      // because no other connection was released in time.
+      qint64 m_overflows;
+    };
+
     //
     // GENERAL stuff.
     //
@@ -67,11 +92,25 @@ class DatabaseFactory : public QObject {
     // Returns size of data contained in the DB file.
     qint64 getDatabaseDataSize() const;
 
+    // Returns size of free space in the DB file, which
+    // can be reclaimed by vacuuming.
+    qint64 getDatabaseReclaimableSize() const;
+
     // If in-memory is true, then :memory: database is returned
     // In-memory database is DEFAULT database.
     // NOTE: This always returns OPENED database.
     QSqlDatabase connection(const QString &connection_name, DesiredType desired_type = FromSettings);
 
+    // Returns connection owned by calling thread. Connection is created
+    // and configured on first use and it is removed once its thread
+    // finishes. Connection which was not used for some time
+    // is checked and reopened if it is not usable anymore.
+    // NOTE: This always returns OPENED database.
+    QSqlDatabase threadConnection(DesiredType desired_type = FromSettings);
+
+    ConnectionPoolStatistics connectionPoolStatistics() const;
+    void logConnectionPoolStatistics() const;
+
     QString humanDriverName(UsedDriver driver) const;
     QString humanDriverName(const QString &driver_code) const;
 
@@ -101,6 +140,31 @@ class DatabaseFactory : public QObject {
     //
     QString sqliteDatabaseFilePath() const;
 
+    // Returns path to archive database file of given account.
+    QString sqliteArchiveFilePath(int account_id) const;
+
+    // Returns true if SQLite database file reclaims its free space
+    // incrementally. Database file is switched to incremental mode
+    // when it is created or shrinked.
+    bool sqliteIncrementalVacuumEnabled() const;
+
+    // Reclaims at most given number of free pages of SQLite database file
+    // without rewriting whole file. Returns number of reclaimed bytes or -1
+    // if incremental vacuuming is not possible.
+    qint64 sqliteIncrementalVacuum(const QString &connection_name, int max_pages, qint64 *reclaimable_size = nullptr);
+
+    // Attaches archive database of given account to given connection
+    // and returns name of its schema. Empty string is returned if archive
+    // is not available, for example if it does not exist yet and
+    // "create_if_missing" is false.
+    QString sqliteAttachArchive(QSqlDatabase db, int account_id, bool create_if_missing);
+
+    // Detaches archive with given schema from given connection once all
+    // its users, which attached it via sqliteAttachArchive(), detach it.
+    // SQLite limits number of attached databases, so each attached
+    // archive must be detached once it is not needed anymore.
+    void sqliteDetachArchive(QSqlDatabase db, const QString &schema);
+
     //
     // MySQL stuff.
     //
@@ -126,6 +190,28 @@ class DatabaseFactory : public QObject {
     // Holds the type of currently activated database backend.
     UsedDriver m_activeDatabaseDriver;
 
+    // Checks if pooled connection is still usable, reopens it if it is not.
+    void checkPooledConnection(const QString &connection_name, QSqlDatabase &database);
+
+    // Removes pooled connection of finished thread.
+    void releasePooledConnection(const QString &connection_name);
+
+    // Removes all pooled connections of calling thread.
+    void releaseThreadConnections();
+
+    // Pooled connections with times of their last use.
+    mutable QMutex m_poolMutex;
+    QHash<QString,qint64> m_pooledConnections;
+    QWaitCondition m_poolConnectionReleased;
+    ConnectionPoolStatistics m_poolStatistics;
+
+    // Threads using shared in-memory connection.
+    QSet<QThread*> m_sharedConnectionThreads;
+
+    // Numbers of users of attached archives, hashed by connection names and schemas.
+    QMutex m_archivesMutex;
+    QHash<QString,QHash<QString,int> > m_attachedArchives;
+
     //
     // MYSQL stuff.
     //
@@ -142,6 +228,9 @@ class DatabaseFactory : public QObject {
     // Runs "VACUUM" on the database.
     bool mysqlVacuumDatabase();
 
+    // Sets session-level options of newly opened connection.
+    void mysqlConfigureConnection(QSqlDatabase database);
+
     // True if MySQL database is fully initialized for use,
     // otherwise false.
     bool m_mysqlDatabaseInitialized;
@@ -152,9 +241,19 @@ class DatabaseFactory : public QObject {
 
     QSqlDatabase sqliteConnection(const QString &connection_name, DesiredType desired_type);
 
+    // Sets connection-level options of newly opened connection.
+    void sqliteConfigureConnection(QSqlDatabase database);
+
     // Runs "VACUUM" on the database.
     bool sqliteVacuumDatabase();
 
+    // Returns size of free pages in given SQLite database or -1 on error.
+    qint64 sqliteReclaimableSize(QSqlDatabase database) const;
+
+    // Returns comma-separated names of columns of given table. Tables which were
+    // upgraded may have their columns in different order than new tables.
+    QString sqliteTableColumns(QSqlDatabase database, const QString &schema, const QString &table) const;
+
     // Performs saving of items from in-memory database
     // to file-based database.
     void sqliteSaveMemoryDatabase();
@@ -165,6 +264,9 @@ class DatabaseFactory : public QObject {
     // Updates database schema.
     bool sqliteUpdateDatabaseSchema(QSqlDatabase database, const QString &source_db_schema_version);
 
+    // Adds columns introduced after archive of given schema was created.
+    bool sqliteUpdateArchiveSchema(QSqlDatabase database, const QString &schema);
+
     // Creates new connection, initializes database and
     // returns opened connections.
     QSqlDatabase sqliteInitializeInMemoryDatabase();
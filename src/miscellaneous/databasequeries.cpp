@@ -32,18 +32,22 @@
 #include "miscellaneous/textfactory.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/iconfactory.h"
+#include "miscellaneous/databasequerycache.h"
+#include "miscellaneous/databasequeryprofiler.h"
+#include "network-web/webfactory.h"
 
 #include <QVariant>
 #include <QUrl>
 #include <QSqlError>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QRegularExpression>
 
 
 bool DatabaseQueries::markMessagesReadUnread(QSqlDatabase db, const QStringList &ids, RootItem::ReadStatus read) {
-  QSqlQuery q(db);
-  q.setForwardOnly(true);
-
-  return q.exec(QString(QSL("UPDATE Messages SET is_read = %2 WHERE id IN (%1);"))
-                .arg(ids.join(QSL(", ")), read == RootItem::Read ? QSL("1") : QSL("0")));
+  return execForMessageIds(db, QString(QSL("UPDATE Messages SET is_read = %1 WHERE id IN (%2);"))
+                           .arg(read == RootItem::Read ? QSL("1") : QSL("0")), ids);
 }
 
 bool DatabaseQueries::markMessageImportant(QSqlDatabase db, int id, RootItem::Importance importance) {
@@ -59,19 +63,19 @@ bool DatabaseQueries::markMessageImportant(QSqlDatabase db, int id, RootItem::Im
   q.bindValue(QSL(":important"), (int) importance);
 
   // Commit changes.
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markFeedsReadUnread(QSqlDatabase db, const QStringList &ids, int account_id, RootItem::ReadStatus read) {
   QSqlQuery q(db);
   q.setForwardOnly(true);
   q.prepare(QString("UPDATE Messages SET is_read = :read "
-                    "WHERE feed IN (%1) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;").arg(ids.join(QSL(", "))));
+                    "WHERE feed_id IN (%1) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;").arg(ids.join(QSL(", "))));
 
   q.bindValue(QSL(":read"), read == RootItem::Read ? 1 : 0);
   q.bindValue(QSL(":account_id"), account_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markBinReadUnread(QSqlDatabase db, int account_id, RootItem::ReadStatus read) {
@@ -83,7 +87,7 @@ bool DatabaseQueries::markBinReadUnread(QSqlDatabase db, int account_id, RootIte
   q.bindValue(QSL(":read"), read == RootItem::Read ? 1 : 0);
   q.bindValue(QSL(":account_id"), account_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::markAccountReadUnread(QSqlDatabase db, int account_id, RootItem::ReadStatus read) {
@@ -94,30 +98,65 @@ bool DatabaseQueries::markAccountReadUnread(QSqlDatabase db, int account_id, Roo
   q.bindValue(QSL(":account_id"), account_id);
   q.bindValue(QSL(":read"), read == RootItem::Read ? 1 : 0);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::switchMessagesImportance(QSqlDatabase db, const QStringList &ids) {
-  QSqlQuery q(db);
-  q.setForwardOnly(true);
-
-  return q.exec(QString(QSL("UPDATE Messages SET is_important = NOT is_important WHERE id IN (%1);")).arg(ids.join(QSL(", "))));
+  return execForMessageIds(db, QSL("UPDATE Messages SET is_important = NOT is_important WHERE id IN (%1);"), ids);
 }
 
 bool DatabaseQueries::permanentlyDeleteMessages(QSqlDatabase db, const QStringList &ids) {
+  return execForMessageIds(db, QSL("UPDATE Messages SET is_pdeleted = 1 WHERE id IN (%1);"), ids);
+}
+
+bool DatabaseQueries::deleteOrRestoreMessagesToFromBin(QSqlDatabase db, const QStringList &ids, bool deleted) {
+  return execForMessageIds(db, QString(QSL("UPDATE Messages SET is_deleted = %1, is_pdeleted = 0 WHERE id IN (%2);"))
+                           .arg(QString::number(deleted ? 1 : 0)), ids);
+}
+
+QSet<int> DatabaseQueries::archivedMessageIds(QSqlDatabase db, const QString &archive_schema, const QStringList &ids, bool *ok) {
   QSqlQuery q(db);
+  QSet<int> archived_ids;
+
   q.setForwardOnly(true);
 
-  return q.exec(QString(QSL("UPDATE Messages SET is_pdeleted = 1 WHERE id IN (%1);")).arg(ids.join(QSL(", "))));
+  for (int i = 0; i < ids.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    if (!DB_EXEC_SQL(q, QString(QSL("SELECT id FROM %1.Messages WHERE id IN (%2);")).arg(archive_schema,
+                                                                                        ids.mid(i, MESSAGES_BULK_CHUNK_SIZE).join(QSL(", "))))) {
+      qWarning("Checking of archived messages failed: '%s'.", qPrintable(q.lastError().text()));
+
+      if (ok != nullptr) {
+        *ok = false;
+      }
+
+      return archived_ids;
+    }
+
+    while (q.next()) {
+      archived_ids.insert(q.value(0).toInt());
+    }
+  }
+
+  if (ok != nullptr) {
+    *ok = true;
+  }
+
+  return archived_ids;
 }
 
-bool DatabaseQueries::deleteOrRestoreMessagesToFromBin(QSqlDatabase db, const QStringList &ids, bool deleted) {
+bool DatabaseQueries::execForMessageIds(QSqlDatabase db, const QString &statement, const QStringList &ids) {
   QSqlQuery q(db);
   q.setForwardOnly(true);
 
-  return q.exec(QString(QSL("UPDATE Messages SET is_deleted = %2, is_pdeleted = %3 WHERE id IN (%1);")).arg(ids.join(QSL(", ")),
-                                                                                                            QString::number(deleted ? 1 : 0),
-                                                                                                            QString::number(0)));
+  // Long lists of IDs are split, so that statements do not hit SQL length limits.
+  for (int i = 0; i < ids.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    if (!DB_EXEC_SQL(q, statement.arg(ids.mid(i, MESSAGES_BULK_CHUNK_SIZE).join(QSL(", "))))) {
+      qWarning("Bulk update of messages failed: '%s'.", qPrintable(q.lastError().text()));
+      return false;
+    }
+  }
+
+  return true;
 }
 
 bool DatabaseQueries::restoreBin(QSqlDatabase db, int account_id) {
@@ -127,7 +166,7 @@ bool DatabaseQueries::restoreBin(QSqlDatabase db, int account_id) {
             "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
   q.bindValue(QSL(":account_id"), account_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::purgeImportantMessages(QSqlDatabase db) {
@@ -135,7 +174,7 @@ bool DatabaseQueries::purgeImportantMessages(QSqlDatabase db) {
   q.setForwardOnly(true);
   q.prepare(QSL("DELETE FROM Messages WHERE is_important = 1;"));
 
-  return q.exec();
+  return DB_EXEC(q) && purgeOrphanedMessageData(db);
 }
 
 bool DatabaseQueries::purgeReadMessages(QSqlDatabase db) {
@@ -150,7 +189,7 @@ bool DatabaseQueries::purgeReadMessages(QSqlDatabase db) {
   // Remove only messages which are NOT starred.
   q.bindValue(QSL(":is_important"), 0);
 
-  return q.exec();
+  return DB_EXEC(q) && purgeOrphanedMessageData(db);
 }
 
 bool DatabaseQueries::purgeOldMessages(QSqlDatabase db, int older_than_days) {
@@ -164,7 +203,24 @@ bool DatabaseQueries::purgeOldMessages(QSqlDatabase db, int older_than_days) {
   // Remove only messages which are NOT starred.
   q.bindValue(QSL(":is_important"), 0);
 
-  return q.exec();
+  return DB_EXEC(q) && purgeOrphanedMessageData(db);
+}
+
+bool DatabaseQueries::purgeOrphanedMessageData(QSqlDatabase db) {
+  QSqlQuery q(db);
+  q.setForwardOnly(true);
+
+  if (!DB_EXEC_SQL(q, QSL("DELETE FROM MessageBodies WHERE message_id NOT IN (SELECT id FROM Messages);"))) {
+    qWarning("Removing of orphaned message bodies failed: '%s'.", qPrintable(q.lastError().text()));
+    return false;
+  }
+  else if (!DB_EXEC_SQL(q, QSL("DELETE FROM MessagesFts WHERE docid NOT IN (SELECT id FROM Messages);"))) {
+    qWarning("Removing of orphaned search index entries failed: '%s'.", qPrintable(q.lastError().text()));
+    return false;
+  }
+  else {
+    return true;
+  }
 }
 
 bool DatabaseQueries::purgeRecycleBin(QSqlDatabase db) {
@@ -177,7 +233,294 @@ bool DatabaseQueries::purgeRecycleBin(QSqlDatabase db) {
   // Remove only messages which are NOT starred.
   q.bindValue(QSL(":is_important"), 0);
 
-  return q.exec();
+  return DB_EXEC(q) && purgeOrphanedMessageData(db);
+}
+
+int DatabaseQueries::compressMessageContents(QSqlDatabase db, int batch_size, qint64 *saved_bytes, bool *ok) {
+  QSqlQuery query_select(db);
+  QSqlQuery query_update(db);
+  int compressed_messages = 0;
+  qint64 saved = 0;
+  int last_id = -1;
+  bool batch_empty = false;
+
+  query_select.setForwardOnly(true);
+  query_select.prepare(QSL("SELECT message_id, contents FROM MessageBodies WHERE message_id > :id ORDER BY message_id ASC LIMIT :limit;"));
+  query_update.setForwardOnly(true);
+  query_update.prepare(QSL("UPDATE MessageBodies SET contents = :contents WHERE message_id = :id;"));
+
+  while (!batch_empty) {
+    QList<QPair<int,QString> > batch;
+
+    query_select.bindValue(QSL(":id"), last_id);
+    query_select.bindValue(QSL(":limit"), batch_size);
+
+    if (!DB_EXEC(query_select)) {
+      qWarning("Failed to obtain messages for compression: '%s'.", qPrintable(query_select.lastError().text()));
+
+      if (ok != nullptr) {
+        *ok = false;
+      }
+
+      return compressed_messages;
+    }
+
+    while (query_select.next()) {
+      last_id = query_select.value(0).toInt();
+      batch.append(QPair<int,QString>(last_id, query_select.value(1).toString()));
+    }
+
+    query_select.finish();
+    batch_empty = batch.isEmpty();
+
+    if (batch_empty) {
+      break;
+    }
+
+    // Each batch is committed separately, so that the database is not
+    // locked for whole duration of the migration.
+    db.transaction();
+
+    for (int i = 0; i < batch.size(); i++) {
+      const QString &contents = batch.at(i).second;
+
+      if (TextFactory::isTextCompressed(contents)) {
+        continue;
+      }
+
+      const QString compressed_contents = TextFactory::compressText(contents);
+
+      if (compressed_contents == contents) {
+        // Message is too short to benefit from compression.
+        continue;
+      }
+
+      query_update.bindValue(QSL(":contents"), compressed_contents);
+      query_update.bindValue(QSL(":id"), batch.at(i).first);
+
+      if (DB_EXEC(query_update)) {
+        compressed_messages++;
+        saved += contents.toUtf8().size() - compressed_contents.size();
+      }
+      else {
+        qWarning("Failed to compress contents of message with ID %d: '%s'.", batch.at(i).first, qPrintable(query_update.lastError().text()));
+      }
+
+      query_update.finish();
+    }
+
+    if (!db.commit()) {
+      qCritical("Transaction commit for contents compression failed: '%s'.", qPrintable(db.lastError().text()));
+      db.rollback();
+
+      if (ok != nullptr) {
+        *ok = false;
+      }
+
+      return compressed_messages;
+    }
+  }
+
+  qDebug("Compressed contents of %d messages, %lld bytes saved.", compressed_messages, saved);
+
+  if (saved_bytes != nullptr) {
+    *saved_bytes = saved;
+  }
+
+  if (ok != nullptr) {
+    *ok = true;
+  }
+
+  return compressed_messages;
+}
+
+bool DatabaseQueries::indexCompressedMessages(QSqlDatabase db, int batch_size) {
+  QSqlQuery query_select(db);
+  int last_id = -1;
+  int indexed_messages = 0;
+
+  query_select.setForwardOnly(true);
+  query_select.prepare(QSL("SELECT Messages.id, Messages.title, Messages.author, MessageBodies.contents "
+                           "FROM Messages JOIN MessageBodies ON Messages.id = MessageBodies.message_id "
+                           "WHERE Messages.id > :id AND MessageBodies.contents LIKE :header "
+                           "ORDER BY Messages.id ASC LIMIT :limit;"));
+
+  while (true) {
+    QList<QVariantList> search_rows;
+
+    query_select.bindValue(QSL(":id"), last_id);
+    query_select.bindValue(QSL(":header"), QSL(COMPRESSED_TEXT_HEADER) + QL1C('%'));
+    query_select.bindValue(QSL(":limit"), batch_size);
+
+    if (!DB_EXEC(query_select)) {
+      qWarning("Failed to obtain compressed messages for search index: '%s'.", qPrintable(query_select.lastError().text()));
+      return false;
+    }
+
+    while (query_select.next()) {
+      last_id = query_select.value(0).toInt();
+      search_rows.append(QVariantList() << last_id << query_select.value(1) << query_select.value(2) <<
+                         WebFactory::instance()->stripTags(TextFactory::decompressText(query_select.value(3).toString())));
+    }
+
+    query_select.finish();
+
+    if (search_rows.isEmpty()) {
+      break;
+    }
+
+    if (!execMultiRowStatement(db, QSL("REPLACE INTO MessagesFts (docid, title, author, contents) VALUES "), QSL(";"), search_rows)) {
+      qWarning("Failed to index compressed messages: '%s'.", qPrintable(db.lastError().text()));
+      return false;
+    }
+
+    indexed_messages += search_rows.size();
+  }
+
+  qDebug("Indexed contents of %d compressed messages.", indexed_messages);
+  return true;
+}
+
+int DatabaseQueries::archiveOldMessages(QSqlDatabase db, int older_than_days, int batch_size, bool *ok) {
+  if (qApp->database()->activeDatabaseDriver() == DatabaseFactory::MYSQL) {
+    qWarning("Archiving of messages is not supported for MySQL.");
+
+    if (ok != nullptr) {
+      *ok = false;
+    }
+
+    return 0;
+  }
+
+  const qint64 since_epoch = QDateTime::currentDateTimeUtc().addDays(-older_than_days).toMSecsSinceEpoch();
+  QSqlQuery q(db);
+  QList<int> account_ids;
+  int archived_messages = 0;
+
+  q.setForwardOnly(true);
+
+  if (!DB_EXEC_SQL(q, QSL("SELECT DISTINCT account_id FROM main.Messages;"))) {
+    qWarning("Failed to obtain accounts for archiving: '%s'.", qPrintable(q.lastError().text()));
+
+    if (ok != nullptr) {
+      *ok = false;
+    }
+
+    return archived_messages;
+  }
+
+  while (q.next()) {
+    account_ids.append(q.value(0).toInt());
+  }
+
+  q.finish();
+
+  foreach (int account_id, account_ids) {
+    const QString schema = qApp->database()->sqliteAttachArchive(db, account_id, true);
+
+    if (schema.isEmpty()) {
+      if (ok != nullptr) {
+        *ok = false;
+      }
+
+      return archived_messages;
+    }
+
+    const bool moved = moveMessagesToArchive(db, account_id, schema, since_epoch, batch_size, archived_messages);
+
+    qApp->database()->sqliteDetachArchive(db, schema);
+
+    if (!moved) {
+      if (ok != nullptr) {
+        *ok = false;
+      }
+
+      return archived_messages;
+    }
+  }
+
+  qDebug("Moved %d messages to archive.", archived_messages);
+
+  if (ok != nullptr) {
+    *ok = true;
+  }
+
+  return archived_messages;
+}
+
+bool DatabaseQueries::moveMessagesToArchive(QSqlDatabase db, int account_id, const QString &schema,
+                                            qint64 since_epoch, int batch_size, int &archived_messages) {
+  const QStringList move_statements = QStringList() <<
+    QSL("INSERT INTO %1.Messages (id, is_read, is_deleted, is_important, feed, feed_id, title, url, author, date_created, "
+        "is_pdeleted, account_id, custom_id, custom_hash, identity_hash, contents_hash, contents, enclosures) "
+        "SELECT Messages.id, Messages.is_read, Messages.is_deleted, Messages.is_important, Messages.feed, Messages.feed_id, "
+        "Messages.title, Messages.url, Messages.author, Messages.date_created, Messages.is_pdeleted, Messages.account_id, Messages.custom_id, "
+        "Messages.custom_hash, Messages.identity_hash, Messages.contents_hash, MessageBodies.contents, MessageBodies.enclosures "
+        "FROM main.Messages LEFT JOIN main.MessageBodies ON Messages.id = MessageBodies.message_id WHERE Messages.id IN (%2);") <<
+    QSL("DELETE FROM %1.MessagesFts WHERE docid IN (%2);") <<
+    QSL("INSERT INTO %1.MessagesFts (docid, title, author, contents) "
+        "SELECT docid, title, author, contents FROM main.MessagesFts WHERE docid IN (%2);") <<
+    QSL("DELETE FROM main.MessageBodies WHERE message_id IN (%2);") <<
+    QSL("DELETE FROM main.MessagesFts WHERE docid IN (%2);") <<
+    QSL("DELETE FROM main.Messages WHERE id IN (%2);");
+  QSqlQuery q(db);
+
+  // IDs of messages are never reused, but databases created before that
+  // could reuse them. Such messages are kept, so that no archived message is overwritten.
+  QSqlQuery query_select(db);
+
+  query_select.setForwardOnly(true);
+  query_select.prepare(QString(QSL("SELECT id FROM main.Messages "
+                                   "WHERE account_id = :account_id AND is_read = 1 AND is_important = 0 AND is_deleted = 0 AND "
+                                   "is_pdeleted = 0 AND date_created < :date_created AND id NOT IN (SELECT id FROM %1.Messages) "
+                                   "LIMIT :limit;")).arg(schema));
+
+  while (true) {
+    QStringList ids;
+
+    query_select.bindValue(QSL(":account_id"), account_id);
+    query_select.bindValue(QSL(":date_created"), since_epoch);
+    query_select.bindValue(QSL(":limit"), batch_size);
+
+    if (!DB_EXEC(query_select)) {
+      qWarning("Failed to obtain messages for archiving: '%s'.", qPrintable(query_select.lastError().text()));
+      return false;
+    }
+
+    while (query_select.next()) {
+      ids.append(query_select.value(0).toString());
+    }
+
+    query_select.finish();
+
+    if (ids.isEmpty()) {
+      break;
+    }
+
+    const QString id_list = ids.join(QSL(", "));
+
+    // Each batch is moved in separate transaction, so that
+    // the database is not locked for whole duration of archiving.
+    db.transaction();
+
+    foreach (const QString &statement, move_statements) {
+      if (!DB_EXEC_SQL(q, statement.arg(schema, id_list))) {
+        qCritical("Failed to move messages to archive '%s': '%s'.", qPrintable(schema), qPrintable(q.lastError().text()));
+        db.rollback();
+        return false;
+      }
+    }
+
+    if (!db.commit()) {
+      qCritical("Transaction commit for archiving failed: '%s'.", qPrintable(db.lastError().text()));
+      db.rollback();
+      return false;
+    }
+
+    archived_messages += ids.size();
+  }
+
+  return true;
 }
 
 QMap<int,QPair<int,int> > DatabaseQueries::getMessageCountsForCategory(QSqlDatabase db, int custom_id, int account_id,
@@ -186,21 +529,14 @@ QMap<int,QPair<int,int> > DatabaseQueries::getMessageCountsForCategory(QSqlDatab
   QSqlQuery q(db);
   q.setForwardOnly(true);
 
-  if (including_total_counts) {
-    q.prepare("SELECT feed, sum((is_read + 1) % 2), count(*) FROM Messages "
-              "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-              "GROUP BY feed;");
-  }
-  else {
-    q.prepare("SELECT feed, sum((is_read + 1) % 2) FROM Messages "
-              "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-              "GROUP BY feed;");
-  }
+  // Counters are maintained by database triggers, see MessageCounters table.
+  q.prepare("SELECT feed, unread_count, total_count FROM MessageCounters "
+            "WHERE feed IN (SELECT custom_id FROM Feeds WHERE category = :category AND account_id = :account_id) AND account_id = :account_id;");
 
   q.bindValue(QSL(":category"), custom_id);
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     while (q.next()) {
       int feed_id = q.value(0).toInt();
       int unread_count = q.value(1).toInt();
@@ -234,20 +570,11 @@ QMap<int,QPair<int,int> > DatabaseQueries::getMessageCountsForAccount(QSqlDataba
   QSqlQuery q(db);
   q.setForwardOnly(true);
 
-  if (including_total_counts) {
-    q.prepare("SELECT feed, sum((is_read + 1) % 2), count(*) FROM Messages "
-              "WHERE is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-              "GROUP BY feed;");
-  }
-  else {
-    q.prepare("SELECT feed, sum((is_read + 1) % 2) FROM Messages "
-              "WHERE is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id "
-              "GROUP BY feed;");
-  }
+  q.prepare("SELECT feed, unread_count, total_count FROM MessageCounters WHERE account_id = :account_id;");
 
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     while (q.next()) {
       int feed_id = q.value(0).toInt();
       int unread_count = q.value(1).toInt();
@@ -275,82 +602,265 @@ QMap<int,QPair<int,int> > DatabaseQueries::getMessageCountsForAccount(QSqlDataba
   return counts;
 }
 
-int DatabaseQueries::getMessageCountsForFeed(QSqlDatabase db, int feed_custom_id,
-                                             int account_id, bool including_total_counts, bool *ok) {
-  QSqlQuery q(db);
-  q.setForwardOnly(true);
+QPair<int,int> DatabaseQueries::getMessageCountsForFeed(QSqlDatabase db, int feed_custom_id, int account_id, bool *ok) {
+  // NOTE: Aggregate function makes sure that we always get one row,
+  // even if there is no counter record for the feed yet.
+  QSqlQuery q = DatabaseQueryCache::preparedQuery(db, QSL("SELECT IFNULL(sum(unread_count), 0), IFNULL(sum(total_count), 0) "
+                                                          "FROM MessageCounters WHERE feed = :feed AND account_id = :account_id;"));
+  QPair<int,int> counts(0, 0);
+
+  q.bindValue(QSL(":feed"), feed_custom_id);
+  q.bindValue(QSL(":account_id"), account_id);
 
-  if (including_total_counts) {
-    q.prepare("SELECT count(*) FROM Messages "
-              "WHERE feed = :feed AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
+  const bool fetched = DB_EXEC(q) && q.next();
+
+  if (fetched) {
+    counts.first = q.value(0).toInt();
+    counts.second = q.value(1).toInt();
   }
-  else {
-    q.prepare("SELECT count(*) FROM Messages "
-              "WHERE feed = :feed AND is_deleted = 0 AND is_pdeleted = 0 AND is_read = 0 AND account_id = :account_id;");
+
+  q.finish();
+
+  if (ok != nullptr) {
+    *ok = fetched;
   }
 
-  q.bindValue(QSL(":feed"), feed_custom_id);
+  return counts;
+}
+
+QPair<int,int> DatabaseQueries::getMessageCountsForBin(QSqlDatabase db, int account_id, bool *ok) {
+  QSqlQuery q = DatabaseQueryCache::preparedQuery(db, QSL("SELECT IFNULL(sum(bin_unread_count), 0), IFNULL(sum(bin_total_count), 0) "
+                                                          "FROM MessageCounters WHERE account_id = :account_id;"));
+  QPair<int,int> counts(0, 0);
+
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (q.exec() && q.next()) {
+  const bool fetched = DB_EXEC(q) && q.next();
+
+  if (fetched) {
+    counts.first = q.value(0).toInt();
+    counts.second = q.value(1).toInt();
+  }
+
+  q.finish();
+
+  if (ok != nullptr) {
+    *ok = fetched;
+  }
+
+  return counts;
+}
+
+QList<int> DatabaseQueries::searchMessages(QSqlDatabase db, const QString &pattern, const QString &filter,
+                                           const QString &archive_schema, int limit, bool *ok) {
+  QList<int> ids;
+  const bool is_mysql = qApp->database()->activeDatabaseDriver() == DatabaseFactory::MYSQL;
+  QString plain_pattern = pattern;
+
+  if (is_mysql) {
+    // Operators of boolean mode would change meaning of terms, SQLite terms are quoted instead.
+    plain_pattern.replace(QRegularExpression(QSL("[-+<>()~*@\"]")), QSL(" "));
+  }
+
+  QStringList terms = plain_pattern.simplified().remove(QL1C('"')).split(QL1C(' '), QString::SkipEmptyParts);
+  QSqlQuery q(db);
+
+  q.setForwardOnly(true);
+
+  if (terms.isEmpty()) {
     if (ok != nullptr) {
       *ok = true;
     }
 
-    return q.value(0).toInt();
+    return ids;
+  }
+
+  // All terms are required and matched as prefixes.
+  for (int i = 0; i < terms.size(); i++) {
+    terms[i] = is_mysql ? QString(QSL("+%1*")).arg(terms.at(i)) : QString(QSL("\"%1*\"")).arg(terms.at(i));
+  }
+
+  if (is_mysql) {
+    q.prepare(QString(QSL("SELECT MessagesFts.docid, Messages.date_created, "
+                          "MATCH(MessagesFts.title, MessagesFts.author, MessagesFts.contents) AGAINST (:rank_pattern IN BOOLEAN MODE) "
+                          "FROM MessagesFts JOIN Messages ON Messages.id = MessagesFts.docid "
+                          "WHERE MATCH(MessagesFts.title, MessagesFts.author, MessagesFts.contents) AGAINST (:pattern IN BOOLEAN MODE) AND "
+                          "(%1) ORDER BY 3 DESC, 2 DESC LIMIT :limit;")).arg(filter));
+    q.bindValue(QSL(":rank_pattern"), terms.join(QL1C(' ')));
   }
   else {
+    // FTS4 has no ranking function, number of matched terms is obtained
+    // from offsets(), which returns four numbers for each of them.
+    const QString rank = QSL("(length(offsets(MessagesFts)) - length(replace(offsets(MessagesFts), ' ', '')) + 1) / 4");
+    QString statement = QString(QSL("SELECT MessagesFts.docid, Messages.date_created, %1 "
+                                    "FROM MessagesFts JOIN Messages ON Messages.id = MessagesFts.docid "
+                                    "WHERE MessagesFts MATCH :pattern AND (%2)")).arg(rank, filter);
+
+    if (!archive_schema.isEmpty()) {
+      // NOTE: FTS tables cannot be aliased in MATCH, therefore archived messages
+      // are aliased instead, so that the filter applies to them too.
+      statement += QString(QSL(" UNION ALL SELECT MessagesFts.docid, Messages.date_created, %1 "
+                               "FROM %2.MessagesFts JOIN %2.Messages AS Messages ON Messages.id = MessagesFts.docid "
+                               "WHERE MessagesFts MATCH :pattern AND (%3)")).arg(rank, archive_schema, filter);
+    }
+
+    q.prepare(statement + QSL(" ORDER BY 3 DESC, 2 DESC LIMIT :limit;"));
+  }
+
+  q.bindValue(QSL(":pattern"), terms.join(QL1C(' ')));
+  q.bindValue(QSL(":limit"), limit);
+
+  if (!DB_EXEC(q)) {
+    qWarning("Full-text search of messages failed: '%s'.", qPrintable(q.lastError().text()));
+
     if (ok != nullptr) {
       *ok = false;
     }
 
-    return 0;
+    return ids;
+  }
+
+  while (q.next()) {
+    ids.append(q.value(0).toInt());
+  }
+
+  if (ok != nullptr) {
+    *ok = true;
   }
+
+  return ids;
+}
+
+QString DatabaseQueries::messagesWithoutBodiesSelect() {
+  return QSL("SELECT Messages.id, Messages.is_read, Messages.is_deleted, Messages.is_important, Messages.feed, Messages.title, "
+             "Messages.url, Messages.author, Messages.date_created, NULL, Messages.is_pdeleted, "
+             "NULL, Messages.account_id, Messages.custom_id, Messages.custom_hash "
+             "FROM Messages");
+}
+
+QString DatabaseQueries::messagesWithBodiesSelect() {
+  return QSL("SELECT Messages.id, Messages.is_read, Messages.is_deleted, Messages.is_important, Messages.feed, Messages.title, "
+             "Messages.url, Messages.author, Messages.date_created, MessageBodies.contents, Messages.is_pdeleted, "
+             "MessageBodies.enclosures, Messages.account_id, Messages.custom_id, Messages.custom_hash "
+             "FROM Messages LEFT JOIN MessageBodies ON Messages.id = MessageBodies.message_id");
 }
 
-int DatabaseQueries::getMessageCountsForBin(QSqlDatabase db, int account_id, bool including_total_counts, bool *ok) {
+bool DatabaseQueries::fillMessages(QSqlDatabase db, const QString &statement, QList<Message> &messages, QHash<int,int> &rows) {
   QSqlQuery q(db);
+  QStringList ids;
+
   q.setForwardOnly(true);
 
-  if (including_total_counts) {
-    q.prepare("SELECT count(*) FROM Messages "
-              "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
+  foreach (int id, rows.keys()) {
+    ids.append(QString::number(id));
   }
-  else {
-    q.prepare("SELECT count(*) FROM Messages "
-              "WHERE is_read = 0 AND is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
+
+  // Long lists of IDs are split, so that statements do not hit SQL length limits.
+  for (int i = 0; i < ids.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    if (!DB_EXEC_SQL(q, statement.arg(ids.mid(i, MESSAGES_BULK_CHUNK_SIZE).join(QSL(", "))))) {
+      qWarning("Loading of messages failed: '%s'.", qPrintable(q.lastError().text()));
+      return false;
+    }
+
+    while (q.next()) {
+      bool decoded;
+      const Message message = Message::fromSqlRecord(q.record(), &decoded);
+
+      if (decoded && rows.contains(message.m_id)) {
+        messages[rows.take(message.m_id)] = message;
+      }
+    }
   }
 
-  q.bindValue(QSL(":account_id"), account_id);
+  return true;
+}
 
-  if (q.exec() && q.next()) {
-    if (ok != nullptr) {
-      *ok = true;
+bool DatabaseQueries::loadMessagesWithBodies(QSqlDatabase db, QList<Message> &messages) {
+  QHash<int,int> rows;
+  QSet<int> account_ids;
+
+  for (int i = 0; i < messages.size(); i++) {
+    rows.insert(messages.at(i).m_id, i);
+  }
+
+  if (!fillMessages(db, messagesWithBodiesSelect() + QSL(" WHERE Messages.id IN (%1);"), messages, rows)) {
+    return false;
+  }
+
+  // Remaining messages are not in main database, they may be archived.
+  foreach (int row, rows) {
+    account_ids.insert(messages.at(row).m_accountId);
+  }
+
+  foreach (int account_id, account_ids) {
+    const QString archive_schema = qApp->database()->sqliteAttachArchive(db, account_id, false);
+    const bool filled = archive_schema.isEmpty() || rows.isEmpty() ||
+                        fillMessages(db, QString(QSL("SELECT id, is_read, is_deleted, is_important, feed, title, url, author, date_created, "
+                                                     "contents, is_pdeleted, enclosures, account_id, custom_id, custom_hash "
+                                                     "FROM %1.Messages")).arg(archive_schema) +
+                                     QSL(" WHERE id IN (%1);"), messages, rows);
+
+    qApp->database()->sqliteDetachArchive(db, archive_schema);
+
+    if (!filled) {
+      return false;
     }
+  }
+
+  return true;
+}
+
+bool DatabaseQueries::loadMessageBody(QSqlDatabase db, Message &message) {
+  QSqlQuery q = DatabaseQueryCache::preparedQuery(db, QSL("SELECT contents, enclosures FROM MessageBodies WHERE message_id = :message_id;"));
+  q.bindValue(QSL(":message_id"), message.m_id);
 
-    return q.value(0).toInt();
+  if (!DB_EXEC(q)) {
+    qWarning("Loading of message body failed: '%s'.", qPrintable(q.lastError().text()));
+    q.finish();
+    return false;
   }
-  else {
-    if (ok != nullptr) {
-      *ok = false;
+  else if (q.next()) {
+    message.m_contents = TextFactory::decompressText(q.value(0).toString());
+    message.m_enclosures = Enclosures::decodeEnclosuresFromString(q.value(1).toString());
+    q.finish();
+    return true;
+  }
+
+  q.finish();
+
+  // Message is not in main database, it may be archived.
+  const QString archive_schema = qApp->database()->sqliteAttachArchive(db, message.m_accountId, false);
+
+  if (!archive_schema.isEmpty()) {
+    QSqlQuery query_archive(db);
+
+    query_archive.setForwardOnly(true);
+    query_archive.prepare(QString(QSL("SELECT contents, enclosures FROM %1.Messages WHERE id = :id;")).arg(archive_schema));
+    query_archive.bindValue(QSL(":id"), message.m_id);
+
+    if (DB_EXEC(query_archive) && query_archive.next()) {
+      message.m_contents = TextFactory::decompressText(query_archive.value(0).toString());
+      message.m_enclosures = Enclosures::decodeEnclosuresFromString(query_archive.value(1).toString());
     }
 
-    return 0;
+    query_archive.finish();
+    qApp->database()->sqliteDetachArchive(db, archive_schema);
   }
+
+  return true;
 }
 
 QList<Message> DatabaseQueries::getUndeletedMessagesForFeed(QSqlDatabase db, int feed_custom_id, int account_id, bool *ok) {
   QList<Message> messages;
   QSqlQuery q(db);
   q.setForwardOnly(true);
-  q.prepare("SELECT * "
-            "FROM Messages "
-            "WHERE is_deleted = 0 AND is_pdeleted = 0 AND feed = :feed AND account_id = :account_id;");
+  q.prepare(messagesWithoutBodiesSelect() +
+            QSL(" WHERE Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.feed = :feed AND Messages.account_id = :account_id;"));
 
   q.bindValue(QSL(":feed"), feed_custom_id);
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     while (q.next()) {
       bool decoded;
       Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -377,13 +887,12 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForBin(QSqlDatabase db, int
   QList<Message> messages;
   QSqlQuery q(db);
   q.setForwardOnly(true);
-  q.prepare("SELECT * "
-            "FROM Messages "
-            "WHERE is_deleted = 1 AND is_pdeleted = 0 AND account_id = :account_id;");
+  q.prepare(messagesWithoutBodiesSelect() +
+            QSL(" WHERE Messages.is_deleted = 1 AND Messages.is_pdeleted = 0 AND Messages.account_id = :account_id;"));
 
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     while (q.next()) {
       bool decoded;
       Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -410,12 +919,11 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForAccount(QSqlDatabase db,
   QList<Message> messages;
   QSqlQuery q(db);
   q.setForwardOnly(true);
-  q.prepare("SELECT * "
-            "FROM Messages "
-            "WHERE is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;");
+  q.prepare(messagesWithoutBodiesSelect() +
+            QSL(" WHERE Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.account_id = :account_id;"));
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     while (q.next()) {
       bool decoded;
       Message message = Message::fromSqlRecord(q.record(), &decoded);
@@ -441,98 +949,127 @@ QList<Message> DatabaseQueries::getUndeletedMessagesForAccount(QSqlDatabase db,
 int DatabaseQueries::updateMessages(QSqlDatabase db,
                                     const QList<Message> &messages,
                                     int feed_custom_id,
+                                    int feed_id,
                                     int account_id,
                                     const QString &url,
                                     bool *any_message_changed,
-                                    bool *ok) {
+                                    bool *ok,
+                                    QList<int> *inserted_ids,
+                                    QList<int> *updated_ids) {
   if (messages.isEmpty()) {
     *any_message_changed = false;
     *ok = true;
     return 0;
   }
 
+  if (qApp->database()->activeDatabaseDriver() == DatabaseFactory::MYSQL) {
+    return updateMessagesMySQL(db, messages, feed_custom_id, feed_id, account_id, url, any_message_changed, ok,
+                               inserted_ids, updated_ids);
+  }
+
   bool use_transactions = qApp->settings()->value(GROUP(Database), SETTING(Database::UseTransactions)).toBool();
+  bool compress_contents = qApp->settings()->value(GROUP(Database), SETTING(Database::CompressMessageContents)).toBool();
+  QList<int> new_ids;
+  QList<int> changed_ids;
 
   // Does not make any difference, since each feed now has
   // its own "custom ID" (standard feeds have their custom ID equal to primary key ID).
   int updated_messages = 0;
 
-  // Prepare queries.
-  QSqlQuery query_select_with_url(db);
-  QSqlQuery query_select_with_id(db);
-  QSqlQuery query_update(db);
-  QSqlQuery query_insert(db);
-  QSqlQuery query_begin_transaction(db);
-
+  // Prepare queries, they are prepared only once per connection and then reused.
+  //
   // Here we have query which will check for existence of the "same" message in given feed.
   // The two message are the "same" if:
   //   1) they belong to the same feed AND,
-  //   2) they have same URL AND,
-  //   3) they have same AUTHOR.
-  query_select_with_url.setForwardOnly(true);
-  query_select_with_url.prepare("SELECT id, date_created, is_read, is_important, contents FROM Messages "
-                                "WHERE feed = :feed AND title = :title AND url = :url AND author = :author AND account_id = :account_id;");
+  //   2) they have same TITLE, URL AND AUTHOR, which is checked via their identity hash.
+  //
+  // NOTE: Messages stored before hashes were introduced do not have them, those
+  // are still matched via their texts and their contents are loaded for comparison.
+  QSqlQuery query_select_with_url = DatabaseQueryCache::preparedQuery(db,
+                                                                      QSL("SELECT id, date_created, is_read, is_important, contents_hash, "
+                                                                          "CASE WHEN contents_hash IS NULL THEN "
+                                                                          "(SELECT contents FROM MessageBodies WHERE message_id = Messages.id) END "
+                                                                          "FROM Messages "
+                                                                          "WHERE account_id = :account_id AND feed = :feed AND "
+                                                                          "(identity_hash = :identity_hash OR "
+                                                                          "(identity_hash IS NULL AND title = :title AND url = :url AND author = :author));"));
 
   // When we have custom ID of the message, we can check directly for existence
   // of that particular message.
-  query_select_with_id.setForwardOnly(true);
-  query_select_with_id.prepare("SELECT id, date_created, is_read, is_important, contents FROM Messages "
-                               "WHERE custom_id = :custom_id AND account_id = :account_id;");
+  QSqlQuery query_select_with_id = DatabaseQueryCache::preparedQuery(db,
+                                                                     QSL("SELECT id, date_created, is_read, is_important, contents_hash, "
+                                                                         "CASE WHEN contents_hash IS NULL THEN "
+                                                                         "(SELECT contents FROM MessageBodies WHERE message_id = Messages.id) END "
+                                                                         "FROM Messages "
+                                                                         "WHERE custom_id = :custom_id AND account_id = :account_id;"));
+
+  // Used to store hashes of older messages which do not have them yet.
+  QSqlQuery query_hashes = DatabaseQueryCache::preparedQuery(db,
+                                                             QSL("UPDATE Messages SET identity_hash = :identity_hash, contents_hash = :contents_hash "
+                                                                 "WHERE id = :id;"));
 
   // Used to insert new messages.
-  query_insert.setForwardOnly(true);
-  query_insert.prepare("INSERT INTO Messages "
-                       "(feed, title, is_read, is_important, url, author, date_created, contents, enclosures, custom_id, custom_hash, account_id) "
-                       "VALUES (:feed, :title, :is_read, :is_important, :url, :author, :date_created, :contents, :enclosures, :custom_id, :custom_hash, :account_id);");
+  QSqlQuery query_insert = DatabaseQueryCache::preparedQuery(db,
+                                                             QSL("INSERT INTO Messages "
+                                                                 "(feed, feed_id, title, is_read, is_important, url, author, date_created, custom_id, custom_hash, "
+                                                                 "identity_hash, contents_hash, account_id) "
+                                                                 "VALUES (:feed, :feed_id, :title, :is_read, :is_important, :url, :author, :date_created, :custom_id, :custom_hash, "
+                                                                 ":identity_hash, :contents_hash, :account_id);"));
+
+  // Used to store bodies of both new and updated messages.
+  QSqlQuery query_body = DatabaseQueryCache::preparedQuery(db,
+                                                           QSL("REPLACE INTO MessageBodies (message_id, contents, enclosures) "
+                                                               "VALUES (:message_id, :contents, :enclosures);"));
+
+  // Used to keep full-text search index in sync with stored messages.
+  QSqlQuery query_search_delete = DatabaseQueryCache::preparedQuery(db, QSL("DELETE FROM MessagesFts WHERE docid = :docid;"));
+  QSqlQuery query_search_insert = DatabaseQueryCache::preparedQuery(db,
+                                                                    QSL("INSERT INTO MessagesFts (docid, title, author, contents) "
+                                                                        "VALUES (:docid, :title, :author, :contents);"));
 
   // Used to update existing messages.
-  query_update.setForwardOnly(true);
-  query_update.prepare("UPDATE Messages "
-                       "SET title = :title, is_read = :is_read, is_important = :is_important, url = :url, author = :author, date_created = :date_created, contents = :contents, enclosures = :enclosures "
-                       "WHERE id = :id;");
+  QSqlQuery query_update = DatabaseQueryCache::preparedQuery(db,
+                                                             QSL("UPDATE Messages "
+                                                                 "SET title = :title, is_read = :is_read, is_important = :is_important, url = :url, "
+                                                                 "author = :author, date_created = :date_created, identity_hash = :identity_hash, "
+                                                                 "contents_hash = :contents_hash "
+                                                                 "WHERE id = :id;"));
+  QSqlQuery query_begin_transaction(db);
 
-  if (use_transactions && !query_begin_transaction.exec(qApp->database()->obtainBeginTransactionSql())) {
+  if (use_transactions && !DB_EXEC_SQL(query_begin_transaction, qApp->database()->obtainBeginTransactionSql())) {
     qCritical("Transaction start for message downloader failed: '%s'.", qPrintable(query_begin_transaction.lastError().text()));
     return updated_messages;
   }
 
   foreach (Message message, messages) {
-    // Check if messages contain relative URLs and if they do, then replace them.
-    if (message.m_url.startsWith(QL1S("//"))) {
-      message.m_url = QString(URI_SCHEME_HTTP) + message.m_url.mid(2);
-    }
-    else if (message.m_url.startsWith(QL1S("/"))) {
-      QString new_message_url = QUrl(url).toString(QUrl::RemoveUserInfo |
-                                                   QUrl::RemovePath |
-                                                   QUrl::RemoveQuery |
-                                                   QUrl::RemoveFilename |
-                                                   QUrl::StripTrailingSlash);
-
-      new_message_url += message.m_url;
-      message.m_url = new_message_url;
-    }
+    fixMessageUrl(message, url);
 
+    const qint64 identity_hash = message.identityHash();
+    const qint64 contents_hash = message.contentsHash();
     int id_existing_message = -1;
     qint64 date_existing_message;
     bool is_read_existing_message;
     bool is_important_existing_message;
+    QVariant contents_hash_existing_message;
     QString contents_existing_message;
 
     if (message.m_customId.isEmpty()) {
       // We need to recognize existing messages according URL & AUTHOR.
       // NOTE: This particularly concerns messages from standard account.
       query_select_with_url.bindValue(QSL(":feed"), feed_custom_id);
+      query_select_with_url.bindValue(QSL(":identity_hash"), identity_hash);
       query_select_with_url.bindValue(QSL(":title"), message.m_title);
       query_select_with_url.bindValue(QSL(":url"), message.m_url);
       query_select_with_url.bindValue(QSL(":author"), message.m_author);
       query_select_with_url.bindValue(QSL(":account_id"), account_id);
 
-      if (query_select_with_url.exec() && query_select_with_url.next()) {
+      if (DB_EXEC(query_select_with_url) && query_select_with_url.next()) {
         id_existing_message = query_select_with_url.value(0).toInt();
         date_existing_message = query_select_with_url.value(1).value<qint64>();
         is_read_existing_message = query_select_with_url.value(2).toBool();
         is_important_existing_message = query_select_with_url.value(3).toBool();
-        contents_existing_message = query_select_with_url.value(4).toString();
+        contents_hash_existing_message = query_select_with_url.value(4);
+        contents_existing_message = TextFactory::decompressText(query_select_with_url.value(5).toString());
       }
       else if (query_select_with_url.lastError().isValid()) {
         qWarning("Failed to check for existing message in DB via URL: '%s'.", qPrintable(query_select_with_url.lastError().text()));
@@ -546,12 +1083,13 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
       query_select_with_id.bindValue(QSL(":account_id"), account_id);
       query_select_with_id.bindValue(QSL(":custom_id"), message.m_customId);
 
-      if (query_select_with_id.exec() && query_select_with_id.next()) {
+      if (DB_EXEC(query_select_with_id) && query_select_with_id.next()) {
         id_existing_message = query_select_with_id.value(0).toInt();
         date_existing_message = query_select_with_id.value(1).value<qint64>();
         is_read_existing_message = query_select_with_id.value(2).toBool();
         is_important_existing_message = query_select_with_id.value(3).toBool();
-        contents_existing_message = query_select_with_id.value(4).toString();
+        contents_hash_existing_message = query_select_with_id.value(4);
+        contents_existing_message = TextFactory::decompressText(query_select_with_id.value(5).toString());
       }
       else if (query_select_with_id.lastError().isValid()) {
         qDebug("Failed to check for existing message in DB via ID: '%s'.", qPrintable(query_select_with_id.lastError().text()));
@@ -564,11 +1102,17 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
     if (id_existing_message >= 0) {
       // Message is already in the DB.
       //
+      // Messages without stored hashes are compared with their loaded contents.
+      const bool has_hashes_existing_message = !contents_hash_existing_message.isNull();
+      const bool contents_changed = has_hashes_existing_message ?
+                                    contents_hash != contents_hash_existing_message.value<qint64>() :
+                                    message.m_contents != contents_existing_message;
+
       // Now, we update it if at least one of next conditions is true:
       //   1) Message has custom ID AND (its date OR read status OR starred status are changed).
       //   2) Message has its date fetched from feed AND its date is different from date in DB and contents is changed.
       if (/* 1 */ (!message.m_customId.isEmpty() && (message.m_created.toMSecsSinceEpoch() != date_existing_message || message.m_isRead != is_read_existing_message || message.m_isImportant != is_important_existing_message)) ||
-          /* 2 */ (message.m_createdFromFeed && message.m_created.toMSecsSinceEpoch() != date_existing_message && message.m_contents != contents_existing_message)) {
+          /* 2 */ (message.m_createdFromFeed && message.m_created.toMSecsSinceEpoch() != date_existing_message && contents_changed)) {
         // Message exists, it is changed, update it.
         query_update.bindValue(QSL(":title"), message.m_title);
         query_update.bindValue(QSL(":is_read"), (int) message.m_isRead);
@@ -576,60 +1120,548 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
         query_update.bindValue(QSL(":url"), message.m_url);
         query_update.bindValue(QSL(":author"), message.m_author);
         query_update.bindValue(QSL(":date_created"), message.m_created.toMSecsSinceEpoch());
-        query_update.bindValue(QSL(":contents"), message.m_contents);
-        query_update.bindValue(QSL(":enclosures"), Enclosures::encodeEnclosuresToString(message.m_enclosures));
+        query_update.bindValue(QSL(":identity_hash"), identity_hash);
+        query_update.bindValue(QSL(":contents_hash"), contents_hash);
         query_update.bindValue(QSL(":id"), id_existing_message);
 
         *any_message_changed = true;
 
-        if (query_update.exec() && !message.m_isRead) {
-          updated_messages++;
+        if (DB_EXEC(query_update)) {
+          query_body.bindValue(QSL(":message_id"), id_existing_message);
+          query_body.bindValue(QSL(":contents"), compress_contents ? TextFactory::compressText(message.m_contents) : message.m_contents);
+          query_body.bindValue(QSL(":enclosures"), Enclosures::encodeEnclosuresToString(message.m_enclosures));
+
+          if (!DB_EXEC(query_body)) {
+            qWarning("Failed to update message body in DB: '%s'.", qPrintable(query_body.lastError().text()));
+          }
+
+          query_body.finish();
+
+          query_search_delete.bindValue(QSL(":docid"), id_existing_message);
+          DB_EXEC(query_search_delete);
+          query_search_delete.finish();
+
+          query_search_insert.bindValue(QSL(":docid"), id_existing_message);
+          query_search_insert.bindValue(QSL(":title"), message.m_title);
+          query_search_insert.bindValue(QSL(":author"), message.m_author);
+          query_search_insert.bindValue(QSL(":contents"), WebFactory::instance()->stripTags(message.m_contents));
+
+          if (!DB_EXEC(query_search_insert)) {
+            qWarning("Failed to update message in search index: '%s'.", qPrintable(query_search_insert.lastError().text()));
+          }
+
+          query_search_insert.finish();
+          changed_ids.append(id_existing_message);
+
+          if (!message.m_isRead) {
+            updated_messages++;
+          }
         }
         else if (query_update.lastError().isValid()) {
           qWarning("Failed to update message in DB: '%s'.", qPrintable(query_update.lastError().text()));
         }
 
-        query_update.finish();
-        qDebug("Updating message '%s' in DB.", qPrintable(message.m_title));
-      }
+        query_update.finish();
+        qDebug("Updating message '%s' in DB.", qPrintable(message.m_title));
+      }
+      else if (!has_hashes_existing_message) {
+        // Message is not changed, just remember its hashes so that
+        // its contents do not have to be loaded next time.
+        query_hashes.bindValue(QSL(":identity_hash"), identity_hash);
+        query_hashes.bindValue(QSL(":contents_hash"), TextFactory::hashText(contents_existing_message));
+        query_hashes.bindValue(QSL(":id"), id_existing_message);
+
+        if (!DB_EXEC(query_hashes)) {
+          qWarning("Failed to store hashes of message: '%s'.", qPrintable(query_hashes.lastError().text()));
+        }
+
+        query_hashes.finish();
+      }
+    }
+    else {
+      // Message with this URL is not fetched in this feed yet.
+      query_insert.bindValue(QSL(":feed"), feed_custom_id);
+      query_insert.bindValue(QSL(":feed_id"), feed_id);
+      query_insert.bindValue(QSL(":title"), message.m_title);
+      query_insert.bindValue(QSL(":is_read"), (int) message.m_isRead);
+      query_insert.bindValue(QSL(":is_important"), (int) message.m_isImportant);
+      query_insert.bindValue(QSL(":url"), message.m_url);
+      query_insert.bindValue(QSL(":author"), message.m_author);
+      query_insert.bindValue(QSL(":date_created"), message.m_created.toMSecsSinceEpoch());
+      query_insert.bindValue(QSL(":custom_id"), message.m_customId);
+      query_insert.bindValue(QSL(":custom_hash"), message.m_customHash);
+      query_insert.bindValue(QSL(":identity_hash"), identity_hash);
+      query_insert.bindValue(QSL(":contents_hash"), contents_hash);
+      query_insert.bindValue(QSL(":account_id"), account_id);
+
+      if (DB_EXEC(query_insert) && query_insert.numRowsAffected() == 1) {
+        const QVariant id_new_message = query_insert.lastInsertId();
+
+        query_body.bindValue(QSL(":message_id"), id_new_message);
+        query_body.bindValue(QSL(":contents"), compress_contents ? TextFactory::compressText(message.m_contents) : message.m_contents);
+        query_body.bindValue(QSL(":enclosures"), Enclosures::encodeEnclosuresToString(message.m_enclosures));
+
+        if (!DB_EXEC(query_body)) {
+          qWarning("Failed to insert message body to DB: '%s' - message title is '%s'.",
+                   qPrintable(query_body.lastError().text()),
+                   qPrintable(message.m_title));
+        }
+
+        query_body.finish();
+
+        query_search_insert.bindValue(QSL(":docid"), id_new_message);
+        query_search_insert.bindValue(QSL(":title"), message.m_title);
+        query_search_insert.bindValue(QSL(":author"), message.m_author);
+        query_search_insert.bindValue(QSL(":contents"), WebFactory::instance()->stripTags(message.m_contents));
+
+        if (!DB_EXEC(query_search_insert)) {
+          qWarning("Failed to insert message to search index: '%s'.", qPrintable(query_search_insert.lastError().text()));
+        }
+
+        query_search_insert.finish();
+        new_ids.append(id_new_message.toInt());
+        updated_messages++;
+        qDebug("Added new message '%s' to DB.", qPrintable(message.m_title));
+      }
+      else if (query_insert.lastError().isValid()) {
+        qWarning("Failed to insert message to DB: '%s' - message title is '%s'.",
+                 qPrintable(query_insert.lastError().text()),
+                 qPrintable(message.m_title));
+      }
+
+      query_insert.finish();
+    }
+  }
+
+  // Now, fixup custom IDS for messages which initially did not have them,
+  // just to keep the data consistent.
+  QSqlQuery query_fix_custom_ids = DatabaseQueryCache::preparedQuery(db,
+                                                                     QSL("UPDATE Messages "
+                                                                         "SET custom_id = id "
+                                                                         "WHERE custom_id IS NULL OR custom_id = '';"));
+
+  if (!DB_EXEC(query_fix_custom_ids)) {
+    qWarning("Failed to set custom ID for all messages: '%s'.", qPrintable(query_fix_custom_ids.lastError().text()));
+  }
+
+  query_fix_custom_ids.finish();
+
+  if (use_transactions && !db.commit()) {
+    qCritical("Transaction commit for message downloader failed: '%s'.", qPrintable(db.lastError().text()));
+    db.rollback();
+
+    if (ok != nullptr) {
+      *ok = false;
+      updated_messages = 0;
+    }
+  }
+  else {
+    if (ok != nullptr) {
+      *ok = true;
+    }
+
+    if (inserted_ids != nullptr) {
+      inserted_ids->append(new_ids);
+    }
+
+    if (updated_ids != nullptr) {
+      updated_ids->append(changed_ids);
+    }
+  }
+
+  return updated_messages;
+}
+
+void DatabaseQueries::fixMessageUrl(Message &message, const QString &feed_url) {
+  // Check if messages contain relative URLs and if they do, then replace them.
+  if (message.m_url.startsWith(QL1S("//"))) {
+    message.m_url = QString(URI_SCHEME_HTTP) + message.m_url.mid(2);
+  }
+  else if (message.m_url.startsWith(QL1S("/"))) {
+    QString new_message_url = QUrl(feed_url).toString(QUrl::RemoveUserInfo |
+                                                      QUrl::RemovePath |
+                                                      QUrl::RemoveQuery |
+                                                      QUrl::RemoveFilename |
+                                                      QUrl::StripTrailingSlash);
+
+    new_message_url += message.m_url;
+    message.m_url = new_message_url;
+  }
+}
+
+int DatabaseQueries::updateMessagesMySQL(QSqlDatabase db, const QList<Message> &messages, int feed_custom_id,
+                                         int feed_id, int account_id, const QString &url, bool *any_message_changed, bool *ok,
+                                         QList<int> *inserted_ids, QList<int> *updated_ids) {
+  // Message as it is already stored in DB.
+  struct StoredMessage {
+    int m_id;
+    QString m_customId;
+    qint64 m_created;
+    bool m_isRead;
+    bool m_isImportant;
+    QVariant m_contentsHash;
+    QString m_contents;
+    QString m_title;
+    QString m_url;
+    QString m_author;
+  };
+
+  const bool use_transactions = qApp->settings()->value(GROUP(Database), SETTING(Database::UseTransactions)).toBool();
+  const bool compress_contents = qApp->settings()->value(GROUP(Database), SETTING(Database::CompressMessageContents)).toBool();
+  const QString stored_select = QSL("SELECT id, custom_id, date_created, is_read, is_important, identity_hash, contents_hash, "
+                                    "CASE WHEN contents_hash IS NULL THEN "
+                                    "(SELECT contents FROM MessageBodies WHERE message_id = Messages.id) END, "
+                                    "title, url, author FROM Messages ");
+  QList<Message> fixed_messages;
+  QStringList custom_ids;
+  QList<qint64> identity_hashes;
+  QHash<QString,StoredMessage> stored_by_custom_id;
+  QHash<qint64,StoredMessage> stored_by_identity;
+  QList<StoredMessage> stored_without_hashes;
+  QSet<int> stored_without_hashes_ids;
+  QSqlQuery q(db);
+  int updated_messages = 0;
+
+  q.setForwardOnly(true);
+
+  foreach (Message message, messages) {
+    fixMessageUrl(message, url);
+
+    if (message.m_customId.isEmpty()) {
+      identity_hashes.append(message.identityHash());
+    }
+    else {
+      custom_ids.append(message.m_customId);
+    }
+
+    fixed_messages.append(message);
+  }
+
+  if (use_transactions && !DB_EXEC_SQL(q, qApp->database()->obtainBeginTransactionSql())) {
+    qCritical("Transaction start for message downloader failed: '%s'.", qPrintable(q.lastError().text()));
+    return updated_messages;
+  }
+
+  // Load already stored messages. Messages with custom ID are matched via
+  // that ID, other messages via their identity hash and legacy messages
+  // without hashes via their texts.
+  const auto read_stored = [&q]() -> StoredMessage {
+    StoredMessage stored;
+
+    stored.m_id = q.value(0).toInt();
+    stored.m_customId = q.value(1).toString();
+    stored.m_created = q.value(2).value<qint64>();
+    stored.m_isRead = q.value(3).toBool();
+    stored.m_isImportant = q.value(4).toBool();
+    stored.m_contentsHash = q.value(6);
+    stored.m_contents = TextFactory::decompressText(q.value(7).toString());
+    stored.m_title = q.value(8).toString();
+    stored.m_url = q.value(9).toString();
+    stored.m_author = q.value(10).toString();
+
+    return stored;
+  };
+
+  for (int i = 0; i < custom_ids.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    const QStringList chunk = custom_ids.mid(i, MESSAGES_BULK_CHUNK_SIZE);
+
+    q.prepare(stored_select + QString(QSL("WHERE account_id = ? AND custom_id IN (%1);")).arg(placeholders(chunk.size())));
+    q.addBindValue(account_id);
+
+    foreach (const QString &custom_id, chunk) {
+      q.addBindValue(custom_id);
+    }
+
+    if (!DB_EXEC(q)) {
+      qWarning("Failed to load stored messages from DB: '%s'.", qPrintable(q.lastError().text()));
+    }
+
+    while (q.next()) {
+      const StoredMessage stored = read_stored();
+
+      stored_by_custom_id.insert(stored.m_customId, stored);
+    }
+
+    q.finish();
+  }
+
+  for (int i = 0; i < identity_hashes.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    const QList<qint64> chunk = identity_hashes.mid(i, MESSAGES_BULK_CHUNK_SIZE);
+
+    q.prepare(stored_select + QString(QSL("WHERE account_id = ? AND feed = ? AND "
+                                          "(identity_hash IS NULL OR identity_hash IN (%1));")).arg(placeholders(chunk.size())));
+    q.addBindValue(account_id);
+    q.addBindValue(feed_custom_id);
+
+    foreach (qint64 identity_hash, chunk) {
+      q.addBindValue(identity_hash);
+    }
+
+    if (!DB_EXEC(q)) {
+      qWarning("Failed to load stored messages from DB: '%s'.", qPrintable(q.lastError().text()));
+    }
+
+    while (q.next()) {
+      const StoredMessage stored = read_stored();
+
+      if (!q.value(5).isNull()) {
+        stored_by_identity.insert(q.value(5).value<qint64>(), stored);
+      }
+      else if (!stored_without_hashes_ids.contains(stored.m_id)) {
+        // Legacy messages are returned for each chunk.
+        stored_without_hashes_ids.insert(stored.m_id);
+        stored_without_hashes.append(stored);
+      }
+    }
+
+    q.finish();
+  }
+
+  // Decide what to do with each message.
+  QList<QVariantList> message_rows;
+  QList<QVariantList> hash_rows;
+  QList<Message> written_messages;
+  QList<int> written_ids;
+  QSet<qint64> new_identity_hashes;
+
+  foreach (const Message &message, fixed_messages) {
+    const qint64 identity_hash = message.identityHash();
+    const qint64 contents_hash = message.contentsHash();
+    StoredMessage stored;
+    bool is_stored = false;
+
+    if (!message.m_customId.isEmpty()) {
+      is_stored = stored_by_custom_id.contains(message.m_customId);
+
+      if (is_stored) {
+        stored = stored_by_custom_id.value(message.m_customId);
+      }
+    }
+    else if (stored_by_identity.contains(identity_hash)) {
+      stored = stored_by_identity.value(identity_hash);
+      is_stored = true;
+    }
+    else {
+      foreach (const StoredMessage &candidate, stored_without_hashes) {
+        if (candidate.m_title == message.m_title && candidate.m_url == message.m_url && candidate.m_author == message.m_author) {
+          stored = candidate;
+          is_stored = true;
+          break;
+        }
+      }
+    }
+
+    if (is_stored) {
+      // Same rules as for SQLite apply here, see updateMessages().
+      const bool has_hashes_stored = !stored.m_contentsHash.isNull();
+      const bool contents_changed = has_hashes_stored ?
+                                    contents_hash != stored.m_contentsHash.value<qint64>() :
+                                    message.m_contents != stored.m_contents;
+
+      if ((!message.m_customId.isEmpty() && (message.m_created.toMSecsSinceEpoch() != stored.m_created ||
+                                             message.m_isRead != stored.m_isRead ||
+                                             message.m_isImportant != stored.m_isImportant)) ||
+          (message.m_createdFromFeed && message.m_created.toMSecsSinceEpoch() != stored.m_created && contents_changed)) {
+        message_rows.append(QVariantList() << stored.m_id << feed_custom_id << feed_id << message.m_title << (int) message.m_isRead <<
+                            (int) message.m_isImportant << message.m_url << message.m_author <<
+                            message.m_created.toMSecsSinceEpoch() << stored.m_customId << message.m_customHash <<
+                            identity_hash << contents_hash << account_id);
+        written_messages.append(message);
+        written_ids.append(stored.m_id);
+        *any_message_changed = true;
+
+        if (!message.m_isRead) {
+          updated_messages++;
+        }
+      }
+      else if (!has_hashes_stored) {
+        hash_rows.append(QVariantList() << stored.m_id << identity_hash << TextFactory::hashText(stored.m_contents));
+      }
+    }
+    else {
+      if (message.m_customId.isEmpty()) {
+        if (new_identity_hashes.contains(identity_hash)) {
+          // Same message is contained in the feed more than once.
+          continue;
+        }
+
+        new_identity_hashes.insert(identity_hash);
+      }
+
+      // NULL custom ID of new messages is replaced with their ID later.
+      message_rows.append(QVariantList() << QVariant(QVariant::Int) << feed_custom_id << feed_id << message.m_title << (int) message.m_isRead <<
+                          (int) message.m_isImportant << message.m_url << message.m_author <<
+                          message.m_created.toMSecsSinceEpoch() <<
+                          (message.m_customId.isEmpty() ? QVariant(QVariant::String) : QVariant(message.m_customId)) <<
+                          message.m_customHash << identity_hash << contents_hash << account_id);
+      written_messages.append(message);
+      written_ids.append(-1);
+      updated_messages++;
+    }
+  }
+
+  // New messages are inserted and changed messages are updated at once.
+  if (!execMultiRowStatement(db,
+                             QSL("INSERT INTO Messages (id, feed, feed_id, title, is_read, is_important, url, author, date_created, custom_id, "
+                                 "custom_hash, identity_hash, contents_hash, account_id) VALUES "),
+                             QSL(" ON DUPLICATE KEY UPDATE title = VALUES(title), is_read = VALUES(is_read), is_important = VALUES(is_important), "
+                                 "url = VALUES(url), author = VALUES(author), date_created = VALUES(date_created), "
+                                 "identity_hash = VALUES(identity_hash), contents_hash = VALUES(contents_hash);"),
+                             message_rows)) {
+    qCritical("Storing of messages of feed %d failed, changes are rolled back.", feed_custom_id);
+
+    if (use_transactions) {
+      db.rollback();
+    }
+
+    if (ok != nullptr) {
+      *ok = false;
+    }
+
+    return 0;
+  }
+
+  // Obtain IDs of new messages, so that their bodies can be stored.
+  QStringList new_custom_ids;
+  QHash<QString,int> new_ids_by_custom_id;
+  QHash<qint64,int> new_ids_by_identity;
+
+  for (int i = 0; i < written_messages.size(); i++) {
+    if (written_ids.at(i) < 0 && !written_messages.at(i).m_customId.isEmpty()) {
+      new_custom_ids.append(written_messages.at(i).m_customId);
+    }
+  }
+
+  for (int i = 0; i < new_custom_ids.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    const QStringList chunk = new_custom_ids.mid(i, MESSAGES_BULK_CHUNK_SIZE);
+
+    q.prepare(QString(QSL("SELECT id, custom_id FROM Messages WHERE account_id = ? AND custom_id IN (%1);")).arg(placeholders(chunk.size())));
+    q.addBindValue(account_id);
+
+    foreach (const QString &custom_id, chunk) {
+      q.addBindValue(custom_id);
+    }
+
+    if (DB_EXEC(q)) {
+      while (q.next()) {
+        new_ids_by_custom_id.insert(q.value(1).toString(), q.value(0).toInt());
+      }
+    }
+    else {
+      qWarning("Failed to obtain IDs of new messages: '%s'.", qPrintable(q.lastError().text()));
+    }
+
+    q.finish();
+  }
+
+  if (!new_identity_hashes.isEmpty()) {
+    q.prepare(QSL("SELECT id, identity_hash FROM Messages WHERE account_id = ? AND feed = ? AND custom_id IS NULL;"));
+    q.addBindValue(account_id);
+    q.addBindValue(feed_custom_id);
+
+    if (DB_EXEC(q)) {
+      while (q.next()) {
+        new_ids_by_identity.insert(q.value(1).value<qint64>(), q.value(0).toInt());
+      }
+    }
+    else {
+      qWarning("Failed to obtain IDs of new messages: '%s'.", qPrintable(q.lastError().text()));
+    }
+
+    q.finish();
+  }
+
+  // Store bodies and search index entries of all written messages.
+  QList<QVariantList> body_rows;
+  QList<QVariantList> search_rows;
+  QList<int> new_ids;
+  QList<int> changed_ids;
+
+  for (int i = 0; i < written_messages.size(); i++) {
+    const Message &message = written_messages.at(i);
+    int id = written_ids.at(i);
+
+    if (id < 0) {
+      id = message.m_customId.isEmpty() ?
+           new_ids_by_identity.value(message.identityHash(), -1) :
+           new_ids_by_custom_id.value(message.m_customId, -1);
+
+      if (id >= 0) {
+        new_ids.append(id);
+      }
+    }
+    else {
+      changed_ids.append(id);
+    }
+
+    if (id < 0) {
+      qWarning("Message '%s' was not stored in DB.", qPrintable(message.m_title));
+      continue;
+    }
+
+    body_rows.append(QVariantList() << id <<
+                     (compress_contents ? TextFactory::compressText(message.m_contents) : message.m_contents) <<
+                     Enclosures::encodeEnclosuresToString(message.m_enclosures));
+    search_rows.append(QVariantList() << id << message.m_title << message.m_author <<
+                       WebFactory::instance()->stripTags(message.m_contents));
+  }
+
+  if (!execMultiRowStatement(db, QSL("REPLACE INTO MessageBodies (message_id, contents, enclosures) VALUES "), QSL(";"), body_rows) ||
+      !execMultiRowStatement(db, QSL("REPLACE INTO MessagesFts (docid, title, author, contents) VALUES "), QSL(";"), search_rows)) {
+    qCritical("Storing of bodies of messages of feed %d failed, changes are rolled back.", feed_custom_id);
+
+    if (use_transactions) {
+      db.rollback();
+    }
+
+    if (ok != nullptr) {
+      *ok = false;
+    }
+
+    return 0;
+  }
+
+  // Remember hashes of older unchanged messages.
+  for (int i = 0; i < hash_rows.size(); i += MESSAGES_BULK_CHUNK_SIZE) {
+    const QList<QVariantList> chunk = hash_rows.mid(i, MESSAGES_BULK_CHUNK_SIZE);
+    QStringList cases;
+
+    for (int j = 0; j < chunk.size(); j++) {
+      cases.append(QSL("WHEN ? THEN ?"));
+    }
+
+    q.prepare(QString(QSL("UPDATE Messages SET identity_hash = CASE id %1 END, contents_hash = CASE id %1 END "
+                          "WHERE id IN (%2);")).arg(cases.join(QL1C(' ')), placeholders(chunk.size())));
+
+    foreach (const QVariantList &row, chunk) {
+      q.addBindValue(row.at(0));
+      q.addBindValue(row.at(1));
     }
-    else {
-      // Message with this URL is not fetched in this feed yet.
-      query_insert.bindValue(QSL(":feed"), feed_custom_id);
-      query_insert.bindValue(QSL(":title"), message.m_title);
-      query_insert.bindValue(QSL(":is_read"), (int) message.m_isRead);
-      query_insert.bindValue(QSL(":is_important"), (int) message.m_isImportant);
-      query_insert.bindValue(QSL(":url"), message.m_url);
-      query_insert.bindValue(QSL(":author"), message.m_author);
-      query_insert.bindValue(QSL(":date_created"), message.m_created.toMSecsSinceEpoch());
-      query_insert.bindValue(QSL(":contents"), message.m_contents);
-      query_insert.bindValue(QSL(":enclosures"), Enclosures::encodeEnclosuresToString(message.m_enclosures));
-      query_insert.bindValue(QSL(":custom_id"), message.m_customId);
-      query_insert.bindValue(QSL(":custom_hash"), message.m_customHash);
-      query_insert.bindValue(QSL(":account_id"), account_id);
 
-      if (query_insert.exec() && query_insert.numRowsAffected() == 1) {
-        updated_messages++;
-        qDebug("Added new message '%s' to DB.", qPrintable(message.m_title));
-      }
-      else if (query_insert.lastError().isValid()) {
-        qWarning("Failed to insert message to DB: '%s' - message title is '%s'.",
-                 qPrintable(query_insert.lastError().text()),
-                 qPrintable(message.m_title));
-      }
+    foreach (const QVariantList &row, chunk) {
+      q.addBindValue(row.at(0));
+      q.addBindValue(row.at(2));
+    }
 
-      query_insert.finish();
+    foreach (const QVariantList &row, chunk) {
+      q.addBindValue(row.at(0));
+    }
+
+    if (!DB_EXEC(q)) {
+      qWarning("Failed to store hashes of messages: '%s'.", qPrintable(q.lastError().text()));
     }
+
+    q.finish();
   }
 
   // Now, fixup custom IDS for messages which initially did not have them,
   // just to keep the data consistent.
-  if (db.exec("UPDATE Messages "
-              "SET custom_id = id "
-              "WHERE custom_id IS NULL OR custom_id = '';").lastError().isValid()) {
-    qWarning("Failed to set custom ID for all messages: '%s'.", qPrintable(db.lastError().text()));
+  if (!DB_EXEC_SQL(q, QSL("UPDATE Messages SET custom_id = id WHERE custom_id IS NULL OR custom_id = '';"))) {
+    qWarning("Failed to set custom ID for all messages: '%s'.", qPrintable(q.lastError().text()));
   }
 
+  q.finish();
+
   if (use_transactions && !db.commit()) {
     qCritical("Transaction commit for message downloader failed: '%s'.", qPrintable(db.lastError().text()));
     db.rollback();
@@ -643,11 +1675,84 @@ int DatabaseQueries::updateMessages(QSqlDatabase db,
     if (ok != nullptr) {
       *ok = true;
     }
+
+    if (inserted_ids != nullptr) {
+      inserted_ids->append(new_ids);
+    }
+
+    if (updated_ids != nullptr) {
+      updated_ids->append(changed_ids);
+    }
   }
 
   return updated_messages;
 }
 
+bool DatabaseQueries::execMultiRowStatement(QSqlDatabase db, const QString &head, const QString &tail,
+                                            const QList<QVariantList> &rows) {
+  QSqlQuery q(db);
+  bool result = true;
+  int first_row = 0;
+  int max_rows = MESSAGES_BULK_CHUNK_SIZE;
+
+  // SQLite limits number of values bound to single statement.
+  if (qApp->database()->activeDatabaseDriver() != DatabaseFactory::MYSQL && !rows.isEmpty()) {
+    max_rows = qMax(1, qMin(max_rows, SQLITE_MAX_BOUND_VALUES / rows.first().size()));
+  }
+
+  q.setForwardOnly(true);
+
+  while (first_row < rows.size()) {
+    int last_row = first_row;
+    int chunk_bytes = 0;
+
+    // Each chunk must fit into single packet, so its size is limited too.
+    while (last_row < rows.size() && last_row - first_row < max_rows &&
+           (last_row == first_row || chunk_bytes < MESSAGES_BULK_CHUNK_MAX_BYTES)) {
+      foreach (const QVariant &value, rows.at(last_row)) {
+        chunk_bytes += value.type() == QVariant::String ? value.toString().size() * 3 : 8;
+      }
+
+      last_row++;
+    }
+
+    const QString row_placeholders = QL1C('(') + placeholders(rows.at(first_row).size()) + QL1C(')');
+    QStringList chunk_placeholders;
+
+    for (int i = first_row; i < last_row; i++) {
+      chunk_placeholders.append(row_placeholders);
+    }
+
+    q.prepare(head + chunk_placeholders.join(QSL(", ")) + tail);
+
+    for (int i = first_row; i < last_row; i++) {
+      foreach (const QVariant &value, rows.at(i)) {
+        q.addBindValue(value);
+      }
+    }
+
+    if (!DB_EXEC(q)) {
+      qWarning("Multi-row statement failed: '%s'.", qPrintable(q.lastError().text()));
+      result = false;
+    }
+
+    q.finish();
+    first_row = last_row;
+  }
+
+  return result;
+}
+
+QString DatabaseQueries::placeholders(int count) {
+  QStringList list;
+
+  for (int i = 0; i < count; i++) {
+    list.append(QSL("?"));
+  }
+
+  return list.join(QSL(", "));
+}
+
 bool DatabaseQueries::purgeMessagesFromBin(QSqlDatabase db, bool clear_only_read, int account_id) {
   QSqlQuery q(db);
   q.setForwardOnly(true);
@@ -661,7 +1766,7 @@ bool DatabaseQueries::purgeMessagesFromBin(QSqlDatabase db, bool clear_only_read
 
   q.bindValue(QSL(":account_id"), account_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::deleteAccount(QSqlDatabase db, int account_id) {
@@ -669,7 +1774,9 @@ bool DatabaseQueries::deleteAccount(QSqlDatabase db, int account_id) {
   query.setForwardOnly(true);
 
   QStringList queries;
-  queries << QSL("DELETE FROM Messages WHERE account_id = :account_id;") <<
+  queries << QSL("DELETE FROM MessageBodies WHERE message_id IN (SELECT id FROM Messages WHERE account_id = :account_id);") <<
+             QSL("DELETE FROM MessagesFts WHERE docid IN (SELECT id FROM Messages WHERE account_id = :account_id);") <<
+             QSL("DELETE FROM Messages WHERE account_id = :account_id;") <<
              QSL("DELETE FROM Feeds WHERE account_id = :account_id;") <<
              QSL("DELETE FROM Categories WHERE account_id = :account_id;") <<
              QSL("DELETE FROM Accounts WHERE id = :account_id;");
@@ -678,7 +1785,7 @@ bool DatabaseQueries::deleteAccount(QSqlDatabase db, int account_id) {
     query.prepare(q);
     query.bindValue(QSL(":account_id"), account_id);
 
-    if (!query.exec()) {
+    if (!DB_EXEC(query)) {
       qCritical("Removing of account from DB failed, this is critical: '%s'.", qPrintable(query.lastError().text()));
       return false;
     }
@@ -696,21 +1803,31 @@ bool DatabaseQueries::deleteAccountData(QSqlDatabase db, int account_id, bool de
   q.setForwardOnly(true);
 
   if (delete_messages_too) {
+    q.prepare(QSL("DELETE FROM MessageBodies WHERE message_id IN (SELECT id FROM Messages WHERE account_id = :account_id);"));
+    q.bindValue(QSL(":account_id"), account_id);
+
+    result &= DB_EXEC(q);
+
+    q.prepare(QSL("DELETE FROM MessagesFts WHERE docid IN (SELECT id FROM Messages WHERE account_id = :account_id);"));
+    q.bindValue(QSL(":account_id"), account_id);
+
+    result &= DB_EXEC(q);
+
     q.prepare(QSL("DELETE FROM Messages WHERE account_id = :account_id;"));
     q.bindValue(QSL(":account_id"), account_id);
 
-    result &= q.exec();
+    result &= DB_EXEC(q);
   }
 
   q.prepare(QSL("DELETE FROM Feeds WHERE account_id = :account_id;"));
   q.bindValue(QSL(":account_id"), account_id);
 
-  result &= q.exec();
+  result &= DB_EXEC(q);
 
   q.prepare(QSL("DELETE FROM Categories WHERE account_id = :account_id;"));
   q.bindValue(QSL(":account_id"), account_id);
 
-  result &= q.exec();
+  result &= DB_EXEC(q);
 
   return result;
 }
@@ -721,19 +1838,19 @@ bool DatabaseQueries::cleanFeeds(QSqlDatabase db, const QStringList &ids, bool c
 
   if (clean_read_only) {
     q.prepare(QString("UPDATE Messages SET is_deleted = :deleted "
-                      "WHERE feed IN (%1) AND is_deleted = 0 AND is_pdeleted = 0 AND is_read = 1 AND account_id = :account_id;")
+                      "WHERE feed_id IN (%1) AND is_deleted = 0 AND is_pdeleted = 0 AND is_read = 1 AND account_id = :account_id;")
               .arg(ids.join(QSL(", "))));
   }
   else {
     q.prepare(QString("UPDATE Messages SET is_deleted = :deleted "
-                      "WHERE feed IN (%1) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;")
+                      "WHERE feed_id IN (%1) AND is_deleted = 0 AND is_pdeleted = 0 AND account_id = :account_id;")
               .arg(ids.join(QSL(", "))));
   }
 
   q.bindValue(QSL(":deleted"), 1);
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qDebug("Cleaning of feeds failed: '%s'.", qPrintable(q.lastError().text()));
     return false;
   }
@@ -749,62 +1866,227 @@ bool DatabaseQueries::purgeLeftoverMessages(QSqlDatabase db, int account_id) {
   q.prepare(QSL("DELETE FROM Messages WHERE account_id = :account_id AND feed NOT IN (SELECT custom_id FROM Feeds WHERE account_id = :account_id);"));
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qWarning("Removing of left over messages failed: '%s'.", qPrintable(q.lastError().text()));
     return false;
   }
   else {
-    return true;
+    return purgeOrphanedMessageData(db);
   }
 }
 
-bool DatabaseQueries::storeAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id) {
-  QSqlQuery query_category(db);
-  QSqlQuery query_feed(db);
-  query_category.setForwardOnly(true);
-  query_feed.setForwardOnly(true);
-  query_category.prepare("INSERT INTO Categories (parent_id, title, account_id, custom_id) "
-                         "VALUES (:parent_id, :title, :account_id, :custom_id);");
-  query_feed.prepare("INSERT INTO Feeds (title, icon, category, protected, update_type, update_interval, account_id, custom_id) "
-                     "VALUES (:title, :icon, :category, :protected, :update_type, :update_interval, :account_id, :custom_id);");
+bool DatabaseQueries::replaceAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id) {
+  // Archive has to be attached before transaction starts, archived
+  // messages are then relinked together with other messages.
+  const QString archive_schema = qApp->database()->sqliteAttachArchive(db, account_id, false);
+  const bool replaced = replaceAccountTree(db, tree_root, account_id, archive_schema);
 
-  // Iterate all children.
-  foreach (RootItem *child, tree_root->getSubTree()) {
-    if (child->kind() == RootItemKind::Category) {
-      query_category.bindValue(QSL(":parent_id"), child->parent()->id());
-      query_category.bindValue(QSL(":title"), child->title());
-      query_category.bindValue(QSL(":account_id"), account_id);
-      query_category.bindValue(QSL(":custom_id"), QString::number(child->toCategory()->customId()));
-
-      if (query_category.exec()) {
-        child->setId(query_category.lastInsertId().toInt());
-      }
-      else {
-        return false;
+  qApp->database()->sqliteDetachArchive(db, archive_schema);
+  return replaced;
+}
+
+bool DatabaseQueries::replaceAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id, const QString &archive_schema) {
+  QElapsedTimer timer;
+
+  timer.start();
+
+  if (!db.transaction()) {
+    qCritical("Transaction for replacing feed tree of account %d was not started: '%s'.",
+              account_id, qPrintable(db.lastError().text()));
+    return false;
+  }
+
+  // Messages reference feeds via their database IDs, so feeds
+  // which survive the replacement must keep them.
+  bool ok;
+  const QHash<QString,int> feed_ids = storedIdsOfAccountItems(db, QSL("Feeds"), account_id, &ok);
+
+  if (!ok || !deleteAccountData(db, account_id, false)) {
+    qCritical("Removing of old feed tree of account %d failed.", account_id);
+    db.rollback();
+    return false;
+  }
+
+  const qint64 delete_time = timer.restart();
+
+  if (!storeAccountTree(db, tree_root, account_id, feed_ids) || !relinkMessagesToFeeds(db, account_id) ||
+      (!archive_schema.isEmpty() && !relinkMessagesToFeeds(db, account_id, archive_schema))) {
+    qCritical("Storing of new feed tree of account %d failed, old tree is kept.", account_id);
+    db.rollback();
+    return false;
+  }
+
+  const qint64 store_time = timer.restart();
+
+  if (!db.commit()) {
+    qCritical("Transaction commit for replacing feed tree of account %d failed: '%s'.",
+              account_id, qPrintable(db.lastError().text()));
+    db.rollback();
+    return false;
+  }
+
+  qDebug("Feed tree of account %d replaced: removing took %lld ms, storing %lld ms, commit %lld ms.",
+         account_id, delete_time, store_time, timer.elapsed());
+  return true;
+}
+
+bool DatabaseQueries::storeAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id, const QHash<QString,int> &feed_ids) {
+  QElapsedTimer timer;
+  QList<RootItem*> parents;
+  int category_count = 0;
+
+  timer.start();
+  parents << tree_root;
+
+  // Categories are stored level by level, each level with multi-row
+  // statements, because children need database IDs of their parents.
+  while (!parents.isEmpty()) {
+    QList<RootItem*> categories;
+    QList<QVariantList> rows;
+
+    foreach (RootItem *parent, parents) {
+      foreach (RootItem *child, parent->childItems()) {
+        if (child->kind() == RootItemKind::Category) {
+          categories.append(child);
+          rows.append(QVariantList() << parent->id() << child->title() << account_id
+                                     << QString::number(child->toCategory()->customId()));
+        }
       }
     }
-    else if (child->kind() == RootItemKind::Feed) {
+
+    if (categories.isEmpty()) {
+      break;
+    }
+
+    if (!execMultiRowStatement(db, QSL("INSERT INTO Categories (parent_id, title, account_id, custom_id) VALUES "),
+                               QSL(";"), rows)) {
+      return false;
+    }
+
+    bool ok;
+    const QHash<QString,int> ids = storedIdsOfAccountItems(db, QSL("Categories"), account_id, &ok);
+
+    if (!ok) {
+      return false;
+    }
+
+    foreach (RootItem *category, categories) {
+      category->setId(ids.value(QString::number(category->toCategory()->customId())));
+    }
+
+    category_count += categories.size();
+    parents = categories;
+  }
+
+  const qint64 categories_time = timer.restart();
+  QList<Feed*> feeds;
+  QList<QVariantList> rows;
+  QHash<qint64,QString> icon_hashes;
+
+  foreach (RootItem *child, tree_root->getSubTree()) {
+    if (child->kind() == RootItemKind::Feed) {
       Feed *feed = child->toFeed();
+      const qint64 icon_key = feed->icon().cacheKey();
 
-      query_feed.bindValue(QSL(":title"), feed->title());
-      query_feed.bindValue(QSL(":icon"), qApp->icons()->toByteArray(feed->icon()));
-      query_feed.bindValue(QSL(":category"), feed->parent()->customId());
-      query_feed.bindValue(QSL(":protected"), 0);
-      query_feed.bindValue(QSL(":update_type"), (int) feed->autoUpdateType());
-      query_feed.bindValue(QSL(":update_interval"), feed->autoUpdateInitialInterval());
-      query_feed.bindValue(QSL(":account_id"), account_id);
-      query_feed.bindValue(QSL(":custom_id"), feed->customId());
-
-      if (query_feed.exec()) {
-        feed->setId(query_feed.lastInsertId().toInt());
-      }
-      else {
-        return false;
+      // Many feeds share the same icon, it is enough to store it once.
+      if (!icon_hashes.contains(icon_key)) {
+        bool ok;
+        const QString hash = storeIcon(db, feed->icon(), &ok);
+
+        if (!ok) {
+          return false;
+        }
+
+        icon_hashes.insert(icon_key, hash);
       }
+
+      const QString custom_id = QString::number(feed->customId());
+
+      feeds.append(feed);
+      rows.append(QVariantList() << (feed_ids.contains(custom_id) ? QVariant(feed_ids.value(custom_id)) : QVariant(QVariant::Int))
+                                 << feed->title() << icon_hashes.value(icon_key) << feed->parent()->customId() << 0
+                                 << (int) feed->autoUpdateType() << feed->autoUpdateInitialInterval()
+                                 << account_id << custom_id);
     }
   }
 
-  return true;
+  const qint64 icons_time = timer.restart();
+
+  if (!feeds.isEmpty()) {
+    if (!execMultiRowStatement(db, QSL("INSERT INTO Feeds (id, title, icon, category, protected, update_type, "
+                                       "update_interval, account_id, custom_id) VALUES "),
+                               QSL(";"), rows)) {
+      return false;
+    }
+
+    bool ok;
+    const QHash<QString,int> ids = storedIdsOfAccountItems(db, QSL("Feeds"), account_id, &ok);
+
+    if (!ok) {
+      return false;
+    }
+
+    foreach (Feed *feed, feeds) {
+      feed->setId(ids.value(QString::number(feed->customId())));
+    }
+  }
+
+  const qint64 feeds_time = timer.restart();
+
+  // Icons of feeds from previous tree could become unused.
+  const bool result = purgeUnusedIcons(db);
+
+  qDebug("Stored %d categories in %lld ms, icons in %lld ms, %d feeds in %lld ms, "
+         "unused icons purged in %lld ms.",
+         category_count, categories_time, icons_time, feeds.size(), feeds_time, timer.elapsed());
+  return result;
+}
+
+QHash<QString,int> DatabaseQueries::storedIdsOfAccountItems(QSqlDatabase db, const QString &table, int account_id, bool *ok) {
+  QHash<QString,int> ids;
+  QSqlQuery q(db);
+
+  q.setForwardOnly(true);
+  q.prepare(QString("SELECT custom_id, id FROM %1 WHERE account_id = :account_id;").arg(table));
+  q.bindValue(QSL(":account_id"), account_id);
+
+  if (DB_EXEC(q)) {
+    while (q.next()) {
+      ids.insert(q.value(0).toString(), q.value(1).toInt());
+    }
+
+    if (ok != nullptr) {
+      *ok = true;
+    }
+  }
+  else {
+    qWarning("Query for IDs of stored %s failed: '%s'.", qPrintable(table), qPrintable(q.lastError().text()));
+
+    if (ok != nullptr) {
+      *ok = false;
+    }
+  }
+
+  return ids;
+}
+
+bool DatabaseQueries::relinkMessagesToFeeds(QSqlDatabase db, int account_id, const QString &schema) {
+  QSqlQuery q(db);
+  const QString messages_table = schema.isEmpty() ? QSL("Messages") : schema + QSL(".Messages");
+
+  q.setForwardOnly(true);
+  q.prepare(QString(QSL("UPDATE %1 SET feed_id = (SELECT id FROM Feeds WHERE Feeds.custom_id = Messages.feed AND Feeds.account_id = :account_id) "
+                        "WHERE account_id = :account_id AND (feed_id IS NULL OR NOT EXISTS "
+                        "(SELECT 1 FROM Feeds WHERE Feeds.id = Messages.feed_id AND Feeds.custom_id = Messages.feed));")).arg(messages_table));
+  q.bindValue(QSL(":account_id"), account_id);
+
+  if (!DB_EXEC(q)) {
+    qWarning("Relinking of messages of account %d to feeds failed: '%s'.", account_id, qPrintable(q.lastError().text()));
+    return false;
+  }
+  else {
+    return true;
+  }
 }
 
 QStringList DatabaseQueries::customIdsOfMessagesFromAccount(QSqlDatabase db, int account_id, bool *ok) {
@@ -815,10 +2097,10 @@ QStringList DatabaseQueries::customIdsOfMessagesFromAccount(QSqlDatabase db, int
   q.bindValue(QSL(":account_id"), account_id);
 
   if (ok != nullptr) {
-    *ok = q.exec();
+    *ok = DB_EXEC(q);
   }
   else {
-    q.exec();
+    DB_EXEC(q);
   }
 
   while (q.next()) {
@@ -836,10 +2118,10 @@ QStringList DatabaseQueries::customIdsOfMessagesFromBin(QSqlDatabase db, int acc
   q.bindValue(QSL(":account_id"), account_id);
 
   if (ok != nullptr) {
-    *ok = q.exec();
+    *ok = DB_EXEC(q);
   }
   else {
-    q.exec();
+    DB_EXEC(q);
   }
 
   while (q.next()) {
@@ -858,10 +2140,10 @@ QStringList DatabaseQueries::customIdsOfMessagesFromFeed(QSqlDatabase db, int fe
   q.bindValue(QSL(":feed"), feed_custom_id);
 
   if (ok != nullptr) {
-    *ok = q.exec();
+    *ok = DB_EXEC(q);
   }
   else {
-    q.exec();
+    DB_EXEC(q);
   }
 
   while (q.next()) {
@@ -875,7 +2157,7 @@ QList<ServiceRoot*> DatabaseQueries::getOwnCloudAccounts(QSqlDatabase db, bool *
   QSqlQuery query(db);
   QList<ServiceRoot*> roots;
 
-  if (query.exec("SELECT * FROM OwnCloudAccounts;")) {
+  if (DB_EXEC_SQL(query, "SELECT * FROM OwnCloudAccounts;")) {
     while (query.next()) {
       OwnCloudServiceRoot *root = new OwnCloudServiceRoot();
       root->setId(query.value(0).toInt());
@@ -908,7 +2190,7 @@ QList<ServiceRoot*> DatabaseQueries::getTtRssAccounts(QSqlDatabase db, bool *ok)
   QSqlQuery query(db);
   QList<ServiceRoot*> roots;
 
-  if (query.exec("SELECT * FROM TtRssAccounts;")) {
+  if (DB_EXEC_SQL(query, "SELECT * FROM TtRssAccounts;")) {
     while (query.next()) {
       TtRssServiceRoot *root = new TtRssServiceRoot();
       root->setId(query.value(0).toInt());
@@ -947,7 +2229,7 @@ bool DatabaseQueries::deleteOwnCloudAccount(QSqlDatabase db, int account_id) {
   q.prepare(QSL("DELETE FROM OwnCloudAccounts WHERE id = :id;"));
   q.bindValue(QSL(":id"), account_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::overwriteOwnCloudAccount(QSqlDatabase db, const QString &username, const QString &password,
@@ -963,7 +2245,7 @@ bool DatabaseQueries::overwriteOwnCloudAccount(QSqlDatabase db, const QString &u
   query.bindValue(QSL(":force_update"), force_server_side_feed_update ? 1 : 0);
   query.bindValue(QSL(":id"), account_id);
 
-  if (query.exec()) {
+  if (DB_EXEC(query)) {
     return true;
   }
   else {
@@ -985,7 +2267,7 @@ bool DatabaseQueries::createOwnCloudAccount(QSqlDatabase db, int id_to_assign, c
   q.bindValue(QSL(":url"), url);
   q.bindValue(QSL(":force_update"), force_server_side_feed_update ? 1 : 0);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     return true;
   }
   else {
@@ -998,7 +2280,7 @@ int DatabaseQueries::createAccount(QSqlDatabase db, const QString &code, bool *o
   QSqlQuery q(db);
 
   // First obtain the ID, which can be assigned to this new account.
-  if (!q.exec("SELECT max(id) FROM Accounts;") || !q.next()) {
+  if (!DB_EXEC_SQL(q, "SELECT max(id) FROM Accounts;") || !q.next()) {
     qWarning("Getting max ID from Accounts table failed: '%s'.", qPrintable(q.lastError().text()));
 
     if (ok != nullptr) {
@@ -1014,7 +2296,7 @@ int DatabaseQueries::createAccount(QSqlDatabase db, const QString &code, bool *o
   q.bindValue(QSL(":id"), id_to_assign);
   q.bindValue(QSL(":type"), code);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     if (ok != nullptr) {
       *ok = true;
     }
@@ -1037,10 +2319,11 @@ Assignment DatabaseQueries::getOwnCloudCategories(QSqlDatabase db, int account_i
   // Obtain data for categories from the database.
   QSqlQuery q(db);
   q.setForwardOnly(true);
-  q.prepare(QSL("SELECT * FROM Categories WHERE account_id = :account_id;"));
+  q.prepare("SELECT Categories.*, Icons.icon FROM Categories LEFT JOIN Icons ON Icons.hash = Categories.icon "
+            "WHERE Categories.account_id = :account_id;");
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qFatal("ownCloud: Query for obtaining categories failed. Error message: '%s'.", qPrintable(q.lastError().text()));
 
     if (ok != nullptr) {
@@ -1068,10 +2351,11 @@ Assignment DatabaseQueries::getOwnCloudFeeds(QSqlDatabase db, int account_id, bo
 
   QSqlQuery q(db);
   q.setForwardOnly(true);
-  q.prepare(QSL("SELECT * FROM Feeds WHERE account_id = :account_id;"));
+  q.prepare("SELECT Feeds.*, Icons.icon FROM Feeds LEFT JOIN Icons ON Icons.hash = Feeds.icon "
+            "WHERE Feeds.account_id = :account_id;");
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qFatal("ownCloud: Query for obtaining feeds failed. Error message: '%s'.", qPrintable(q.lastError().text()));
 
     if (ok != nullptr) {
@@ -1099,11 +2383,27 @@ bool DatabaseQueries::deleteFeed(QSqlDatabase db, int feed_custom_id, int accoun
   q.setForwardOnly(true);
 
   // Remove all messages from this feed.
+  q.prepare(QSL("DELETE FROM MessageBodies WHERE message_id IN (SELECT id FROM Messages WHERE feed = :feed AND account_id = :account_id);"));
+  q.bindValue(QSL(":feed"), feed_custom_id);
+  q.bindValue(QSL(":account_id"), account_id);
+
+  if (!DB_EXEC(q)) {
+    return false;
+  }
+
+  q.prepare(QSL("DELETE FROM MessagesFts WHERE docid IN (SELECT id FROM Messages WHERE feed = :feed AND account_id = :account_id);"));
+  q.bindValue(QSL(":feed"), feed_custom_id);
+  q.bindValue(QSL(":account_id"), account_id);
+
+  if (!DB_EXEC(q)) {
+    return false;
+  }
+
   q.prepare(QSL("DELETE FROM Messages WHERE feed = :feed AND account_id = :account_id;"));
   q.bindValue(QSL(":feed"), feed_custom_id);
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     return false;
   }
 
@@ -1112,7 +2412,7 @@ bool DatabaseQueries::deleteFeed(QSqlDatabase db, int feed_custom_id, int accoun
   q.bindValue(QSL(":feed"), feed_custom_id);
   q.bindValue(QSL(":account_id"), account_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::deleteCategory(QSqlDatabase db, int id) {
@@ -1123,7 +2423,7 @@ bool DatabaseQueries::deleteCategory(QSqlDatabase db, int id) {
   q.prepare(QSL("DELETE FROM Categories WHERE id = :category;"));
   q.bindValue(QSL(":category"), id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 int DatabaseQueries::addCategory(QSqlDatabase db, int parent_id, int account_id, const QString &title,
@@ -1139,10 +2439,10 @@ int DatabaseQueries::addCategory(QSqlDatabase db, int parent_id, int account_id,
   q.bindValue(QSL(":title"), title);
   q.bindValue(QSL(":description"), description);
   q.bindValue(QSL(":date_created"), creation_date.toMSecsSinceEpoch());
-  q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+  q.bindValue(QSL(":icon"), storeIcon(db, icon));
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qDebug("Failed to add category to database: '%s'.", qPrintable(q.lastError().text()));
 
     if (ok != nullptr) {
@@ -1163,7 +2463,7 @@ int DatabaseQueries::addCategory(QSqlDatabase db, int parent_id, int account_id,
     q.prepare(QSL("UPDATE Categories SET custom_id = :custom_id WHERE id = :id;"));
     q.bindValue(QSL(":custom_id"), QString::number(new_id));
     q.bindValue(QSL(":id"), new_id);
-    q.exec();
+    DB_EXEC(q);
 
     return new_id;
   }
@@ -1179,11 +2479,11 @@ bool DatabaseQueries::editCategory(QSqlDatabase db, int parent_id, int category_
             "WHERE id = :id;");
   q.bindValue(QSL(":title"), title);
   q.bindValue(QSL(":description"), description);
-  q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+  q.bindValue(QSL(":icon"), storeIcon(db, icon));
   q.bindValue(QSL(":parent_id"), parent_id);
   q.bindValue(QSL(":id"), category_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 int DatabaseQueries::addFeed(QSqlDatabase db, int parent_id, int account_id, const QString &title,
@@ -1203,7 +2503,7 @@ int DatabaseQueries::addFeed(QSqlDatabase db, int parent_id, int account_id, con
   q.bindValue(QSL(":title"), title.toUtf8());
   q.bindValue(QSL(":description"), description.toUtf8());
   q.bindValue(QSL(":date_created"), creation_date.toMSecsSinceEpoch());
-  q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+  q.bindValue(QSL(":icon"), storeIcon(db, icon));
   q.bindValue(QSL(":category"), parent_id);
   q.bindValue(QSL(":encoding"), encoding);
   q.bindValue(QSL(":url"), url);
@@ -1222,14 +2522,14 @@ int DatabaseQueries::addFeed(QSqlDatabase db, int parent_id, int account_id, con
   q.bindValue(QSL(":update_interval"), auto_update_interval);
   q.bindValue(QSL(":type"), (int) feed_format);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     int new_id = q.lastInsertId().toInt();
 
     // Now set custom ID in the DB.
     q.prepare(QSL("UPDATE Feeds SET custom_id = :custom_id WHERE id = :id;"));
     q.bindValue(QSL(":custom_id"), QString::number(new_id));
     q.bindValue(QSL(":id"), new_id);
-    q.exec();
+    DB_EXEC(q);
 
     if (ok != nullptr) {
       *ok = true;
@@ -1261,7 +2561,7 @@ bool DatabaseQueries::editFeed(QSqlDatabase db, int parent_id, int feed_id, cons
             "WHERE id = :id;");
   q.bindValue(QSL(":title"), title);
   q.bindValue(QSL(":description"), description);
-  q.bindValue(QSL(":icon"), qApp->icons()->toByteArray(icon));
+  q.bindValue(QSL(":icon"), storeIcon(db, icon));
   q.bindValue(QSL(":category"), parent_id);
   q.bindValue(QSL(":encoding"), encoding);
   q.bindValue(QSL(":url"), url);
@@ -1280,7 +2580,7 @@ bool DatabaseQueries::editFeed(QSqlDatabase db, int parent_id, int feed_id, cons
   q.bindValue(QSL(":type"), feed_format);
   q.bindValue(QSL(":id"), feed_id);
 
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::editBaseFeed(QSqlDatabase db, int feed_id, Feed::AutoUpdateType auto_update_type,
@@ -1296,7 +2596,127 @@ bool DatabaseQueries::editBaseFeed(QSqlDatabase db, int feed_id, Feed::AutoUpdat
   q.bindValue(QSL(":update_interval"), auto_update_interval);
   q.bindValue(QSL(":id"), feed_id);
 
-  return q.exec();
+  return DB_EXEC(q);
+}
+
+QString DatabaseQueries::storeIcon(QSqlDatabase db, const QIcon &icon, bool *ok) {
+  QByteArray hash = IconFactory::storedIconHash(icon);
+  QSqlQuery q(db);
+
+  q.setForwardOnly(true);
+
+  if (!hash.isEmpty()) {
+    // Icon was loaded from (or stored to) database before, it does
+    // not have to be encoded again if it is still stored.
+    q.prepare(QSL("SELECT COUNT(*) FROM Icons WHERE hash = :hash;"));
+    q.bindValue(QSL(":hash"), QString::fromLatin1(hash));
+
+    if (DB_EXEC(q) && q.next() && q.value(0).toInt() > 0) {
+      if (ok != nullptr) {
+        *ok = true;
+      }
+
+      return QString::fromLatin1(hash);
+    }
+  }
+
+  const QByteArray icon_data = IconFactory::toByteArray(icon);
+
+  if (hash.isEmpty()) {
+    hash = IconFactory::iconHash(icon_data);
+  }
+
+  const bool stored = insertIcon(db, hash, icon_data);
+
+  if (stored) {
+    IconFactory::rememberStoredIcon(hash, icon);
+  }
+
+  if (ok != nullptr) {
+    *ok = stored;
+  }
+
+  return QString::fromLatin1(hash);
+}
+
+bool DatabaseQueries::insertIcon(QSqlDatabase db, const QByteArray &hash, const QByteArray &icon_data) {
+  QSqlQuery q(db);
+
+  q.setForwardOnly(true);
+  q.prepare(qApp->database()->activeDatabaseDriver() == DatabaseFactory::MYSQL ?
+              QSL("INSERT IGNORE INTO Icons (hash, icon) VALUES (:hash, :icon);") :
+              QSL("INSERT OR IGNORE INTO Icons (hash, icon) VALUES (:hash, :icon);"));
+  q.bindValue(QSL(":hash"), QString::fromLatin1(hash));
+  q.bindValue(QSL(":icon"), icon_data);
+
+  if (DB_EXEC(q)) {
+    return true;
+  }
+  else {
+    qWarning("Storing of icon failed: '%s'.", qPrintable(q.lastError().text()));
+    return false;
+  }
+}
+
+bool DatabaseQueries::purgeUnusedIcons(QSqlDatabase db) {
+  QSqlQuery q(db);
+
+  q.setForwardOnly(true);
+
+  if (!DB_EXEC_SQL(q, QSL("DELETE FROM Icons WHERE "
+                          "hash NOT IN (SELECT icon FROM Feeds WHERE icon IS NOT NULL) AND "
+                          "hash NOT IN (SELECT icon FROM Categories WHERE icon IS NOT NULL);"))) {
+    qWarning("Removing of unused icons failed: '%s'.", qPrintable(q.lastError().text()));
+    return false;
+  }
+  else {
+    return true;
+  }
+}
+
+bool DatabaseQueries::migrateLegacyIcons(QSqlDatabase db) {
+  QSqlQuery q(db);
+  QSqlQuery query_update(db);
+  bool result = true;
+
+  q.setForwardOnly(true);
+  query_update.setForwardOnly(true);
+
+  foreach (const QString &table, QStringList() << QSL("Feeds") << QSL("Categories")) {
+    QList<QPair<int,QByteArray> > legacy_icons;
+
+    if (!DB_EXEC_SQL(q, QString("SELECT id, icon FROM %1 "
+                                "WHERE icon IS NOT NULL AND icon NOT IN (SELECT hash FROM Icons);").arg(table))) {
+      qWarning("Query for icons stored with %s failed: '%s'.", qPrintable(table), qPrintable(q.lastError().text()));
+      result = false;
+      continue;
+    }
+
+    while (q.next()) {
+      legacy_icons.append(QPair<int,QByteArray>(q.value(0).toInt(), q.value(1).toByteArray()));
+    }
+
+    q.finish();
+    query_update.prepare(QString("UPDATE %1 SET icon = :hash WHERE id = :id;").arg(table));
+
+    for (int i = 0; i < legacy_icons.size(); i++) {
+      // Legacy icon data have the same format as data of shared icons.
+      const QByteArray hash = IconFactory::iconHash(legacy_icons.at(i).second);
+
+      query_update.bindValue(QSL(":hash"), QString::fromLatin1(hash));
+      query_update.bindValue(QSL(":id"), legacy_icons.at(i).first);
+
+      if (!insertIcon(db, hash, legacy_icons.at(i).second) || !DB_EXEC(query_update)) {
+        result = false;
+      }
+    }
+
+    if (!legacy_icons.isEmpty()) {
+      qDebug("Moved %d icons stored with %s to shared icons.", legacy_icons.size(), qPrintable(table));
+    }
+  }
+
+  return result;
 }
 
 QList<ServiceRoot*> DatabaseQueries::getAccounts(QSqlDatabase db, bool *ok) {
@@ -1307,7 +2727,7 @@ QList<ServiceRoot*> DatabaseQueries::getAccounts(QSqlDatabase db, bool *ok) {
   q.prepare(QSL("SELECT id FROM Accounts WHERE type = :type;"));
   q.bindValue(QSL(":type"), SERVICE_CODE_STD_RSS);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     while (q.next()) {
       StandardServiceRoot *root = new StandardServiceRoot();
       root->setAccountId(q.value(0).toInt());
@@ -1333,10 +2753,11 @@ Assignment DatabaseQueries::getCategories(QSqlDatabase db, int account_id, bool
   // Obtain data for categories from the database.
   QSqlQuery q(db);
   q.setForwardOnly(true);
-  q.prepare(QSL("SELECT * FROM Categories WHERE account_id = :account_id;"));
+  q.prepare("SELECT Categories.*, Icons.icon FROM Categories LEFT JOIN Icons ON Icons.hash = Categories.icon "
+            "WHERE Categories.account_id = :account_id;");
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qFatal("Query for obtaining categories failed. Error message: '%s'.",
            qPrintable(q.lastError().text()));
 
@@ -1363,13 +2784,15 @@ Assignment DatabaseQueries::getCategories(QSqlDatabase db, int account_id, bool
 
 Assignment DatabaseQueries::getFeeds(QSqlDatabase db, int account_id, bool *ok) {
   Assignment feeds;
+
   QSqlQuery q(db);
 
   q.setForwardOnly(true);
-  q.prepare(QSL("SELECT * FROM Feeds WHERE account_id = :account_id;"));
+  q.prepare("SELECT Feeds.*, Icons.icon FROM Feeds LEFT JOIN Icons ON Icons.hash = Feeds.icon "
+            "WHERE Feeds.account_id = :account_id;");
   q.bindValue(QSL(":account_id"), account_id);
 
-  if (!q.exec()) {
+  if (!DB_EXEC(q)) {
     qFatal("Query for obtaining feeds failed. Error message: '%s'.",
            qPrintable(q.lastError().text()));
 
@@ -1417,7 +2840,7 @@ bool DatabaseQueries::deleteTtRssAccount(QSqlDatabase db, int account_id) {
 
   // Remove extra entry in "Tiny Tiny RSS accounts list" and then delete
   // all the categories/feeds and messages.
-  return q.exec();
+  return DB_EXEC(q);
 }
 
 bool DatabaseQueries::overwriteTtRssAccount(QSqlDatabase db, const QString &username, const QString &password,
@@ -1438,7 +2861,7 @@ bool DatabaseQueries::overwriteTtRssAccount(QSqlDatabase db, const QString &user
   q.bindValue(QSL(":force_update"), force_server_side_feed_update ? 1 : 0);
   q.bindValue(QSL(":id"), account_id);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     return true;
   }
   else {
@@ -1464,7 +2887,7 @@ bool DatabaseQueries::createTtRssAccount(QSqlDatabase db, int id_to_assign, cons
   q.bindValue(QSL(":url"), url);
   q.bindValue(QSL(":force_update"), force_server_side_feed_update ? 1 : 0);
 
-  if (q.exec()) {
+  if (DB_EXEC(q)) {
     return true;
   }
   else {
@@ -1479,10 +2902,11 @@ Assignment DatabaseQueries::getTtRssCategories(QSqlDatabase db, int account_id,
   // Obtain data for categories from the database.
   QSqlQuery query_categories(db);
   query_categories.setForwardOnly(true);
-  query_categories.prepare(QSL("SELECT * FROM Categories WHERE account_id = :account_id;"));
+  query_categories.prepare("SELECT Categories.*, Icons.icon FROM Categories LEFT JOIN Icons ON Icons.hash = Categories.icon "
+                           "WHERE Categories.account_id = :account_id;");
   query_categories.bindValue(QSL(":account_id"), account_id);
 
-  if (!query_categories.exec()) {
+  if (!DB_EXEC(query_categories)) {
     qFatal("Query for obtaining categories failed. Error message: '%s'.", qPrintable(query_categories.lastError().text()));
 
     if (ok != nullptr) {
@@ -1512,10 +2936,11 @@ Assignment DatabaseQueries::getTtRssFeeds(QSqlDatabase db, int account_id, bool
   // All categories are now loaded.
   QSqlQuery query_feeds(db);
   query_feeds.setForwardOnly(true);
-  query_feeds.prepare(QSL("SELECT * FROM Feeds WHERE account_id = :account_id;"));
+  query_feeds.prepare("SELECT Feeds.*, Icons.icon FROM Feeds LEFT JOIN Icons ON Icons.hash = Feeds.icon "
+                      "WHERE Feeds.account_id = :account_id;");
   query_feeds.bindValue(QSL(":account_id"), account_id);
 
-  if (!query_feeds.exec()) {
+  if (!DB_EXEC(query_feeds)) {
     qFatal("Query for obtaining feeds failed. Error message: '%s'.", qPrintable(query_feeds.lastError().text()));
 
     if (ok != nullptr) {
@@ -24,6 +24,7 @@
 #include "services/standard/standardfeed.h"
 
 #include <QSqlQuery>
+#include <QSet>
 
 
 class DatabaseQueries {
@@ -46,17 +47,54 @@ class DatabaseQueries {
     static bool purgeRecycleBin(QSqlDatabase db);
     static bool purgeMessagesFromBin(QSqlDatabase db, bool clear_only_read, int account_id);
     static bool purgeLeftoverMessages(QSqlDatabase db, int account_id);
+    static bool purgeOrphanedMessageData(QSqlDatabase db);
+
+    // Compresses contents of all messages which are not compressed yet, processes
+    // messages in batches of given size. Returns number of compressed messages.
+    static int compressMessageContents(QSqlDatabase db, int batch_size, qint64 *saved_bytes = nullptr, bool *ok = nullptr);
+
+    // Moves read, non-starred messages older than given number of days to archive
+    // databases of their accounts, processes messages in batches of given size.
+    // Returns number of archived messages. Supported only for SQLite.
+    // NOTE: Archiving is not scheduled, it runs only when user requests
+    // it in database cleanup dialog.
+    static int archiveOldMessages(QSqlDatabase db, int older_than_days, int batch_size, bool *ok = nullptr);
+
+    // Returns those of given message IDs, which belong to messages
+    // stored in attached archive with given schema.
+    static QSet<int> archivedMessageIds(QSqlDatabase db, const QString &archive_schema, const QStringList &ids, bool *ok = nullptr);
 
     // Obtain counts of unread/all messages.
     static QMap<int,QPair<int,int> > getMessageCountsForCategory(QSqlDatabase db, int custom_id, int account_id,
                                                                  bool including_total_counts, bool *ok = nullptr);
     static QMap<int,QPair<int,int> > getMessageCountsForAccount(QSqlDatabase db, int account_id,
                                                                 bool including_total_counts, bool *ok = nullptr);
-    static int getMessageCountsForFeed(QSqlDatabase db, int feed_custom_id, int account_id,
-                                       bool including_total_counts, bool *ok = nullptr);
-    static int getMessageCountsForBin(QSqlDatabase db, int account_id, bool including_total_counts, bool *ok = nullptr);
+
+    // Both unread and total counts are obtained with single query.
+    static QPair<int,int> getMessageCountsForFeed(QSqlDatabase db, int feed_custom_id, int account_id, bool *ok = nullptr);
+    static QPair<int,int> getMessageCountsForBin(QSqlDatabase db, int account_id, bool *ok = nullptr);
+
+    // Searches full-text index of messages which match given SQL condition
+    // on "Messages" columns, e.g. filter of message list.
+    // Returns IDs of at most "limit" matching messages, messages with most occurrences
+    // of searched terms go first, newest messages go first among equally relevant ones.
+    // Archive with given schema is searched too if "archive_schema" is not empty.
+    static QList<int> searchMessages(QSqlDatabase db, const QString &pattern, const QString &filter,
+                                     const QString &archive_schema = QString(),
+                                     int limit = MESSAGES_SEARCH_LIMIT, bool *ok = nullptr);
+
+    // Loads contents and enclosures of given message, which
+    // are not part of the data loaded into message list.
+    // Archive of message account is used for messages which are not in main database.
+    static bool loadMessageBody(QSqlDatabase db, Message &message);
+
+    // Reloads given messages including their bodies, all of them are selected
+    // at once. Messages are matched by IDs, those which are not in main
+    // database are loaded from archives of their accounts.
+    static bool loadMessagesWithBodies(QSqlDatabase db, QList<Message> &messages);
 
     // Get messages (for newspaper view for example).
+    // Bodies of messages are not loaded, see loadMessageBody().
     static QList<Message> getUndeletedMessagesForFeed(QSqlDatabase db, int feed_custom_id, int account_id, bool *ok = nullptr);
     static QList<Message> getUndeletedMessagesForBin(QSqlDatabase db, int account_id, bool *ok = nullptr);
     static QList<Message> getUndeletedMessagesForAccount(QSqlDatabase db, int account_id, bool *ok = nullptr);
@@ -67,16 +105,35 @@ class DatabaseQueries {
     static QStringList customIdsOfMessagesFromFeed(QSqlDatabase db, int feed_custom_id, int account_id, bool *ok = nullptr);
 
     // Common accounts methods.
-    static int updateMessages(QSqlDatabase db, const QList<Message> &messages, int feed_custom_id,
-                              int account_id, const QString &url, bool *any_message_changed, bool *ok = nullptr);
+    //
+    // Stores messages of given feed, IDs of inserted and updated
+    // messages are appended to given lists if they are provided.
+    static int updateMessages(QSqlDatabase db, const QList<Message> &messages, int feed_custom_id, int feed_id,
+                              int account_id, const QString &url, bool *any_message_changed, bool *ok = nullptr,
+                              QList<int> *inserted_ids = nullptr, QList<int> *updated_ids = nullptr);
     static bool deleteAccount(QSqlDatabase db, int account_id);
     static bool deleteAccountData(QSqlDatabase db, int account_id, bool delete_messages_too);
     static bool cleanFeeds(QSqlDatabase db, const QStringList &ids, bool clean_read_only, int account_id);
 
-    static bool storeAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id);
+    // Stores categories and feeds of given tree with multi-row statements
+    // and assigns database IDs to them. Feeds whose custom IDs are contained
+    // in "feed_ids" get their previous database IDs back.
+    static bool storeAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id,
+                                 const QHash<QString,int> &feed_ids = QHash<QString,int>());
+
+    // Replaces stored categories and feeds of given account with given
+    // tree. Whole replacement runs in single transaction.
+    static bool replaceAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id);
     static bool editBaseFeed(QSqlDatabase db, int feed_id, Feed::AutoUpdateType auto_update_type,
                              int auto_update_interval);
 
+    // Stores given icon into table of icons shared by all feeds and categories
+    // unless it is stored already. Returns hash which references the icon.
+    static QString storeIcon(QSqlDatabase db, const QIcon &icon, bool *ok = nullptr);
+
+    // Removes icons which are not used by any feed or category.
+    static bool purgeUnusedIcons(QSqlDatabase db);
+
     // ownCloud account.
     static QList<ServiceRoot*> getOwnCloudAccounts(QSqlDatabase db, bool *ok = nullptr);
     static bool deleteOwnCloudAccount(QSqlDatabase db, int account_id);
@@ -123,7 +180,72 @@ class DatabaseQueries {
     static Assignment getTtRssCategories(QSqlDatabase db, int account_id, bool *ok = nullptr);
     static Assignment getTtRssFeeds(QSqlDatabase db, int account_id, bool *ok = nullptr);
 
+    // Moves icons of feeds and categories, which are still stored
+    // inline, to table of shared icons. Done once when database
+    // schema is updated from version without shared icons.
+    static bool migrateLegacyIcons(QSqlDatabase db);
+
+    // Indexes decompressed contents of compressed messages in full-text search
+    // index, processes messages in batches of given size. Done once when search
+    // index is created, because SQL cannot decompress contents of messages.
+    static bool indexCompressedMessages(QSqlDatabase db, int batch_size);
+
   private:
+    // Executes given statement for all given message IDs, placeholder left in the statement
+    // is replaced with list of IDs. IDs are processed in chunks of MESSAGES_BULK_CHUNK_SIZE.
+    static bool execForMessageIds(QSqlDatabase db, const QString &statement, const QStringList &ids);
+
+    // Moves old messages of given account to its archive attached as "schema",
+    // see archiveOldMessages(). Number of moved messages is added to "archived_messages".
+    static bool moveMessagesToArchive(QSqlDatabase db, int account_id, const QString &schema,
+                                      qint64 since_epoch, int batch_size, int &archived_messages);
+
+    // Returns SELECT clause for messages with NULL contents and enclosures,
+    // columns are ordered according to MSG_DB_* indexes.
+    static QString messagesWithoutBodiesSelect();
+
+    // Returns SELECT clause for messages including their bodies,
+    // columns are ordered according to MSG_DB_* indexes.
+    static QString messagesWithBodiesSelect();
+
+    // Executes given statement for IDs of messages in "rows", placeholder left in the statement
+    // is replaced with list of IDs. Selected messages replace messages at their rows
+    // and their IDs are removed from "rows".
+    static bool fillMessages(QSqlDatabase db, const QString &statement, QList<Message> &messages, QHash<int,int> &rows);
+
+    // Returns database IDs of categories or feeds of given account,
+    // hashed by their custom IDs.
+    static QHash<QString,int> storedIdsOfAccountItems(QSqlDatabase db, const QString &table, int account_id, bool *ok);
+
+    // Points messages of given account, whose feed keys are missing
+    // or outdated, to feeds with their custom IDs. Messages in attached
+    // archive are relinked if its "schema" is given.
+    static bool relinkMessagesToFeeds(QSqlDatabase db, int account_id, const QString &schema = QString());
+
+    // Variant of replaceAccountTree() for already attached archive
+    // of given account, empty "archive_schema" means there is no archive.
+    static bool replaceAccountTree(QSqlDatabase db, RootItem *tree_root, int account_id, const QString &archive_schema);
+
+    // Inserts icon data under given hash, existing icon is kept.
+    static bool insertIcon(QSqlDatabase db, const QByteArray &hash, const QByteArray &icon_data);
+
+    // Replaces relative URL of given message with absolute one.
+    static void fixMessageUrl(Message &message, const QString &feed_url);
+
+    // Variant of updateMessages() for MySQL, which loads and stores messages with
+    // multi-row statements, so that number of round trips to server stays low.
+    static int updateMessagesMySQL(QSqlDatabase db, const QList<Message> &messages, int feed_custom_id, int feed_id,
+                                   int account_id, const QString &url, bool *any_message_changed, bool *ok,
+                                   QList<int> *inserted_ids, QList<int> *updated_ids);
+
+    // Executes multi-row statement composed of given head, rows of values and tail.
+    // Rows are split into chunks limited by their count, size and number of values.
+    static bool execMultiRowStatement(QSqlDatabase db, const QString &head, const QString &tail,
+                                      const QList<QVariantList> &rows);
+
+    // Returns list of given number of comma-separated "?" placeholders.
+    static QString placeholders(int count);
+
     explicit DatabaseQueries();
 };
 
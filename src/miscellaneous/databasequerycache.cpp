@@ -0,0 +1,113 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#include "miscellaneous/databasequerycache.h"
+
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+
+QMutex DatabaseQueryCache::s_mutex;
+QHash<QString,QHash<QPair<QThread*,QString>,QSqlQuery> > DatabaseQueryCache::s_queries;
+DatabaseQueryCache::Statistics DatabaseQueryCache::s_statistics = { 0, 0, 0 };
+
+QSqlQuery DatabaseQueryCache::preparedQuery(QSqlDatabase db, const QString &sql, bool *ok) {
+  QMutexLocker locker(&s_mutex);
+  QHash<QPair<QThread*,QString>,QSqlQuery> &connection_queries = s_queries[db.connectionName()];
+  const QPair<QThread*,QString> key(QThread::currentThread(), sql);
+
+  if (connection_queries.contains(key)) {
+    s_statistics.m_hits++;
+
+    if (ok != nullptr) {
+      *ok = true;
+    }
+
+    return connection_queries[key];
+  }
+
+  QElapsedTimer timer;
+  QSqlQuery query(db);
+
+  timer.start();
+  query.setForwardOnly(true);
+
+  const bool prepared = query.prepare(sql);
+
+  s_statistics.m_prepareTime += timer.nsecsElapsed() / 1000;
+  s_statistics.m_misses++;
+
+  if (prepared) {
+    connection_queries.insert(key, query);
+  }
+  else {
+    qWarning("Preparing of query failed: '%s'.", qPrintable(query.lastError().text()));
+    connection_queries.remove(key);
+  }
+
+  if (ok != nullptr) {
+    *ok = prepared;
+  }
+
+  return query;
+}
+
+void DatabaseQueryCache::clear(const QString &connection_name) {
+  QMutexLocker locker(&s_mutex);
+  s_queries.remove(connection_name);
+}
+
+void DatabaseQueryCache::clear(QThread *thread) {
+  QMutexLocker locker(&s_mutex);
+
+  for (QHash<QPair<QThread*,QString>,QSqlQuery> &connection_queries : s_queries) {
+    QMutableHashIterator<QPair<QThread*,QString>,QSqlQuery> i(connection_queries);
+
+    while (i.hasNext()) {
+      if (i.next().key().first == thread) {
+        i.remove();
+      }
+    }
+  }
+}
+
+void DatabaseQueryCache::clearAll() {
+  QMutexLocker locker(&s_mutex);
+  s_queries.clear();
+}
+
+DatabaseQueryCache::Statistics DatabaseQueryCache::statistics() {
+  QMutexLocker locker(&s_mutex);
+  return s_statistics;
+}
+
+void DatabaseQueryCache::resetStatistics() {
+  QMutexLocker locker(&s_mutex);
+  s_statistics.m_hits = s_statistics.m_misses = s_statistics.m_prepareTime = 0;
+}
+
+void DatabaseQueryCache::logStatistics() {
+  const Statistics stats = statistics();
+
+  qDebug("Prepared query cache: %lld hits, %lld misses, %lld us spent preparing queries.",
+         stats.m_hits, stats.m_misses, stats.m_prepareTime);
+}
+
+DatabaseQueryCache::DatabaseQueryCache() {
+}
@@ -0,0 +1,72 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DATABASEQUERYCACHE_H
+#define DATABASEQUERYCACHE_H
+
+#include <QSqlQuery>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+
+
+class QThread;
+
+
+class DatabaseQueryCache {
+  public:
+    struct Statistics {
+      // Number of queries served from cache.
+      qint64 m_hits;
+
+      // Number of queries which had to be prepared.
+      qint64 m_misses;
+
+      // Total time spent in preparing queries, in microseconds.
+      qint64 m_prepareTime;
+    };
+
+    // Returns forward-only query prepared with given SQL on given connection.
+    // Each SQL text is prepared only once per connection and calling thread,
+    // next calls return the same prepared query with its previously bound values.
+    // Threads sharing one connection (in-memory database) never share queries.
+    // NOTE: Caller must call finish() on returned query once its results are
+    // not needed anymore, so that it can be safely reused.
+    static QSqlQuery preparedQuery(QSqlDatabase db, const QString &sql, bool *ok = nullptr);
+
+    // Drops cached queries of given connection, this must be done
+    // whenever the connection is closed, removed or re-created.
+    static void clear(const QString &connection_name);
+
+    // Drops cached queries of given thread on all connections, this must be
+    // done once the thread finishes.
+    static void clear(QThread *thread);
+    static void clearAll();
+
+    static Statistics statistics();
+    static void resetStatistics();
+    static void logStatistics();
+
+  private:
+    explicit DatabaseQueryCache();
+
+    static QMutex s_mutex;
+    static QHash<QString,QHash<QPair<QThread*,QString>,QSqlQuery> > s_queries;
+    static Statistics s_statistics;
+};
+
+#endif // DATABASEQUERYCACHE_H
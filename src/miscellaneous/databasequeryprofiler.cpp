@@ -0,0 +1,222 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#include "miscellaneous/databasequeryprofiler.h"
+
+#include "definitions/definitions.h"
+
+#include <QSqlError>
+#include <QSqlDriver>
+#include <QSqlRecord>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QRegExp>
+
+#include <algorithm>
+
+
+QMutex DatabaseQueryProfiler::s_mutex;
+QHash<QString,DatabaseQueryProfiler::StatementStatistics> DatabaseQueryProfiler::s_statements;
+int DatabaseQueryProfiler::s_slowQueryThreshold = DATABASE_SLOW_QUERY_THRESHOLD;
+bool DatabaseQueryProfiler::s_queryPlanCapture = false;
+
+bool DatabaseQueryProfiler::exec(QSqlQuery &query, const char *site) {
+  if (s_slowQueryThreshold < 0) {
+    return query.exec();
+  }
+
+  QElapsedTimer timer;
+
+  timer.start();
+
+  const bool result = query.exec();
+
+  record(query, timer.nsecsElapsed() / 1000, query.numRowsAffected(), site);
+  return result;
+}
+
+bool DatabaseQueryProfiler::exec(QSqlQuery &query, const QString &sql, const char *site) {
+  if (s_slowQueryThreshold < 0) {
+    return query.exec(sql);
+  }
+
+  QElapsedTimer timer;
+
+  timer.start();
+
+  const bool result = query.exec(sql);
+
+  record(query, timer.nsecsElapsed() / 1000, query.numRowsAffected(), site);
+  return result;
+}
+
+void DatabaseQueryProfiler::record(const QSqlQuery &query, qint64 elapsed, qint64 rows, const char *site) {
+  if (s_slowQueryThreshold < 0) {
+    return;
+  }
+
+  const QString sql = query.lastQuery();
+  const bool is_slow = elapsed >= s_slowQueryThreshold * 1000LL;
+
+  {
+    QMutexLocker locker(&s_mutex);
+
+    // Statements with inlined values would make the list grow without
+    // limits, so only already known statements are counted when it is full.
+    if (s_statements.contains(sql) || s_statements.size() < DATABASE_PROFILER_MAX_STATEMENTS) {
+      StatementStatistics &stats = s_statements[sql];
+
+      if (stats.m_executions == 0) {
+        stats.m_sql = sql;
+      }
+
+      stats.m_site = QString::fromLatin1(site);
+      stats.m_executions++;
+      stats.m_totalTime += elapsed;
+      stats.m_maxTime = qMax(stats.m_maxTime, elapsed);
+      stats.m_rows += qMax(rows, 0LL);
+
+      if (is_slow) {
+        stats.m_slowExecutions++;
+      }
+    }
+  }
+
+  if (is_slow) {
+    qWarning("Slow query (%lld ms, %lld rows) in '%s': '%s'.",
+             elapsed / 1000, rows, site, qPrintable(sql.simplified()));
+
+    if (s_queryPlanCapture) {
+      const QString plan = queryPlan(query);
+
+      if (!plan.isEmpty()) {
+        qWarning("Query plan of slow query:\n%s", qPrintable(plan));
+
+        QMutexLocker locker(&s_mutex);
+
+        if (s_statements.contains(sql)) {
+          s_statements[sql].m_queryPlan = plan;
+        }
+      }
+    }
+  }
+}
+
+void DatabaseQueryProfiler::setSlowQueryThreshold(int threshold) {
+  s_slowQueryThreshold = threshold;
+}
+
+int DatabaseQueryProfiler::slowQueryThreshold() {
+  return s_slowQueryThreshold;
+}
+
+void DatabaseQueryProfiler::setQueryPlanCapture(bool capture) {
+  s_queryPlanCapture = capture;
+}
+
+QList<DatabaseQueryProfiler::StatementStatistics> DatabaseQueryProfiler::topStatements(int count) {
+  QList<StatementStatistics> statements;
+
+  {
+    QMutexLocker locker(&s_mutex);
+    statements = s_statements.values();
+  }
+
+  std::sort(statements.begin(), statements.end(), [](const StatementStatistics &lhs, const StatementStatistics &rhs) {
+    return lhs.m_totalTime > rhs.m_totalTime;
+  });
+
+  return statements.mid(0, count);
+}
+
+void DatabaseQueryProfiler::logTopStatements(int count) {
+  const QList<StatementStatistics> statements = topStatements(count);
+
+  qDebug("Top %d SQL statements by total execution time:", statements.size());
+
+  for (int i = 0; i < statements.size(); i++) {
+    const StatementStatistics &stats = statements.at(i);
+
+    qDebug("%d. %lld us total, %lld us max, %lld executions (%lld slow), %lld rows, last executed in '%s': '%s'.",
+           i + 1, stats.m_totalTime, stats.m_maxTime, stats.m_executions, stats.m_slowExecutions,
+           stats.m_rows, qPrintable(stats.m_site), qPrintable(stats.m_sql.simplified()));
+
+    if (!stats.m_queryPlan.isEmpty()) {
+      qDebug("Query plan:\n%s", qPrintable(stats.m_queryPlan));
+    }
+  }
+}
+
+void DatabaseQueryProfiler::resetStatistics() {
+  QMutexLocker locker(&s_mutex);
+  s_statements.clear();
+}
+
+QString DatabaseQueryProfiler::queryPlan(const QSqlQuery &query) {
+  const QString sql = query.lastQuery().trimmed();
+  const QString keyword = sql.section(QRegExp(QSL("\\s+")), 0, 0).toUpper();
+
+  // Transaction control statements and pragmas do not have any plan.
+  if (keyword != QL1S("SELECT") && keyword != QL1S("INSERT") && keyword != QL1S("UPDATE") &&
+      keyword != QL1S("DELETE") && keyword != QL1S("REPLACE") && keyword != QL1S("WITH")) {
+    return QString();
+  }
+
+  const QSqlDriver *driver = query.driver();
+
+  if (driver == nullptr) {
+    return QString();
+  }
+
+  // New query shares the driver, thus the connection, of profiled query.
+  QSqlQuery explain(driver->createResult());
+  const int bound_values = query.boundValues().size();
+
+  explain.setForwardOnly(true);
+
+  if (!explain.prepare((driver->dbmsType() == QSqlDriver::MySqlServer ? QSL("EXPLAIN ") : QSL("EXPLAIN QUERY PLAN ")) + sql)) {
+    qWarning("Query plan cannot be obtained: '%s'.", qPrintable(explain.lastError().text()));
+    return QString();
+  }
+
+  for (int i = 0; i < bound_values; i++) {
+    explain.bindValue(i, query.boundValue(i));
+  }
+
+  if (!explain.exec()) {
+    qWarning("Query plan cannot be obtained: '%s'.", qPrintable(explain.lastError().text()));
+    return QString();
+  }
+
+  QStringList plan;
+
+  while (explain.next()) {
+    QStringList columns;
+
+    for (int i = 0; i < explain.record().count(); i++) {
+      columns.append(explain.value(i).toString());
+    }
+
+    plan.append(columns.join(QL1C('|')));
+  }
+
+  return plan.join(QL1C('\n'));
+}
+
+DatabaseQueryProfiler::DatabaseQueryProfiler() {
+}
@@ -0,0 +1,89 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DATABASEQUERYPROFILER_H
+#define DATABASEQUERYPROFILER_H
+
+#include <QSqlQuery>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+
+// Executes given query and records how long it took, caller is remembered as
+// the site which executed the statement.
+#define DB_EXEC(query) DatabaseQueryProfiler::exec(query, Q_FUNC_INFO)
+#define DB_EXEC_SQL(query, sql) DatabaseQueryProfiler::exec(query, sql, Q_FUNC_INFO)
+
+class DatabaseQueryProfiler {
+  public:
+    struct StatementStatistics {
+      // SQL text of the statement, with placeholders if it was prepared.
+      QString m_sql;
+
+      // Function which executed the statement last time.
+      QString m_site;
+
+      qint64 m_executions;
+      qint64 m_slowExecutions;
+
+      // Total and maximal execution time, in microseconds.
+      qint64 m_totalTime;
+      qint64 m_maxTime;
+
+      // Total number of rows affected (or fetched) by the statement.
+      qint64 m_rows;
+
+      // Query plan of last slow execution, if it was captured.
+      QString m_queryPlan;
+    };
+
+    // Executes prepared query and records its execution.
+    static bool exec(QSqlQuery &query, const char *site);
+
+    // Executes given SQL and records its execution.
+    static bool exec(QSqlQuery &query, const QString &sql, const char *site);
+
+    // Records execution of statement which was not executed via exec() methods,
+    // for example when query was executed by a model. Time is in microseconds.
+    static void record(const QSqlQuery &query, qint64 elapsed, qint64 rows, const char *site);
+
+    // Statements which run longer than threshold (in milliseconds) are logged.
+    // Negative threshold turns profiling off completely.
+    static void setSlowQueryThreshold(int threshold);
+    static int slowQueryThreshold();
+
+    // If enabled, query plan of each slow statement is obtained and logged.
+    static void setQueryPlanCapture(bool capture);
+
+    // Returns statements sorted by their total execution time.
+    static QList<StatementStatistics> topStatements(int count);
+    static void logTopStatements(int count);
+    static void resetStatistics();
+
+  private:
+    explicit DatabaseQueryProfiler();
+
+    static QString queryPlan(const QSqlQuery &query);
+
+    static QMutex s_mutex;
+    static QHash<QString,StatementStatistics> s_statements;
+    static int s_slowQueryThreshold;
+    static bool s_queryPlanCapture;
+};
+
+#endif // DATABASEQUERYPROFILER_H
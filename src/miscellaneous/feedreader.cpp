@@ -27,20 +27,24 @@
 #include "core/messagesmodel.h"
 #include "core/messagesproxymodel.h"
 #include "core/feeddownloader.h"
+#include "core/messagesbulkupdater.h"
 #include "miscellaneous/databasecleaner.h"
 #include "miscellaneous/application.h"
 #include "miscellaneous/mutex.h"
 
 #include <QThread>
 #include <QTimer>
+#include <QCoreApplication>
 #include <QtConcurrent/QtConcurrentRun>
 
 
 FeedReader::FeedReader(QObject *parent)
   : QObject(parent), m_feedServices(QList<ServiceEntryPoint*>()),
     m_cacheSaveFutureWatcher(new QFutureWatcher<void>(this)), m_autoUpdateTimer(new QTimer(this)),
+    m_compactionTimer(new QTimer(this)), m_compactionRunning(false),
     m_feedDownloaderThread(nullptr), m_feedDownloader(nullptr),
-    m_dbCleanerThread(nullptr), m_dbCleaner(nullptr) {
+    m_dbCleanerThread(nullptr), m_dbCleaner(nullptr),
+    m_messagesBulkUpdaterThread(nullptr), m_messagesBulkUpdater(nullptr) {
   m_feedsModel = new FeedsModel(this);
   m_feedsProxyModel = new FeedsProxyModel(m_feedsModel, this);
   m_messagesModel = new MessagesModel(this);
@@ -51,6 +55,11 @@ FeedReader::FeedReader(QObject *parent)
   updateAutoUpdateStatus();
   asyncCacheSaveFinished();
 
+  if (qApp->database()->activeDatabaseDriver() != DatabaseFactory::MYSQL) {
+    connect(m_compactionTimer, &QTimer::timeout, this, &FeedReader::compactDatabaseIfIdle);
+    m_compactionTimer->start(DATABASE_COMPACTION_INTERVAL);
+  }
+
   if (qApp->settings()->value(GROUP(Feeds), SETTING(Feeds::FeedsUpdateOnStartup)).toBool()) {
     qDebug("Requesting update for all feeds on application startup.");
     QTimer::singleShot(STARTUP_UPDATE_DELAY, this, SLOT(updateAllFeeds()));
@@ -159,6 +168,10 @@ DatabaseCleaner *FeedReader::databaseCleaner() {
     m_dbCleaner->moveToThread(m_dbCleanerThread);
     connect(m_dbCleanerThread, SIGNAL(finished()), m_dbCleanerThread, SLOT(deleteLater()));
 
+    connect(m_dbCleaner, &DatabaseCleaner::compactionFinished, this, [this]() {
+      m_compactionRunning = false;
+    });
+
     // Connections are made, start the feed downloader thread.
     m_dbCleanerThread->start();
   }
@@ -166,6 +179,23 @@ DatabaseCleaner *FeedReader::databaseCleaner() {
   return m_dbCleaner;
 }
 
+MessagesBulkUpdater *FeedReader::messagesBulkUpdater() {
+  if (m_messagesBulkUpdater == nullptr) {
+    m_messagesBulkUpdater = new MessagesBulkUpdater();
+    m_messagesBulkUpdaterThread = new QThread();
+
+    // Updater setup.
+    qRegisterMetaType<MessagesBulkUpdater::Operation>("MessagesBulkUpdater::Operation");
+    m_messagesBulkUpdater->moveToThread(m_messagesBulkUpdaterThread);
+    connect(m_messagesBulkUpdaterThread, &QThread::finished, m_messagesBulkUpdaterThread, &QThread::deleteLater);
+
+    // Connections are made, start the updater thread.
+    m_messagesBulkUpdaterThread->start();
+  }
+
+  return m_messagesBulkUpdater;
+}
+
 FeedDownloader *FeedReader::feedDownloader() const {
   return m_feedDownloader;
 }
@@ -263,22 +293,35 @@ void FeedReader::asyncCacheSaveFinished() {
   });
 }
 
+void FeedReader::compactDatabaseIfIdle() {
+  // Critical operations, for example database cleanup, must not be disturbed.
+  // Compaction itself does not take their lock, so that feed updates can be
+  // started anytime, they just wait for running compaction step in database.
+  if (m_compactionRunning || isFeedUpdateRunning() || m_messagesModel->isBulkOperationRunning() ||
+      qApp->feedUpdateLock()->isLocked()) {
+    return;
+  }
+
+  m_compactionRunning = true;
+  QMetaObject::invokeMethod(databaseCleaner(), "compactDatabase", Q_ARG(int, DATABASE_COMPACTION_STEP_PAGES));
+}
+
 void FeedReader::quit() {
   if (m_autoUpdateTimer->isActive()) {
     m_autoUpdateTimer->stop();
   }
 
+  m_compactionTimer->stop();
+
   checkServicesForAsyncOperations(true);
 
   // Close worker threads.
   if (m_feedDownloaderThread != nullptr && m_feedDownloaderThread->isRunning()) {
-    m_feedDownloader->stopRunningUpdate();
-
-    if (m_feedDownloader->isUpdateRunning()) {
-      QEventLoop loop(this);
-      connect(m_feedDownloader, &FeedDownloader::updateFinished, &loop, &QEventLoop::quit);
-      loop.exec();
-    }
+    // Feeds which are already being updated are finished in downloader thread,
+    // its results queued for this thread are delivered then.
+    QMetaObject::invokeMethod(m_feedDownloader, "finishRunningUpdate", Qt::BlockingQueuedConnection);
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+    QCoreApplication::sendPostedEvents(qApp->feedUpdateLock(), QEvent::MetaCall);
 
     qDebug("Quitting feed downloader thread.");
     m_feedDownloaderThread->quit();
@@ -299,6 +342,21 @@ void FeedReader::quit() {
     }
   }
 
+  if (m_messagesBulkUpdaterThread != nullptr && m_messagesBulkUpdaterThread->isRunning()) {
+    // Let all pending changes of messages be stored, their results are
+    // then delivered to the model, so that services are notified about them.
+    QMetaObject::invokeMethod(m_messagesBulkUpdater, "finishOperations", Qt::BlockingQueuedConnection);
+    QCoreApplication::sendPostedEvents(m_messagesModel, QEvent::MetaCall);
+
+    qDebug("Quitting messages bulk updater thread.");
+    m_messagesBulkUpdaterThread->quit();
+
+    if (!m_messagesBulkUpdaterThread->wait(CLOSE_LOCK_TIMEOUT)) {
+      qCritical("Messages bulk updater thread is running despite it was told to quit. Terminating it.");
+      m_messagesBulkUpdaterThread->terminate();
+    }
+  }
+
   // Close workers.
   if (m_feedDownloader != nullptr) {
     qDebug("Feed downloader exists. Deleting it from memory.");
@@ -310,6 +368,11 @@ void FeedReader::quit() {
     m_dbCleaner->deleteLater();
   }
 
+  if (m_messagesBulkUpdater != nullptr) {
+    qDebug("Messages bulk updater exists. Deleting it from memory.");
+    m_messagesBulkUpdater->deleteLater();
+  }
+
   if (qApp->settings()->value(GROUP(Messages), SETTING(Messages::ClearReadOnExit)).toBool()) {
     m_feedsModel->markItemCleared(m_feedsModel->rootItem(), true);
   }
@@ -33,6 +33,7 @@ class FeedsProxyModel;
 class ServiceEntryPoint;
 class ServiceOperator;
 class DatabaseCleaner;
+class MessagesBulkUpdater;
 class QTimer;
 
 class FeedReader : public QObject {
@@ -49,6 +50,9 @@ class FeedReader : public QObject {
     // Access to DB cleaner.
     DatabaseCleaner *databaseCleaner();
 
+    // Access to worker which stores changes of large message selections.
+    MessagesBulkUpdater *messagesBulkUpdater();
+
     FeedDownloader *feedDownloader() const;
     FeedsModel *feedsModel() const;
     MessagesModel *messagesModel() const;
@@ -81,6 +85,9 @@ class FeedReader : public QObject {
     void checkServicesForAsyncOperations(bool wait_for_future);
     void asyncCacheSaveFinished();
 
+    // Reclaims part of free space of database file if nothing else is running.
+    void compactDatabaseIfIdle();
+
   signals:
     void feedUpdatesStarted();
     void feedUpdatesFinished(FeedDownloadResults updated_feeds);
@@ -102,6 +109,10 @@ class FeedReader : public QObject {
     int m_globalAutoUpdateInitialInterval;
     int m_globalAutoUpdateRemainingInterval;
 
+    // Incremental database compaction.
+    QTimer *m_compactionTimer;
+    bool m_compactionRunning;
+
     ServiceOperator *m_serviceOperator;
 
     QThread *m_feedDownloaderThread;
@@ -109,6 +120,9 @@ class FeedReader : public QObject {
 
     QThread *m_dbCleanerThread;
     DatabaseCleaner *m_dbCleaner;
+
+    QThread *m_messagesBulkUpdaterThread;
+    MessagesBulkUpdater *m_messagesBulkUpdater;
 };
 
 #endif // FEEDREADER_H
@@ -20,8 +20,15 @@
 #include "miscellaneous/settings.h"
 
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <QPixmap>
 
 
+QMutex IconFactory::s_iconsMutex;
+QCache<QByteArray,QIcon> IconFactory::s_storedIcons(ICONS_CACHE_SIZE);
+QCache<qint64,QByteArray> IconFactory::s_storedIconHashes(ICONS_CACHE_SIZE);
+
 IconFactory::IconFactory(QObject *parent) : QObject(parent) {
 }
 
@@ -57,6 +64,65 @@ QByteArray IconFactory::toByteArray(const QIcon &icon) {
   return array.toBase64();
 }
 
+QByteArray IconFactory::iconHash(const QByteArray &array) {
+  return QCryptographicHash::hash(array, QCryptographicHash::Sha1).toHex();
+}
+
+QIcon IconFactory::fromStoredIcon(const QByteArray &hash, const QByteArray &array) {
+  if (array.isEmpty()) {
+    return fromByteArray(hash);
+  }
+
+  QMutexLocker locker(&s_iconsMutex);
+
+  if (s_storedIcons.contains(hash)) {
+    return *s_storedIcons.object(hash);
+  }
+
+  const QIcon icon = fromByteArray(array);
+
+  s_storedIcons.insert(hash, new QIcon(icon));
+  s_storedIconHashes.insert(icon.cacheKey(), new QByteArray(hash));
+  return icon;
+}
+
+QByteArray IconFactory::storedIconHash(const QIcon &icon) {
+  QMutexLocker locker(&s_iconsMutex);
+  const QByteArray *hash = s_storedIconHashes.object(icon.cacheKey());
+
+  return hash != nullptr ? *hash : QByteArray();
+}
+
+void IconFactory::rememberStoredIcon(const QByteArray &hash, const QIcon &icon) {
+  QMutexLocker locker(&s_iconsMutex);
+
+  if (!s_storedIcons.contains(hash)) {
+    s_storedIcons.insert(hash, new QIcon(icon));
+  }
+
+  s_storedIconHashes.insert(icon.cacheKey(), new QByteArray(hash));
+}
+
+QIcon IconFactory::fromImageData(const QByteArray &image_data) {
+  QPixmap pixmap;
+
+  pixmap.loadFromData(image_data);
+
+  // Icon is keyed by hash of its stored form, the same as in storeIcon(),
+  // so that the same icon is never stored twice under different hashes.
+  const QIcon icon(pixmap);
+  const QByteArray hash = iconHash(toByteArray(icon));
+  QMutexLocker locker(&s_iconsMutex);
+
+  if (s_storedIcons.contains(hash)) {
+    return *s_storedIcons.object(hash);
+  }
+
+  s_storedIcons.insert(hash, new QIcon(icon));
+  s_storedIconHashes.insert(icon.cacheKey(), new QByteArray(hash));
+  return icon;
+}
+
 QPixmap IconFactory::pixmap(const QString &name) {
   if (QIcon::themeName() == APP_NO_THEME) {
     return QPixmap();
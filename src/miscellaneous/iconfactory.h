@@ -25,8 +25,9 @@
 
 #include <QString>
 #include <QIcon>
-#include <QHash>
+#include <QCache>
 #include <QDir>
+#include <QMutex>
 
 
 class IconFactory : public QObject {
@@ -44,6 +45,24 @@ class IconFactory : public QObject {
     static QIcon fromByteArray(QByteArray array);
     static QByteArray toByteArray(const QIcon &icon);
 
+    // Returns hash which identifies icon stored as given byte array.
+    static QByteArray iconHash(const QByteArray &array);
+
+    // Returns icon stored in database under given hash. Recently used
+    // icons are not decoded again, next calls return the same icon. If
+    // "array" is empty, then "hash" is treated as legacy icon data.
+    static QIcon fromStoredIcon(const QByteArray &hash, const QByteArray &array);
+
+    // Returns hash under which given icon was stored or loaded
+    // or empty array if the icon is not known.
+    static QByteArray storedIconHash(const QIcon &icon);
+    static void rememberStoredIcon(const QByteArray &hash, const QIcon &icon);
+
+    // Creates icon from downloaded image. Icon is remembered under hash of
+    // its stored form, so it is stored under that hash too and same image
+    // downloaded later yields the same icon, which is not stored again.
+    static QIcon fromImageData(const QByteArray &image_data);
+
     QPixmap pixmap(const QString &name);
 
     // Returns icon from active theme or invalid icon if
@@ -71,6 +90,11 @@ class IconFactory : public QObject {
 
     // Sets icon theme with given name as the active one and loads it.
     void setCurrentIconTheme(const QString &theme_name);
+
+  private:
+    static QMutex s_iconsMutex;
+    static QCache<QByteArray,QIcon> s_storedIcons;
+    static QCache<qint64,QByteArray> s_storedIconHashes;
 };
 
 #endif // ICONFACTORY_H
@@ -0,0 +1,94 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#include "miscellaneous/messagehtmlcache.h"
+
+#include "definitions/definitions.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+
+QMutex MessageHtmlCache::s_mutex;
+QCache<QString,MessageHtmlCache::Entry> MessageHtmlCache::s_entries(MESSAGES_HTML_CACHE_SIZE);
+MessageHtmlCache::Statistics MessageHtmlCache::s_statistics = { 0, 0, 0, 0 };
+
+QString MessageHtmlCache::html(const Message &message, const QString &layout) {
+  QMutexLocker locker(&s_mutex);
+  const Entry *entry = s_entries.object(key(message, layout));
+
+  if (entry != nullptr && entry->m_checksum == checksum(message)) {
+    s_statistics.m_hits++;
+    return entry->m_html;
+  }
+  else {
+    s_statistics.m_misses++;
+    return QString();
+  }
+}
+
+void MessageHtmlCache::insert(const Message &message, const QString &layout, const QString &html) {
+  QMutexLocker locker(&s_mutex);
+  Entry *entry = new Entry();
+
+  entry->m_html = html;
+  entry->m_checksum = checksum(message);
+
+  // Cost of entry is its size, least recently used entries
+  // are dropped once total size exceeds the limit.
+  s_entries.insert(key(message, layout), entry, html.size() * sizeof(QChar));
+}
+
+void MessageHtmlCache::clear() {
+  QMutexLocker locker(&s_mutex);
+  s_entries.clear();
+}
+
+MessageHtmlCache::Statistics MessageHtmlCache::statistics() {
+  QMutexLocker locker(&s_mutex);
+  Statistics stats = s_statistics;
+
+  stats.m_count = s_entries.count();
+  stats.m_size = s_entries.totalCost();
+  return stats;
+}
+
+void MessageHtmlCache::resetStatistics() {
+  QMutexLocker locker(&s_mutex);
+  s_statistics.m_hits = s_statistics.m_misses = 0;
+}
+
+void MessageHtmlCache::logStatistics() {
+  const Statistics stats = statistics();
+
+  qDebug("Rendered message cache: %lld hits, %lld misses, %d messages using %d bytes.",
+         stats.m_hits, stats.m_misses, stats.m_count, stats.m_size);
+}
+
+QString MessageHtmlCache::key(const Message &message, const QString &layout) {
+  return layout + QL1C('#') + QString::number(message.m_id);
+}
+
+uint MessageHtmlCache::checksum(const Message &message) {
+  // Fields are hashed in order, so that values swapped between them change the checksum.
+  return qHash(QStringList() << message.m_title << message.m_url << message.m_author << message.m_contents <<
+               QString::number(message.m_created.toMSecsSinceEpoch()) <<
+               Enclosures::encodeEnclosuresToString(message.m_enclosures));
+}
+
+MessageHtmlCache::MessageHtmlCache() {
+}
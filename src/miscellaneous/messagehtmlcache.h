@@ -0,0 +1,74 @@
+// This file is part of RSS Guard.
+//
+// Copyright (C) 2011-2017 by Martin Rotter <rotter.martinos@gmail.com>
+//
+// RSS Guard is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// RSS Guard is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with RSS Guard. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MESSAGEHTMLCACHE_H
+#define MESSAGEHTMLCACHE_H
+
+#include "core/message.h"
+
+#include <QCache>
+#include <QMutex>
+
+
+// Least recently used HTML of rendered messages. Entries are hashed by IDs
+// of messages and layouts (for example skin) they were rendered with and
+// their total size is limited. Cache can be used from worker threads.
+class MessageHtmlCache {
+  public:
+    struct Statistics {
+      // Number of messages served from cache.
+      qint64 m_hits;
+
+      // Number of messages which had to be rendered.
+      qint64 m_misses;
+
+      // Number of cached messages and their total size, in bytes.
+      int m_count;
+      int m_size;
+    };
+
+    // Returns HTML of given message rendered with given layout or null string.
+    // HTML of message whose rendered fields, for example contents or enclosures,
+    // changed since is not returned.
+    static QString html(const Message &message, const QString &layout);
+    static void insert(const Message &message, const QString &layout, const QString &html);
+
+    // Drops all cached HTML, this must be done when
+    // some setting which affects rendering changes.
+    static void clear();
+
+    static Statistics statistics();
+    static void resetStatistics();
+    static void logStatistics();
+
+  private:
+    explicit MessageHtmlCache();
+
+    struct Entry {
+      QString m_html;
+      uint m_checksum;
+    };
+
+    static QString key(const Message &message, const QString &layout);
+    static uint checksum(const Message &message);
+
+    static QMutex s_mutex;
+    static QCache<QString,Entry> s_entries;
+    static Statistics s_statistics;
+};
+
+#endif // MESSAGEHTMLCACHE_H
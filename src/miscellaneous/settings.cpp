@@ -222,6 +222,15 @@ DVALUE(bool) Database::UseTransactionsDef   = false;
 DKEY Database::UseInMemory              = "use_in_memory_db";
 DVALUE(bool) Database::UseInMemoryDef   = false;
 
+DKEY Database::CompressMessageContents             = "compress_message_contents";
+DVALUE(bool) Database::CompressMessageContentsDef  = false;
+
+DKEY Database::SlowQueryThreshold                = "slow_query_threshold";
+DVALUE(int) Database::SlowQueryThresholdDef      = DATABASE_SLOW_QUERY_THRESHOLD;
+
+DKEY Database::CaptureQueryPlans                 = "capture_query_plans";
+DVALUE(bool) Database::CaptureQueryPlansDef      = false;
+
 DKEY Database::MySQLHostname              = "mysql_hostname";
 DVALUE(QString) Database::MySQLHostnameDef  = QString();
 
@@ -249,6 +249,15 @@ namespace Database {
   KEY UseInMemory;
   VALUE(bool) UseInMemoryDef;
 
+  KEY CompressMessageContents;
+  VALUE(bool) CompressMessageContentsDef;
+
+  KEY SlowQueryThreshold;
+  VALUE(int) SlowQueryThresholdDef;
+
+  KEY CaptureQueryPlans;
+  VALUE(bool) CaptureQueryPlansDef;
+
   KEY MySQLHostname;
   VALUE(QString) MySQLHostnameDef;
 
@@ -27,6 +27,8 @@
 #include <QStringList>
 #include <QLocale>
 #include <QDir>
+#include <QCryptographicHash>
+#include <QtEndian>
 
 
 quint64 TextFactory::s_encryptionKey = 0x0;
@@ -123,6 +125,43 @@ QString TextFactory::decrypt(const QString &text) {
   return SimpleCrypt(initializeSecretEncryptionKey()).decryptToString(text);
 }
 
+QString TextFactory::compressText(const QString &text) {
+  if (text.isEmpty() || isTextCompressed(text)) {
+    return text;
+  }
+
+  const QString compressed = QSL(COMPRESSED_TEXT_HEADER) +
+                             QString::fromLatin1(qCompress(text.toUtf8(), COMPRESSED_TEXT_LEVEL).toBase64());
+
+  return compressed.size() < text.size() ? compressed : text;
+}
+
+QString TextFactory::decompressText(const QString &text) {
+  if (!isTextCompressed(text)) {
+    return text;
+  }
+
+  const QByteArray decompressed = qUncompress(QByteArray::fromBase64(text.mid(QSL(COMPRESSED_TEXT_HEADER).size()).toLatin1()));
+
+  if (decompressed.isEmpty()) {
+    qWarning("Failed to decompress text, returning it in its stored form.");
+    return text;
+  }
+  else {
+    return QString::fromUtf8(decompressed);
+  }
+}
+
+bool TextFactory::isTextCompressed(const QString &text) {
+  return text.startsWith(QL1S(COMPRESSED_TEXT_HEADER));
+}
+
+qint64 TextFactory::hashText(const QString &text) {
+  // First 64 bits of SHA-1 are more than enough to tell texts apart.
+  const QByteArray hash = QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1);
+  return qFromBigEndian<qint64>(reinterpret_cast<const uchar*>(hash.constData()));
+}
+
 QString TextFactory::shorten(const QString &input, int text_length_limit) {
   if (input.size() > text_length_limit) {
     return input.left(text_length_limit - ELLIPSIS_LENGTH) + QString(ELLIPSIS_LENGTH, QL1C('.'));
@@ -50,6 +50,21 @@ class TextFactory {
     static QString encrypt(const QString &text);
     static QString decrypt(const QString &text);
 
+    // Compresses given text with zlib and returns it in textual form
+    // prefixed with COMPRESSED_TEXT_HEADER. Input text is returned
+    // unchanged if compression does not make it shorter.
+    static QString compressText(const QString &text);
+
+    // Reverts compressText(). Texts without the header are returned as they are,
+    // so plain and compressed values can be freely mixed.
+    static QString decompressText(const QString &text);
+
+    static bool isTextCompressed(const QString &text);
+
+    // Returns compact 64-bit hash of given text, suitable for
+    // storing in DB and detecting changes of the text.
+    static qint64 hashText(const QString &text);
+
     // Shortens input string according to given length limit.
     static QString shorten(const QString &input, int text_length_limit = TEXT_TITLE_LIMIT);
 
@@ -142,17 +142,15 @@ void Feed::setUrl(const QString &url) {
 }
 
 void Feed::updateCounts(bool including_total_count) {
-  bool is_main_thread = QThread::currentThread() == qApp->thread();
-  QSqlDatabase database = is_main_thread ?
-                            qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings) :
-                            qApp->database()->connection(QSL("feed_upd"), DatabaseFactory::FromSettings);
+  QSqlDatabase database = qApp->database()->threadConnection();
   int account_id = getParentServiceRoot()->accountId();
+  const QPair<int,int> counts = DatabaseQueries::getMessageCountsForFeed(database, customId(), account_id);
   
   if (including_total_count) {
-    setCountOfAllMessages(DatabaseQueries::getMessageCountsForFeed(database, customId(), account_id, true));
+    setCountOfAllMessages(counts.second);
   }
   
-  setCountOfUnreadMessages(DatabaseQueries::getMessageCountsForFeed(database, customId(), account_id, false));
+  setCountOfUnreadMessages(counts.first);
 }
 
 void Feed::run() {
@@ -187,12 +185,12 @@ void Feed::run() {
   emit messagesObtained(msgs, error_during_obtaining);
 }
 
-int Feed::updateMessages(const QList<Message> &messages, bool error_during_obtaining) {
+int Feed::updateMessages(const QList<Message> &messages, bool error_during_obtaining,
+                         QList<int> *inserted_ids, QList<int> *updated_ids) {
   QList<RootItem*> items_to_update;
   int updated_messages = 0;
-  bool is_main_thread = QThread::currentThread() == qApp->thread();
 
-  qDebug("Updating messages in DB. Main thread: '%s'.", qPrintable(is_main_thread ? "true" : "false"));
+  qDebug().nospace() << "Updating messages in DB in thread: \'" << QThread::currentThreadId() << "\'.";
   
   if (!error_during_obtaining) {
     bool anything_updated = false;
@@ -201,10 +199,9 @@ int Feed::updateMessages(const QList<Message> &messages, bool error_during_obtai
     if (!messages.isEmpty()) {
       int custom_id = customId();
       int account_id = getParentServiceRoot()->accountId();
-      QSqlDatabase database = is_main_thread ?
-                                qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings) :
-                                qApp->database()->connection(QSL("feed_upd"), DatabaseFactory::FromSettings);
-      updated_messages = DatabaseQueries::updateMessages(database, messages, custom_id, account_id, url(), &anything_updated, &ok);
+      QSqlDatabase database = qApp->database()->threadConnection();
+      updated_messages = DatabaseQueries::updateMessages(database, messages, custom_id, id(), account_id, url(),
+                                                         &anything_updated, &ok, inserted_ids, updated_ids);
     }
 
     if (ok) {
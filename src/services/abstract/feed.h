@@ -83,7 +83,10 @@ class Feed : public RootItem, public QRunnable {
 
   public slots:
     void updateCounts(bool including_total_count);
-    int updateMessages(const QList<Message> &messages, bool error_during_obtaining);
+    // Stores given messages, IDs of inserted and updated messages
+    // are appended to given lists if they are provided.
+    int updateMessages(const QList<Message> &messages, bool error_during_obtaining,
+                       QList<int> *inserted_ids = nullptr, QList<int> *updated_ids = nullptr);
 
   protected:
     QString getAutoUpdateStatusDescription() const;
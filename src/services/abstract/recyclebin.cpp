@@ -23,8 +23,6 @@
 #include "miscellaneous/databasequeries.h"
 #include "services/abstract/serviceroot.h"
 
-#include <QThread>
-
 
 RecycleBin::RecycleBin(RootItem *parent_item) : RootItem(parent_item), m_totalCount(0),
   m_unreadCount(0), m_contextMenu(QList<QAction*>()) {
@@ -48,15 +46,14 @@ int RecycleBin::countOfAllMessages() const {
 }
 
 void RecycleBin::updateCounts(bool update_total_count) {
-  bool is_main_thread = QThread::currentThread() == qApp->thread();
-  QSqlDatabase database = is_main_thread ?
-                            qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings) :
-                            qApp->database()->connection(QSL("feed_upd"), DatabaseFactory::FromSettings);
+  QSqlDatabase database = qApp->database()->threadConnection();
+
+  const QPair<int,int> counts = DatabaseQueries::getMessageCountsForBin(database, getParentServiceRoot()->accountId());
 
-  m_unreadCount = DatabaseQueries::getMessageCountsForBin(database, getParentServiceRoot()->accountId(), false);
+  m_unreadCount = counts.first;
 
   if (update_total_count) {
-    m_totalCount = DatabaseQueries::getMessageCountsForBin(database, getParentServiceRoot()->accountId(), true);
+    m_totalCount = counts.second;
   }
 }
 
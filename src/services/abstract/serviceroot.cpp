@@ -140,7 +140,7 @@ void ServiceRoot::cleanAllItems() {
 bool ServiceRoot::cleanFeeds(QList<Feed*> items, bool clean_read_only) {
   QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings);
 
-  if (DatabaseQueries::cleanFeeds(database, textualFeedIds(items), clean_read_only, accountId())) {
+  if (DatabaseQueries::cleanFeeds(database, feedIds(items), clean_read_only, accountId())) {
     // Messages are cleared, now inform model about need to reload data.
     QList<RootItem*> itemss;
 
@@ -165,10 +165,10 @@ bool ServiceRoot::cleanFeeds(QList<Feed*> items, bool clean_read_only) {
   }
 }
 
-void ServiceRoot::storeNewFeedTree(RootItem *root) {
+bool ServiceRoot::replaceFeedTree(RootItem *root) {
   QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings);
 
-  if (DatabaseQueries::storeAccountTree(database, root, accountId())) {
+  if (DatabaseQueries::replaceAccountTree(database, root, accountId())) {
     RecycleBin *bin = recycleBin();
 
     if (bin != nullptr && !childItems().contains(bin)) {
@@ -176,6 +176,11 @@ void ServiceRoot::storeNewFeedTree(RootItem *root) {
       appendChild(bin);
       bin->updateCounts(true);
     }
+
+    return true;
+  }
+  else {
+    return false;
   }
 }
 
@@ -227,18 +232,30 @@ void ServiceRoot::syncIn() {
   RootItem *new_tree = obtainNewTreeForSyncIn();
 
   if (new_tree != nullptr) {
-    // Purge old data from SQL and clean all model items.
     requestItemExpandStateSave(this);
 
     QMap<int,QVariant> feed_custom_data = storeCustomFeedsData();
 
-    removeOldFeedTree(false);
-    cleanAllItems();
     restoreCustomFeedsData(feed_custom_data, new_tree->getHashedSubTreeFeeds());
 
-    // Model is clean, now store new tree into DB and
-    // set primary IDs of the items.
-    storeNewFeedTree(new_tree);
+    // Replace old tree in DB with the new one and set primary IDs
+    // of the items. Model is cleaned only if the new tree is stored,
+    // otherwise it keeps the old tree, which is still stored in DB.
+    if (!replaceFeedTree(new_tree)) {
+      qCritical("Storing of new feed tree of account %d failed, keeping the old one.", accountId());
+      qApp->showGuiMessage(tr("Cannot sync in"),
+                           tr("New feeds and categories cannot be stored, old ones are kept."),
+                           QSystemTrayIcon::Critical, qApp->mainFormWidget(), true);
+
+      new_tree->deleteLater();
+
+      setIcon(original_icon);
+      itemChanged(QList<RootItem*>() << this);
+      return;
+    }
+
+    // Old data are purged from SQL, clean all model items.
+    cleanAllItems();
 
     // We have new feed, some feeds were maybe removed,
     // so remove left over messages.
@@ -331,7 +348,7 @@ QStringList ServiceRoot::customIDSOfMessagesForItem(RootItem *item) {
 bool ServiceRoot::markFeedsReadUnread(QList<Feed*> items, RootItem::ReadStatus read) {
   QSqlDatabase database = qApp->database()->connection(metaObject()->className(), DatabaseFactory::FromSettings);
 
-  if (DatabaseQueries::markFeedsReadUnread(database, textualFeedIds(items), accountId(), read)) {
+  if (DatabaseQueries::markFeedsReadUnread(database, feedIds(items), accountId(), read)) {
     QList<RootItem*> itemss;
 
     foreach (Feed *feed, items) {
@@ -348,15 +365,15 @@ bool ServiceRoot::markFeedsReadUnread(QList<Feed*> items, RootItem::ReadStatus r
   }
 }
 
-QStringList ServiceRoot::textualFeedIds(const QList<Feed*> &feeds) const {
-  QStringList stringy_ids;
-  stringy_ids.reserve(feeds.size());
+QStringList ServiceRoot::feedIds(const QList<Feed*> &feeds) const {
+  QStringList ids;
+  ids.reserve(feeds.size());
 
   foreach (const Feed *feed, feeds) {
-    stringy_ids.append(QString("'%1'").arg(QString::number(feed->customId())));
+    ids.append(QString::number(feed->id()));
   }
 
-  return stringy_ids;
+  return ids;
 }
 
 QStringList ServiceRoot::customIDsOfMessages(const QList<ImportanceChange> &changes) {
@@ -393,10 +410,10 @@ bool ServiceRoot::loadMessagesForItem(RootItem *item, MessagesModel *model) {
   }
   else {
     QList<Feed*> children = item->getSubTreeFeeds();
-    QString filter_clause = textualFeedIds(children).join(QSL(", "));
+    QString filter_clause = feedIds(children).join(QSL(", "));
 
-    model->setFilter(QString("Feeds.custom_id IN (%1) AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.account_id = %2").arg(filter_clause,
-                                                                                                                                                  QString::number(accountId())));
+    model->setFilter(QString("Messages.feed_id IN (%1) AND Messages.is_deleted = 0 AND Messages.is_pdeleted = 0 AND Messages.account_id = %2").arg(filter_clause,
+                                                                                                                                                   QString::number(accountId())));
     qDebug("Loading messages from feeds: %s.", qPrintable(filter_clause));
   }
 
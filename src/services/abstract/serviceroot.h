@@ -179,7 +179,11 @@ class ServiceRoot : public RootItem {
     // Removes all messages/categories/feeds which are
     // associated with this account.
     void removeOldFeedTree(bool including_messages);
-    void storeNewFeedTree(RootItem *root);
+
+    // Replaces categories/feeds of this account stored in database
+    // with given tree, all at once in single transaction. Returns false
+    // if the transaction was rolled back and stored tree is unchanged.
+    bool replaceFeedTree(RootItem *root);
     void cleanAllItems();
 
     // Removes messages which do not belong to any
@@ -189,7 +193,9 @@ class ServiceRoot : public RootItem {
     // from another machine and then performs sync-in on this machine.
     void removeLeftOverMessages();
 
-    QStringList textualFeedIds(const QList<Feed*> &feeds) const;
+    // Returns primary keys of given feeds, which are used
+    // to filter messages.
+    QStringList feedIds(const QList<Feed*> &feeds) const;
     QStringList customIDsOfMessages(const QList<ImportanceChange> &changes);
     QStringList customIDsOfMessages(const QList<Message> &messages);
 
@@ -22,6 +22,7 @@
 #include "miscellaneous/application.h"
 #include "miscellaneous/settings.h"
 #include "miscellaneous/textfactory.h"
+#include "miscellaneous/iconfactory.h"
 #include "services/abstract/rootitem.h"
 #include "services/owncloud/owncloudcategory.h"
 #include "services/owncloud/owncloudfeed.h"
@@ -532,9 +533,7 @@ RootItem *OwnCloudGetFeedsCategoriesResponse::feedsCategories(bool obtain_icons)
                                                     QByteArray(), QString(), icon_data,
                                                     QNetworkAccessManager::GetOperation).first == QNetworkReply::NoError) {
           // Icon downloaded, set it up.
-          QPixmap icon_pixmap;
-          icon_pixmap.loadFromData(icon_data);
-          feed->setIcon(QIcon(icon_pixmap));
+          feed->setIcon(qApp->icons()->fromImageData(icon_data));
         }
       }
     }
@@ -190,5 +190,6 @@ StandardCategory::StandardCategory(const QSqlRecord &record) : Category(nullptr)
   setTitle(record.value(CAT_DB_TITLE_INDEX).toString());
   setDescription(record.value(CAT_DB_DESCRIPTION_INDEX).toString());
   setCreationDate(TextFactory::parseDateTime(record.value(CAT_DB_DCREATED_INDEX).value<qint64>()).toLocalTime());
-  setIcon(qApp->icons()->fromByteArray(record.value(CAT_DB_ICON_INDEX).toByteArray()));
+  setIcon(qApp->icons()->fromStoredIcon(record.value(CAT_DB_ICON_INDEX).toByteArray(),
+                                        record.value(CAT_DB_ICON_DATA_INDEX).toByteArray()));
 }
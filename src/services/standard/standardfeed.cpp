@@ -473,7 +473,8 @@ StandardFeed::StandardFeed(const QSqlRecord &record) : Feed(nullptr) {
   setCustomId(id());
   setDescription(QString::fromUtf8(record.value(FDS_DB_DESCRIPTION_INDEX).toByteArray()));
   setCreationDate(TextFactory::parseDateTime(record.value(FDS_DB_DCREATED_INDEX).value<qint64>()).toLocalTime());
-  setIcon(qApp->icons()->fromByteArray(record.value(FDS_DB_ICON_INDEX).toByteArray()));
+  setIcon(qApp->icons()->fromStoredIcon(record.value(FDS_DB_ICON_INDEX).toByteArray(),
+                                        record.value(FDS_DB_ICON_DATA_INDEX).toByteArray()));
   setEncoding(record.value(FDS_DB_ENCODING_INDEX).toString());
   setUrl(record.value(FDS_DB_URL_INDEX).toString());
   setPasswordProtected(record.value(FDS_DB_PROTECTED_INDEX).toBool());
@@ -522,9 +522,7 @@ RootItem *TtRssGetFeedsCategoriesResponse::feedsCategories(bool obtain_icons, QS
                                                           QByteArray(), QString(), icon_data,
                                                           QNetworkAccessManager::GetOperation).first == QNetworkReply::NoError) {
                 // Icon downloaded, set it up.
-                QPixmap icon_pixmap;
-                icon_pixmap.loadFromData(icon_data);
-                feed->setIcon(QIcon(icon_pixmap));
+                feed->setIcon(qApp->icons()->fromImageData(icon_data));
               }
             }
           }